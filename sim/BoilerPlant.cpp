@@ -0,0 +1,83 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "BoilerPlant.h"
+
+// Water specific heat, J/gK
+#define WATER_HEAT_CAPACITY 4.186f
+
+// Integration step, short compared to every time constant in the model
+#define PLANT_STEP_US 10000
+
+Boiler::Boiler(const BoilerParameters &parameters, float initialC):
+    parameters(parameters), elementC(initialC), waterC(initialC), sensorC(initialC) {}
+
+void Boiler::step(float dtS, bool heaterOn, float ambientC, float inflowGramsPerS, float inflowC, float drawnW) {
+    float elementToWaterW = parameters.elementToWaterWK * (elementC - waterC);
+    float lossW = parameters.lossToAmbientWK * (waterC - ambientC);
+    float inflowW = inflowGramsPerS * WATER_HEAT_CAPACITY * (waterC - inflowC);
+
+    elementC += dtS * ((heaterOn ? parameters.heaterPowerW : 0.f) - elementToWaterW) / parameters.elementCapacityJK;
+    waterC += dtS * (elementToWaterW - lossW - inflowW - drawnW) / parameters.waterCapacityJK;
+    sensorC += dtS * (waterC - sensorC) / parameters.sensorTimeConstantS;
+}
+
+BoilerPlant::BoilerPlant(const PlantParameters &parameters, float initialBrewC, float initialServiceC):
+    parameters(parameters),
+    brewBoiler(parameters.brewBoiler, initialBrewC),
+    serviceBoiler(parameters.serviceBoiler, initialServiceC),
+    // The group lags well behind the boiler when heating up, and is only ever a little cooler once in equilibrium
+    groupC(initialBrewC) {}
+
+void BoilerPlant::advanceTo(absolute_time_t t) {
+    while (simulatedUntil < t) {
+        uint64_t stepUs = t - simulatedUntil < PLANT_STEP_US ? t - simulatedUntil : PLANT_STEP_US;
+        float dtS = (float)stepUs / 1e6f;
+
+        float toGroupW = parameters.brewBoilerToGroupWK * (brewBoiler.getWaterTemperature() - groupC);
+        float groupLossW = parameters.groupLossToAmbientWK * (groupC - parameters.ambientC);
+
+        float flow = isBrewing() ? parameters.brewFlowGramsPerS : 0.f;
+        float inletC = parameters.tankC + parameters.heatExchangerEffectiveness * (serviceBoiler.getWaterTemperature() - parameters.tankC);
+        float heatExchangerW = flow * WATER_HEAT_CAPACITY * (inletC - parameters.tankC);
+
+        brewBoiler.step(dtS, outputs.brew_boiler_ssr_on, parameters.ambientC, flow, inletC, toGroupW);
+        serviceBoiler.step(dtS, outputs.service_boiler_ssr_on, parameters.ambientC, 0.f, parameters.ambientC, heatExchangerW);
+        groupC += dtS * (toGroupW - groupLossW) / parameters.groupCapacityJK;
+
+        simulatedUntil += stepUs;
+    }
+}
+
+void BoilerPlant::applyLccPacket(const LccParsedPacket &packet) {
+    outputs = packet;
+}
+
+PlantParameters defaultPlantParameters() {
+    return PlantParameters{
+            .brewBoiler = BoilerParameters{
+                    .heaterPowerW = 1000.f,
+                    .elementCapacityJK = 250.f,
+                    .elementToWaterWK = 25.f,
+                    .waterCapacityJK = 0.8f * 4186.f + 1.5f * 380.f, // 0.8 l of water in a brass boiler
+                    .lossToAmbientWK = 0.4f,
+                    .sensorTimeConstantS = 4.f,
+            },
+            .serviceBoiler = BoilerParameters{
+                    .heaterPowerW = 1400.f,
+                    .elementCapacityJK = 300.f,
+                    .elementToWaterWK = 35.f,
+                    .waterCapacityJK = 1.8f * 4186.f + 2.f * 380.f, // 2.5 l boiler, a bit more than half full
+                    .lossToAmbientWK = 0.8f,
+                    .sensorTimeConstantS = 4.f,
+            },
+            .groupCapacityJK = 4.f * 380.f, // About 4 kg of chromed brass
+            .brewBoilerToGroupWK = 4.f,
+            .groupLossToAmbientWK = 0.9f,
+            .ambientC = 20.f,
+            .brewFlowGramsPerS = 2.f,
+            .tankC = 20.f,
+            .heatExchangerEffectiveness = 0.4f,
+    };
+}
@@ -0,0 +1,90 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_BOILERPLANT_H
+#define SMART_LCC_SIM_BOILERPLANT_H
+
+#include <pico/time.h>
+#include "Controller/Core0/Protocol/lcc_protocol.h"
+
+struct BoilerParameters {
+    float heaterPowerW;
+    // The heating element and the part of the boiler wall around it, which is what makes the response lag
+    float elementCapacityJK;
+    float elementToWaterWK;
+    float waterCapacityJK;
+    float lossToAmbientWK;
+    // The NTC sits in a well on the outside of the boiler
+    float sensorTimeConstantS;
+};
+
+struct PlantParameters {
+    BoilerParameters brewBoiler;
+    BoilerParameters serviceBoiler;
+    // The E61 group is heated by the brew boiler through the thermosiphon, and is a large part of its losses
+    float groupCapacityJK;
+    float brewBoilerToGroupWK;
+    float groupLossToAmbientWK;
+    float ambientC;
+    // Water drawn through the brew boiler while brewing. On a Bianca it comes from the tank through a heat exchanger in
+    // the service boiler, which takes it this far towards the service boiler temperature (0-1).
+    float brewFlowGramsPerS;
+    float tankC;
+    float heatExchangerEffectiveness;
+};
+
+/*
+ * One boiler as three first order nodes: heating element, water and sensor.
+ */
+class Boiler {
+public:
+    Boiler(const BoilerParameters &parameters, float initialC);
+
+    // drawnW is heat taken out of the water by something other than the ambient or inflow, e.g. the group
+    void step(float dtS, bool heaterOn, float ambientC, float inflowGramsPerS, float inflowC, float drawnW);
+
+    [[nodiscard]] inline float getWaterTemperature() const { return waterC; }
+    [[nodiscard]] inline float getSensorTemperature() const { return sensorC; }
+private:
+    BoilerParameters parameters;
+    float elementC;
+    float waterC;
+    float sensorC;
+};
+
+/*
+ * Thermal model of a Bianca: a brew boiler, the group it heats and a service boiler, driven by the relay states of the
+ * last LCC packet.
+ */
+class BoilerPlant {
+public:
+    BoilerPlant(const PlantParameters &parameters, float initialBrewC, float initialServiceC);
+
+    // Integrates up to t with the relay states currently applied
+    void advanceTo(absolute_time_t t);
+
+    void applyLccPacket(const LccParsedPacket &packet);
+    inline void setBrewSwitch(bool on) { brewSwitch = on; }
+
+    [[nodiscard]] inline bool getBrewSwitch() const { return brewSwitch; }
+    [[nodiscard]] inline bool isBrewing() const { return brewSwitch && outputs.pump_on && outputs.water_line_solenoid_open; }
+    [[nodiscard]] inline const LccParsedPacket &getOutputs() const { return outputs; }
+    [[nodiscard]] inline const Boiler &getBrewBoiler() const { return brewBoiler; }
+    [[nodiscard]] inline const Boiler &getServiceBoiler() const { return serviceBoiler; }
+    [[nodiscard]] inline float getGroupTemperature() const { return groupC; }
+private:
+    PlantParameters parameters;
+    Boiler brewBoiler;
+    Boiler serviceBoiler;
+    float groupC;
+
+    absolute_time_t simulatedUntil = nil_time;
+    LccParsedPacket outputs{};
+    bool brewSwitch = false;
+};
+
+// Roughly a Bianca V2 at 230 V
+PlantParameters defaultPlantParameters();
+
+#endif //SMART_LCC_SIM_BOILERPLANT_H
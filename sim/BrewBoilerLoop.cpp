@@ -0,0 +1,93 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "BrewBoilerLoop.h"
+#include <cmath>
+#include "hal/SimHal.h"
+#include "VirtualControlBoard.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "Controller/Core0/Util/HybridController.h"
+#include "Controller/Core0/Util/SsrSlotPlanner.h"
+#include "Controller/Core0/Util/BrewFeedForward.h"
+#include "utils/MovingAverage.h"
+
+#define CONTROL_PERIOD_US 100000
+
+BrewBoilerRun runBrewBoiler(const BrewBoilerScenario &scenario, const PidSettings &pidSettings) {
+    sim::resetHal();
+
+    BoilerPlant plant(scenario.plant, scenario.initialC, scenario.plant.ambientC);
+    HybridController controller(scenario.setPointC, 20.0f, pidSettings, 2.0f, (float)CONTROL_PERIOD_US / 1e6f);
+    MovingAverage<Q16_16, 5> average;
+    SsrSlotPlanner planner(25);
+    BrewFeedForward feedForward(scenario.plant.brewBoiler.heaterPowerW);
+    feedForward.updateSettings(SettingStruct{}.brewFeedForward);
+
+    BrewBoilerRun run{0., 0.f, NAN};
+    bool reachedSetPoint = false;
+    float brewStartedAtS = NAN;
+    float brewStartC = NAN;
+    float brewLowestC = INFINITY;
+    const BrewEvent *currentBrew = nullptr;
+
+    auto end = (absolute_time_t)(scenario.durationS * 1e6f);
+    for (absolute_time_t t = 0; t < end; t += CONTROL_PERIOD_US) {
+        sim::runUntil(t);
+        plant.advanceTo(t);
+
+        float timeS = (float)t / 1e6f;
+        float waterC = plant.getBrewBoiler().getWaterTemperature();
+        float error = waterC - scenario.setPointC;
+
+        run.itae += timeS * std::fabs(error) * ((float)CONTROL_PERIOD_US / 1e6f);
+
+        reachedSetPoint = reachedSetPoint || error >= 0.f;
+        if (reachedSetPoint && error > run.overshootC && std::isnan(brewStartedAtS)) {
+            run.overshootC = error;
+        }
+
+        bool brewing = false;
+        for (const auto &brew: scenario.brews) {
+            if (timeS >= brew.startS && timeS < brew.startS + brew.durationS) {
+                brewing = true;
+                if (currentBrew != &brew) {
+                    currentBrew = &brew;
+                    brewStartedAtS = timeS;
+                    brewStartC = waterC;
+                    brewLowestC = waterC;
+                }
+            }
+        }
+
+        if (currentBrew != nullptr) {
+            if (timeS <= currentBrew->startS + currentBrew->durationS + BREW_DROP_WINDOW_S) {
+                brewLowestC = std::fmin(brewLowestC, waterC);
+                float drop = brewStartC - brewLowestC;
+                run.brewDropC = std::isnan(run.brewDropC) ? drop : std::fmax(run.brewDropC, drop);
+            }
+        }
+
+        plant.setBrewSwitch(brewing);
+
+        // What the firmware gets to see, after the control board's ADC
+        float sensorC = static_cast<float>(high_gain_adc_to_celsius(
+                VirtualControlBoard::highGainAdcFor(plant.getBrewBoiler().getSensorTemperature())));
+        average.addValue(Q16_16(sensorC));
+
+        // Nothing heats the service boiler here, so the inlet water is as cold as it gets
+        Q16_16 serviceC = Q16_16(plant.getServiceBoiler().getSensorTemperature());
+        Q16_16 brewFeedForward = feedForward.update(brewing, brewing, average.average(), serviceC, t);
+
+        uint8_t signal = controller.getControlSignal(static_cast<float>(average.average()), static_cast<float>(brewFeedForward));
+        controller.trackAppliedSignal(signal);
+
+        LccParsedPacket lcc{};
+        lcc.brew_boiler_ssr_on = planner.nextSlot(signal, 0) == BREW_BOILER_SSR_ON;
+        lcc.pump_on = brewing;
+        lcc.water_line_solenoid_open = brewing;
+        plant.applyLccPacket(lcc);
+    }
+
+    return run;
+}
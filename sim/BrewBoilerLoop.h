@@ -0,0 +1,38 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_BREWBOILERLOOP_H
+#define SMART_LCC_SIM_BREWBOILERLOOP_H
+
+#include <vector>
+#include "types.h"
+#include "BoilerPlant.h"
+#include "Simulation.h"
+
+struct BrewBoilerScenario {
+    float durationS;
+    float initialC;
+    float setPointC;
+    std::vector<BrewEvent> brews;
+    PlantParameters plant = defaultPlantParameters();
+};
+
+struct BrewBoilerRun {
+    // Integral of time-weighted absolute error, °C·s²
+    double itae;
+    // Highest temperature above the set point after first reaching it
+    float overshootC;
+    // Largest drop during or shortly after a brew, see BoilerMetrics
+    float brewDropC;
+};
+
+/*
+ * Just the brew boiler half of the Core 0 control path: the NTC quantisation, the moving average, HybridController
+ * with the brew feed forward, and the SSR slot planner, against the brew boiler and group of the plant model.
+ *
+ * Unlike runSimulation() this keeps no global state, so any number of runs can go in parallel on separate threads.
+ */
+BrewBoilerRun runBrewBoiler(const BrewBoilerScenario &scenario, const PidSettings &pidSettings);
+
+#endif //SMART_LCC_SIM_BREWBOILERLOOP_H
@@ -0,0 +1,321 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "Controller/Core0/Util/TemperatureKalmanFilter.h"
+#include "utils/MovingAverage.h"
+
+/*
+ * Replays recorded brew boiler readings through the brew temperature Kalman filter, next to the five sample moving
+ * average the controller uses when the filter is off.
+ *
+ * The input is a CSV with a header row and at least time_s, brew_high_gain_adc, brew_low_gain_adc and brew_ssr columns,
+ * one row per control cycle, e.g. a trace written by smart_lcc_sim --trace-dir. Both the fixed point filter and its
+ * double precision reference are run with the default TemperatureFilterSettings.
+ *
+ * If there is a brew_sensor_c column, it's taken as the truth, and each estimate's RMS error, its lag (the shift that
+ * fits the truth best) and what's left at that lag, and the RMS error of the rates are printed. The moving average's
+ * rate is its difference over one second. The simulated board has no noise, so --noise adds some, in ADC counts RMS,
+ * to both channels.
+ *
+ * Usage: smart_lcc_filter_replay <trace.csv> [options]
+ *   --noise counts   (default 0)
+ *   --seed n         (default 1)
+ *   --skip s         seconds at the start left out of the statistics (default 10)
+ *   --csv path       also writes the estimates per cycle
+ */
+
+#define REPLAY_MAX_LAG_CYCLES 100
+#define REPLAY_RATE_SPAN_CYCLES 10
+
+struct Row {
+    float timeS;
+    uint16_t highGainAdc;
+    uint16_t lowGainAdc;
+    bool brewSsr;
+    float truthC;
+};
+
+struct Estimates {
+    std::vector<double> averageC;
+    std::vector<double> averageRate;
+    std::vector<double> filterC;
+    std::vector<double> filterRate;
+    std::vector<double> referenceC;
+    std::vector<double> referenceRate;
+};
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s <trace.csv> [--noise counts] [--seed n] [--skip s] [--csv path]\n", name);
+}
+
+static std::vector<std::string> split(const std::string &line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t comma = line.find(',', start);
+        fields.push_back(line.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        if (comma == std::string::npos) {
+            return fields;
+        }
+        start = comma + 1;
+    }
+}
+
+static int columnOf(const std::vector<std::string> &header, const char *name) {
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+static bool readTrace(const char *path, std::vector<Row> *rows, bool *hasTruth) {
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        perror(path);
+        return false;
+    }
+
+    std::vector<std::string> lines;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+        std::string line(buffer);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    fclose(file);
+
+    if (lines.empty()) {
+        fprintf(stderr, "%s is empty\n", path);
+        return false;
+    }
+
+    auto header = split(lines[0]);
+    int time = columnOf(header, "time_s");
+    int highGain = columnOf(header, "brew_high_gain_adc");
+    int lowGain = columnOf(header, "brew_low_gain_adc");
+    int ssr = columnOf(header, "brew_ssr");
+    int truth = columnOf(header, "brew_sensor_c");
+
+    if (time < 0 || highGain < 0 || lowGain < 0 || ssr < 0) {
+        fprintf(stderr, "%s needs time_s, brew_high_gain_adc, brew_low_gain_adc and brew_ssr columns\n", path);
+        return false;
+    }
+
+    *hasTruth = truth >= 0;
+
+    for (size_t i = 1; i < lines.size(); i++) {
+        auto fields = split(lines[i]);
+        if (fields.size() < header.size()) {
+            continue;
+        }
+
+        rows->push_back(Row{
+                .timeS = strtof(fields[time].c_str(), nullptr),
+                .highGainAdc = (uint16_t)atoi(fields[highGain].c_str()),
+                .lowGainAdc = (uint16_t)atoi(fields[lowGain].c_str()),
+                .brewSsr = atoi(fields[ssr].c_str()) != 0,
+                .truthC = truth >= 0 ? strtof(fields[truth].c_str(), nullptr) : NAN,
+        });
+    }
+
+    return !rows->empty();
+}
+
+static uint16_t withNoise(uint16_t adc, std::normal_distribution<double> &noise, std::mt19937 &random) {
+    long noisy = std::lround(adc + noise(random));
+    return (uint16_t)(noisy < 0 ? 0 : noisy > 1023 ? 1023 : noisy);
+}
+
+static Estimates replay(const std::vector<Row> &rows, double noiseCounts, unsigned seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<double> noise(0.0, noiseCounts > 0 ? noiseCounts : 1e-12);
+
+    TemperatureFilterSettings settings = TemperatureFilterSettings{
+            .enabled = true,
+            .heaterRateCPerS = 0.25f,
+            .heaterLagS = 12.f,
+            .rateNoise = 0.02f,
+            .measurementNoiseC = 0.03f,
+    };
+
+    MovingAverage<Q16_16, 5> average;
+    TemperatureKalmanFilter filter;
+    DoubleTemperatureKalmanFilter reference;
+    filter.configure(settings);
+    reference.configure(settings);
+
+    Estimates estimates;
+    float lastTimeS = rows[0].timeS;
+
+    for (const auto &row: rows) {
+        uint16_t highGainAdc = noiseCounts > 0 ? withNoise(row.highGainAdc, noise, random) : row.highGainAdc;
+        uint16_t lowGainAdc = noiseCounts > 0 ? withNoise(row.lowGainAdc, noise, random) : row.lowGainAdc;
+        float dT = row.timeS - lastTimeS;
+        lastTimeS = row.timeS;
+
+        Q16_16 highGainC = high_gain_adc_to_celsius(highGainAdc);
+        Q16_16 highGainResolution = high_gain_adc_resolution(highGainAdc);
+        Q16_16 lowGainC = low_gain_adc_to_celsius(lowGainAdc);
+        Q16_16 lowGainResolution = low_gain_adc_resolution(lowGainAdc);
+
+        average.addValue(highGainC);
+        filter.update(highGainC, highGainResolution, lowGainC, lowGainResolution, row.brewSsr, Q16_16(dT));
+        reference.update((double)highGainC, (double)highGainResolution, (double)lowGainC, (double)lowGainResolution,
+                         row.brewSsr, dT);
+
+        estimates.averageC.push_back((double)average.average());
+        estimates.filterC.push_back((double)filter.getTemperature());
+        estimates.filterRate.push_back((double)filter.getRate());
+        estimates.referenceC.push_back(reference.getTemperature());
+        estimates.referenceRate.push_back(reference.getRate());
+
+        size_t i = estimates.averageC.size() - 1;
+        estimates.averageRate.push_back(i >= REPLAY_RATE_SPAN_CYCLES
+                ? (estimates.averageC[i] - estimates.averageC[i - REPLAY_RATE_SPAN_CYCLES]) / (row.timeS - rows[i - REPLAY_RATE_SPAN_CYCLES].timeS)
+                : 0.0);
+    }
+
+    return estimates;
+}
+
+// RMS of estimate[i] - truth[i - shift] over the rows from first on
+static double rmsError(const std::vector<double> &estimate, const std::vector<double> &truth, size_t first, size_t shift) {
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = first > shift ? first : shift; i < estimate.size(); i++) {
+        double error = estimate[i] - truth[i - shift];
+        sum += error * error;
+        count++;
+    }
+
+    return count > 0 ? std::sqrt(sum / (double)count) : NAN;
+}
+
+static void printTemperature(const char *name, const std::vector<double> &estimate, const std::vector<double> &truth,
+                             size_t first, float cycleS) {
+    size_t bestShift = 0;
+    double bestError = INFINITY;
+    for (size_t shift = 0; shift <= REPLAY_MAX_LAG_CYCLES; shift++) {
+        double error = rmsError(estimate, truth, first, shift);
+        if (error < bestError) {
+            bestError = error;
+            bestShift = shift;
+        }
+    }
+
+    printf("%-16s %8.3f %8.1f %10.3f", name, rmsError(estimate, truth, first, 0), (float)bestShift * cycleS, bestError);
+}
+
+int main(int argc, char **argv) {
+    const char *tracePath = nullptr;
+    const char *csvPath = nullptr;
+    double noiseCounts = 0;
+    unsigned seed = 1;
+    float skipS = 10.f;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        bool ok = true;
+
+        if (hasValue && strcmp(argv[i], "--noise") == 0) {
+            noiseCounts = strtod(argv[++i], nullptr);
+        } else if (hasValue && strcmp(argv[i], "--seed") == 0) {
+            seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (hasValue && strcmp(argv[i], "--skip") == 0) {
+            skipS = strtof(argv[++i], nullptr);
+        } else if (hasValue && strcmp(argv[i], "--csv") == 0) {
+            csvPath = argv[++i];
+        } else if (argv[i][0] != '-' && tracePath == nullptr) {
+            tracePath = argv[i];
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (tracePath == nullptr) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Row> rows;
+    bool hasTruth = false;
+    if (!readTrace(tracePath, &rows, &hasTruth)) {
+        return 1;
+    }
+
+    Estimates estimates = replay(rows, noiseCounts, seed);
+
+    double fixedPointError = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        fixedPointError = std::fmax(fixedPointError, std::fabs(estimates.filterC[i] - estimates.referenceC[i]));
+    }
+
+    float cycleS = rows.size() > 1 ? (rows.back().timeS - rows.front().timeS) / (float)(rows.size() - 1) : 0.f;
+    printf("%zu cycles of %.2f s, %.1f counts of noise\n", rows.size(), cycleS, noiseCounts);
+
+    if (hasTruth) {
+        size_t first = 0;
+        while (first < rows.size() && rows[first].timeS - rows[0].timeS < skipS) {
+            first++;
+        }
+
+        std::vector<double> truthC;
+        std::vector<double> truthRate;
+        for (size_t i = 0; i < rows.size(); i++) {
+            truthC.push_back(rows[i].truthC);
+
+            size_t from = i >= REPLAY_RATE_SPAN_CYCLES / 2 ? i - REPLAY_RATE_SPAN_CYCLES / 2 : 0;
+            size_t to = std::min(i + REPLAY_RATE_SPAN_CYCLES / 2, rows.size() - 1);
+            truthRate.push_back(to > from ? (rows[to].truthC - rows[from].truthC) / (rows[to].timeS - rows[from].timeS) : 0.0);
+        }
+
+        printf("%-16s %8s %8s %10s %10s\n", "", "rms °C", "lag s", "at lag °C", "rate °C/s");
+        printTemperature("moving average", estimates.averageC, truthC, first, cycleS);
+        printf(" %10.4f\n", rmsError(estimates.averageRate, truthRate, first, 0));
+        printTemperature("kalman q16.16", estimates.filterC, truthC, first, cycleS);
+        printf(" %10.4f\n", rmsError(estimates.filterRate, truthRate, first, 0));
+        printTemperature("kalman double", estimates.referenceC, truthC, first, cycleS);
+        printf(" %10.4f\n", rmsError(estimates.referenceRate, truthRate, first, 0));
+    }
+
+    printf("Largest difference between the fixed point filter and the reference: %.4f °C\n", fixedPointError);
+
+    if (csvPath != nullptr) {
+        FILE *file = fopen(csvPath, "w");
+        if (file == nullptr) {
+            perror(csvPath);
+            return 1;
+        }
+
+        fprintf(file, "time_s,truth_c,average_c,average_rate,filter_c,filter_rate,reference_c,reference_rate\n");
+        for (size_t i = 0; i < rows.size(); i++) {
+            fprintf(file, "%.1f,%.3f,%.3f,%.4f,%.3f,%.4f,%.3f,%.4f\n", rows[i].timeS, rows[i].truthC,
+                    estimates.averageC[i], estimates.averageRate[i], estimates.filterC[i], estimates.filterRate[i],
+                    estimates.referenceC[i], estimates.referenceRate[i]);
+        }
+
+        fclose(file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_LEGACYCONTROLBOARDPROTOCOL_H
+#define SMART_LCC_SIM_LEGACYCONTROLBOARDPROTOCOL_H
+
+#include <cmath>
+#include <cstdint>
+#include "Controller/Core0/Protocol/control_board_protocol.h"
+#include "utils/checksum.h"
+#include "utils/triplet.h"
+
+/*
+ * The control board packet decoding as the firmware had it before the NTC tables in ntc_table.h and
+ * decode_control_board_packet, verbatim, with its float and integer truncations. Only the host tests and benchmarks
+ * use it, as the reference the new decoding replaces.
+ */
+namespace legacy {
+    inline uint32_t high_gain_adc_to_ohm(float floatValue) {
+        return 7181.23*pow(-(floatValue-1018.15)/(floatValue-1.56789),(8000.f/8043.f));
+    }
+
+    inline float ntc_ohm_to_celsius(uint32_t ohm, uint32_t r25, uint32_t b) {
+        return (1.f/(log(((float)ohm)/((float)r25))/((float)b)+(1.f/298.15)))-273.15;
+    }
+
+    struct ControlBoardParsedPacket {
+        bool brew_switch;
+        bool water_tank_empty;
+        bool service_boiler_low;
+        float brew_boiler_temperature;
+        float service_boiler_temperature;
+    };
+
+    inline uint16_t validate_raw_packet(ControlBoardRawPacket packet) {
+        uint16_t error = CONTROL_BOARD_VALIDATION_ERROR_NONE;
+
+        if (packet.header != 0x81) {
+            error |= CONTROL_BOARD_VALIDATION_ERROR_INVALID_HEADER;
+        }
+
+        uint8_t calculated_checksum = calculate_checksum(((uint8_t *) &packet + 1), sizeof(packet) - 2, 0x01);
+        if (calculated_checksum != packet.checksum) {
+            error |= CONTROL_BOARD_VALIDATION_ERROR_INVALID_CHECKSUM;
+        }
+
+        if (packet.flags & 0xBD) {
+            error |= CONTROL_BOARD_VALIDATION_ERROR_UNEXPECTED_FLAGS;
+        }
+
+        auto brew_boiler_temp = ntc_ohm_to_celsius(high_gain_adc_to_ohm(triplet_to_int(packet.brew_boiler_temperature_high_gain)), 50000, 4000);
+        auto service_boiler_temp = ntc_ohm_to_celsius(high_gain_adc_to_ohm(triplet_to_int(packet.service_boiler_temperature_high_gain)), 50000, 4000);
+
+        if (brew_boiler_temp > 140) {
+            error |= CONTROL_BOARD_VALIDATION_ERROR_BREW_BOILER_TEMP_DANGEROUSLY_HIGH;
+        }
+
+        if (service_boiler_temp > 150) {
+            error |= CONTROL_BOARD_VALIDATION_ERROR_SERVICE_BOILER_TEMP_DANGEROUSLY_HIGH;
+        }
+
+        return error;
+    }
+
+    inline ControlBoardParsedPacket convert_raw_control_board_packet(ControlBoardRawPacket raw_packet) {
+        ControlBoardParsedPacket packet = ControlBoardParsedPacket();
+
+        packet.brew_switch = raw_packet.flags & 0x02;
+        packet.water_tank_empty = raw_packet.flags & 0x40;
+        packet.service_boiler_low = triplet_to_int(raw_packet.service_boiler_level) > 256;
+
+        auto bbInt = triplet_to_int(raw_packet.brew_boiler_temperature_high_gain);
+        auto bbOhm = high_gain_adc_to_ohm(bbInt);
+        auto bbC = ntc_ohm_to_celsius(bbOhm, 50000, 4018);
+
+        auto sbInt = triplet_to_int(raw_packet.service_boiler_temperature_high_gain);
+        auto sbOhm = high_gain_adc_to_ohm(sbInt);
+        auto sbC = ntc_ohm_to_celsius(sbOhm, 50000, 4018);
+
+        packet.brew_boiler_temperature = bbC;
+        packet.service_boiler_temperature = sbC;
+
+        return packet;
+    }
+}
+
+#endif //SMART_LCC_SIM_LEGACYCONTROLBOARDPROTOCOL_H
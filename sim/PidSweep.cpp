@@ -0,0 +1,185 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "BrewBoilerLoop.h"
+
+/*
+ * Grid search for brew boiler PID parameters.
+ *
+ * Every combination of Kp, Ki, Kd and (symmetric) windup limit is run against the same brew boiler scenario: a warm
+ * start below the set point, followed by a couple of brews. Runs are spread over a pool of worker threads, one per
+ * host core by default.
+ *
+ * Candidates are ranked by ITAE, except that ones overshooting by more than the overshoot limit always rank below the
+ * ones that don't. The best one is printed as PidSettings, and every candidate is written to the CSV.
+ *
+ * Usage: smart_lcc_pid_sweep [options]
+ *   --kp from:to:steps   (default 0.2:2.0:10)
+ *   --ki from:to:steps   (default 0.0:0.3:7)
+ *   --kd from:to:steps   (default 0:20:6)
+ *   --windup from:to:steps (default 2:10:5)
+ *   --max-overshoot °C   (default 1.0)
+ *   --threads n          (default: number of host cores)
+ *   --csv path           (default pid_sweep.csv)
+ */
+
+struct Range {
+    float from;
+    float to;
+    int steps;
+
+    [[nodiscard]] float at(int i) const {
+        return steps <= 1 ? from : from + (to - from) * (float)i / (float)(steps - 1);
+    }
+};
+
+struct Candidate {
+    PidSettings settings;
+    BrewBoilerRun run;
+};
+
+static bool parseRange(const char *text, Range *range) {
+    return sscanf(text, "%f:%f:%d", &range->from, &range->to, &range->steps) == 3 && range->steps > 0;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--kp a:b:n] [--ki a:b:n] [--kd a:b:n] [--windup a:b:n] [--max-overshoot c] "
+                    "[--threads n] [--csv path]\n", name);
+}
+
+int main(int argc, char **argv) {
+    Range kp{0.2f, 2.0f, 10};
+    Range ki{0.0f, 0.3f, 7};
+    Range kd{0.f, 20.f, 6};
+    Range windup{2.f, 10.f, 5};
+    float maxOvershootC = 1.0f;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const char *csvPath = "pid_sweep.csv";
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+
+        if (hasValue && strcmp(argv[i], "--kp") == 0) {
+            ok = parseRange(argv[++i], &kp);
+        } else if (hasValue && strcmp(argv[i], "--ki") == 0) {
+            ok = parseRange(argv[++i], &ki);
+        } else if (hasValue && strcmp(argv[i], "--kd") == 0) {
+            ok = parseRange(argv[++i], &kd);
+        } else if (hasValue && strcmp(argv[i], "--windup") == 0) {
+            ok = parseRange(argv[++i], &windup);
+        } else if (hasValue && strcmp(argv[i], "--max-overshoot") == 0) {
+            maxOvershootC = strtof(argv[++i], nullptr);
+        } else if (hasValue && strcmp(argv[i], "--threads") == 0) {
+            threadCount = std::max(1, atoi(argv[++i]));
+        } else if (hasValue && strcmp(argv[i], "--csv") == 0) {
+            csvPath = argv[++i];
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    BrewBoilerScenario scenario{
+            .durationS = 20 * 60,
+            .initialC = 80.f,
+            .setPointC = SettingStruct{}.brewTemperatureTarget,
+            .brews = {{12 * 60, 30}, {15 * 60, 30}},
+    };
+
+    // Only the gains and windup limits are swept
+    const PidSettings defaults = SettingStruct{}.brewPidParameters;
+
+    std::vector<Candidate> candidates;
+    for (int a = 0; a < kp.steps; a++) {
+        for (int b = 0; b < ki.steps; b++) {
+            for (int c = 0; c < kd.steps; c++) {
+                for (int d = 0; d < windup.steps; d++) {
+                    candidates.push_back(Candidate{
+                            .settings = PidSettings{
+                                    .Kp = kp.at(a),
+                                    .Ki = ki.at(b),
+                                    .Kd = kd.at(c),
+                                    .windupLow = -windup.at(d),
+                                    .windupHigh = windup.at(d),
+                                    .setPointWeight = defaults.setPointWeight,
+                                    .derivativeFilterS = defaults.derivativeFilterS,
+                                    .setPointRampCPerS = defaults.setPointRampCPerS,
+                            },
+                            .run = {},
+                    });
+                }
+            }
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back([&]() {
+            size_t index;
+            while ((index = next.fetch_add(1)) < candidates.size()) {
+                candidates[index].run = runBrewBoiler(scenario, candidates[index].settings);
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [maxOvershootC](const Candidate &a, const Candidate &b) {
+        bool aOver = a.run.overshootC > maxOvershootC;
+        bool bOver = b.run.overshootC > maxOvershootC;
+        if (aOver != bOver) {
+            return bOver;
+        }
+        if (a.run.itae != b.run.itae) {
+            return a.run.itae < b.run.itae;
+        }
+        return a.run.overshootC < b.run.overshootC;
+    });
+
+    FILE *csv = fopen(csvPath, "w");
+    if (csv == nullptr) {
+        perror(csvPath);
+        return 1;
+    }
+
+    fprintf(csv, "rank,kp,ki,kd,windup,itae,overshoot_c,brew_drop_c\n");
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const Candidate &candidate = candidates[i];
+        fprintf(csv, "%zu,%.4f,%.4f,%.4f,%.4f,%.1f,%.3f,%.3f\n", i + 1,
+                candidate.settings.Kp, candidate.settings.Ki, candidate.settings.Kd, candidate.settings.windupHigh,
+                candidate.run.itae, candidate.run.overshootC, candidate.run.brewDropC);
+    }
+    fclose(csv);
+
+    printf("Ran %zu candidates on %u threads, results in %s\n\n", candidates.size(), threadCount, csvPath);
+
+    printf("%4s %8s %8s %8s %8s %12s %8s %8s\n", "rank", "Kp", "Ki", "Kd", "windup", "ITAE", "over C", "drop C");
+    for (size_t i = 0; i < std::min<size_t>(10, candidates.size()); i++) {
+        const Candidate &candidate = candidates[i];
+        printf("%4zu %8.3f %8.3f %8.3f %8.3f %12.1f %8.3f %8.3f\n", i + 1,
+               candidate.settings.Kp, candidate.settings.Ki, candidate.settings.Kd, candidate.settings.windupHigh,
+               candidate.run.itae, candidate.run.overshootC, candidate.run.brewDropC);
+    }
+
+    const PidSettings &best = candidates.front().settings;
+    printf("\nPidSettings{.Kp = %g, .Ki = %g, .Kd = %g, .windupLow = %g, .windupHigh = %g}\n",
+           best.Kp, best.Ki, best.Kd, best.windupLow, best.windupHigh);
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <array>
+#include "SimSettingsFlash.h"
+
+/*
+ * Stands in for src/Controller/Core1/SettingsFlash.cpp. Behaves like NOR flash as far as SettingsManager can tell:
+ * erasing sets a sector to all ones, and programming can only clear bits.
+ */
+
+static std::array<uint8_t, SETTINGS_FLASH_SECTOR_SIZE> sector = [] {
+    std::array<uint8_t, SETTINGS_FLASH_SECTOR_SIZE> erased{};
+    erased.fill(0xFF);
+    return erased;
+}();
+
+namespace sim {
+    uint8_t *settingsFlashSector() {
+        return sector.data();
+    }
+
+    void eraseSettingsFlash() {
+        sector.fill(0xFF);
+    }
+}
+
+SettingsFlash::SettingsFlash(spi_inst_t *spi, uint csPin): _spi(spi), _csPin(csPin) {}
+
+void SettingsFlash::read(uint32_t addr, uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = addr + i < sector.size() ? sector[addr + i] : 0xFF;
+    }
+}
+
+void SettingsFlash::write_enable() {}
+
+void SettingsFlash::wait_done() {}
+
+void SettingsFlash::sector_erase(uint32_t addr) {
+    if (addr < sector.size()) {
+        sim::eraseSettingsFlash();
+    }
+}
+
+void SettingsFlash::page_program(uint32_t addr, uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len && addr + i < sector.size(); i++) {
+        sector[addr + i] &= buf[i];
+    }
+}
+
+uint8_t SettingsFlash::get_manufacturer_id() {
+    return 0xEF;
+}
+
+uint16_t SettingsFlash::get_device_id() {
+    return 0x4015;
+}
+
+bool SettingsFlash::is_present() {
+    return true;
+}
@@ -0,0 +1,23 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_SIMSETTINGSFLASH_H
+#define SMART_LCC_SIM_SIMSETTINGSFLASH_H
+
+#include <cstdint>
+#include "Controller/Core1/SettingsFlash.h"
+
+/*
+ * The simulator's SettingsFlash (see SimSettingsFlash.cpp) keeps one sector in memory, shared by every SettingsFlash
+ * instance, so tests can look at what SettingsManager wrote or put a page of their own there before it reads.
+ */
+namespace sim {
+    // SETTINGS_FLASH_SECTOR_SIZE bytes, starting at address 0
+    uint8_t *settingsFlashSector();
+
+    // Back to all ones, as after a sector erase
+    void eraseSettingsFlash();
+}
+
+#endif //SMART_LCC_SIM_SIMSETTINGSFLASH_H
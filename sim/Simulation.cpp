@@ -0,0 +1,267 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "Simulation.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include "hal/SimHal.h"
+#include "VirtualControlBoard.h"
+#include "SimSettingsFlash.h"
+#include "Controller/Core0/SystemController.h"
+#include "Controller/Core1/SettingsManager.h"
+
+// Time between the end of an LCC packet and the start of the reply, measured on a V2 control board
+#define CONTROL_BOARD_RESPONSE_DELAY_US 5000
+
+static bool brewScheduledAt(const Scenario &scenario, float timeS) {
+    for (const auto &brew: scenario.brews) {
+        if (timeS >= brew.startS && timeS < brew.startS + brew.durationS) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static nonstd::optional<float> thermocoupleAt(const Scenario &scenario, const BoilerPlant &plant, float timeS) {
+    if (!scenario.groupThermocouple) {
+        return nonstd::nullopt;
+    }
+
+    for (const auto &dropout: scenario.thermocoupleDropouts) {
+        if (timeS >= dropout.fromS && timeS < dropout.toS) {
+            return nonstd::nullopt;
+        }
+    }
+
+    return plant.getGroupTemperature();
+}
+
+typedef float TraceSample::*TraceTemperature;
+
+static BoilerMetrics measure(const Scenario &scenario, const std::vector<TraceSample> &trace, TraceTemperature temperature,
+                             float setPoint, float band) {
+    BoilerMetrics metrics{NAN, NAN, NAN, NAN, NAN, 0.};
+
+    if (trace.empty()) {
+        return metrics;
+    }
+
+    float firstBrewS = scenario.brews.empty() ? scenario.durationS : scenario.brews.front().startS;
+
+    // Settling, overshoot and ripple only look at the time before the first brew
+    size_t end = 0;
+    while (end < trace.size() && trace[end].timeS < firstBrewS) {
+        end++;
+    }
+
+    if (end > 0) {
+        bool inBand = false;
+        float enteredBandAt = 0;
+        for (size_t i = 0; i < end; i++) {
+            bool within = std::fabs(trace[i].*temperature - setPoint) <= band;
+            if (within && !inBand) {
+                enteredBandAt = trace[i].timeS;
+            }
+            inBand = within;
+        }
+        if (inBand) {
+            metrics.settlingTimeS = enteredBandAt;
+        }
+
+        bool reached = false;
+        for (size_t i = 0; i < end; i++) {
+            // Count from when the controller first gets the temperature into the band below the set point. Coming
+            // down from above, as after the deliberate overshoot of the heat up routine, only counts once it is at the
+            // set point, otherwise the edge of the band would show up as overshoot.
+            float over = trace[i].*temperature - setPoint;
+            reached = reached || (trace[i].runState == RUN_STATE_NORMAL && over <= 0.f && over >= -band);
+            if (reached) {
+                metrics.overshootC = std::isnan(metrics.overshootC) ? std::fmax(over, 0.f) : std::fmax(metrics.overshootC, over);
+            }
+        }
+
+        float low = INFINITY;
+        float high = -INFINITY;
+        for (size_t i = 0; i < end; i++) {
+            if (trace[i].timeS >= firstBrewS - RIPPLE_WINDOW_S) {
+                low = std::fmin(low, trace[i].*temperature);
+                high = std::fmax(high, trace[i].*temperature);
+            }
+        }
+        metrics.rippleC = high - low;
+
+        for (size_t i = 1; i < end; i++) {
+            float dT = trace[i].timeS - trace[i - 1].timeS;
+            metrics.itae += trace[i].timeS * std::fabs(trace[i].*temperature - setPoint) * dT;
+        }
+    }
+
+    for (const auto &brew: scenario.brews) {
+        float startC = NAN;
+        float lowest = INFINITY;
+
+        for (const auto &sample: trace) {
+            if (sample.timeS < brew.startS) {
+                continue;
+            } else if (sample.timeS > brew.startS + brew.durationS + BREW_DROP_WINDOW_S) {
+                break;
+            }
+
+            if (std::isnan(startC)) {
+                startC = sample.*temperature;
+            }
+            lowest = std::fmin(lowest, sample.*temperature);
+        }
+
+        if (!std::isnan(startC)) {
+            float drop = startC - lowest;
+            metrics.brewDropC = std::isnan(metrics.brewDropC) ? drop : std::fmax(metrics.brewDropC, drop);
+        }
+    }
+
+    for (size_t b = 0; b < scenario.brews.size(); b++) {
+        float fromS = scenario.brews[b].startS + scenario.brews[b].durationS;
+        float toS = fromS + BREW_RECOVERY_WINDOW_S;
+        if (b + 1 < scenario.brews.size() && scenario.brews[b + 1].startS < toS) {
+            toS = scenario.brews[b + 1].startS;
+        }
+
+        for (const auto &sample: trace) {
+            if (sample.timeS < fromS) {
+                continue;
+            } else if (sample.timeS > toS) {
+                break;
+            }
+
+            float over = std::fmax(sample.*temperature - setPoint, 0.f);
+            metrics.recoveryOvershootC = std::isnan(metrics.recoveryOvershootC) ? over : std::fmax(metrics.recoveryOvershootC, over);
+        }
+    }
+
+    return metrics;
+}
+
+// Every setting, the way the ESP sets them one at a time
+static void applySettings(SettingsManager &settingsManager, const SettingStruct &settings) {
+    settingsManager.setBrewTemperatureOffset(settings.brewTemperatureOffset);
+    settingsManager.setSleepMode(settings.sleepMode);
+    settingsManager.setEcoMode(settings.ecoMode);
+    settingsManager.setTargetBrewTemp(settings.brewTemperatureTarget);
+    settingsManager.setTargetServiceTemp(settings.serviceTemperatureTarget);
+    settingsManager.setAutoSleepMin(settings.autoSleepMin);
+    settingsManager.setBrewPidParameters(settings.brewPidParameters);
+    settingsManager.setServicePidParameters(settings.servicePidParameters);
+    settingsManager.setAdaptivePid(settings.adaptivePid);
+    settingsManager.setBrewFeedForward(settings.brewFeedForward);
+    settingsManager.setBrewSmithPredictor(settings.brewSmithPredictor);
+    settingsManager.setBrewPidSchedule(settings.brewPidSchedule);
+    settingsManager.setBrewTemperatureFilter(settings.brewTemperatureFilter);
+    settingsManager.setGroupHeadCascade(settings.groupHeadCascade);
+}
+
+SimulationResult runSimulation(const Scenario &scenario) {
+    auto wallStart = std::chrono::steady_clock::now();
+
+    sim::resetHal();
+
+    uart_inst_t *uart = uart0;
+    uart_init(uart, 9600);
+
+    BoilerPlant plant(scenario.plant, scenario.initialBrewC, scenario.initialServiceC);
+    VirtualControlBoard controlBoard(&plant, CONTROL_BOARD_RESPONSE_DELAY_US);
+    sim::connectUart(uart, &controlBoard);
+
+    auto statusMailbox = std::make_unique<SeqlockMailbox<SystemControllerStatusMessage>>();
+    auto commandChannel = std::make_unique<CommandChannel>();
+    auto settingsMailbox = std::make_unique<SeqlockMailbox<SettingStruct>>();
+
+    sim::eraseSettingsFlash();
+    SettingsFlash settingsFlash(nullptr, 0);
+    SettingsManager settingsManager(settingsMailbox.get(), &settingsFlash);
+    settingsManager.initialize();
+    applySettings(settingsManager, scenario.settings);
+
+    commandChannel->tryPush(SystemControllerCommand{.type = COMMAND_BEGIN});
+
+    auto controller = std::make_unique<SystemController>(uart, statusMailbox.get(), commandChannel.get(), settingsMailbox.get());
+    GroupHeadController groupHeadController(commandChannel.get());
+
+    SimulationResult result{};
+    SystemControllerStatusMessage status{};
+    absolute_time_t end = (absolute_time_t)(scenario.durationS * 1e6f);
+    size_t nextCommand = 0;
+
+    while (get_absolute_time() < end) {
+        float timeS = (float)get_absolute_time() / 1e6f;
+        plant.setBrewSwitch(brewScheduledAt(scenario, timeS));
+
+        while (nextCommand < scenario.commands.size() && scenario.commands[nextCommand].atS <= timeS) {
+            commandChannel->tryPush(scenario.commands[nextCommand++].command);
+        }
+
+        controller->loop();
+        plant.advanceTo(get_absolute_time());
+
+        if (statusMailbox->tryRead(&status)) {
+            settingsManager.applyAutoTuneResult(status.autoTune);
+            settingsManager.adaptPidParameters(status);
+            groupHeadController.update(status, thermocoupleAt(scenario, plant, timeS), settingsManager.getGroupHeadCascade());
+        }
+
+        result.trace.push_back(TraceSample{
+                .timeS = (float)get_absolute_time() / 1e6f,
+                .groupC = plant.getGroupTemperature(),
+                .brewWaterC = plant.getBrewBoiler().getWaterTemperature(),
+                .brewSensorC = plant.getBrewBoiler().getSensorTemperature(),
+                .brewHighGainAdc = VirtualControlBoard::highGainAdcFor(plant.getBrewBoiler().getSensorTemperature()),
+                .brewLowGainAdc = VirtualControlBoard::lowGainAdcFor(plant.getBrewBoiler().getSensorTemperature()),
+                .serviceWaterC = plant.getServiceBoiler().getWaterTemperature(),
+                .serviceSensorC = plant.getServiceBoiler().getSensorTemperature(),
+                .brewSsr = plant.getOutputs().brew_boiler_ssr_on,
+                .serviceSsr = plant.getOutputs().service_boiler_ssr_on,
+                .brewing = plant.isBrewing(),
+                .internalState = status.internalState,
+                .runState = status.runState,
+                .autoTuneState = status.autoTune.state,
+                .brewSetPointCorrectionC = groupHeadController.getSetPointCorrection(),
+                .groupHeadMode = groupHeadController.getMode(),
+        });
+    }
+
+    result.cycles = status.cycleTiming.cycles;
+    result.bails = status.bailCounter;
+    result.status = status;
+    result.brew = measure(scenario, result.trace, &TraceSample::brewWaterC,
+                          scenario.settings.brewTemperatureTarget, SETTLING_BAND_BREW_C);
+    result.service = scenario.settings.ecoMode
+            ? BoilerMetrics{NAN, NAN, NAN, NAN, NAN, NAN}
+            : measure(scenario, result.trace, &TraceSample::serviceWaterC,
+                      scenario.settings.serviceTemperatureTarget, SETTLING_BAND_SERVICE_C);
+
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    return result;
+}
+
+void writeTraceCsv(const std::vector<TraceSample> &trace, const std::string &path) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        perror(path.c_str());
+        return;
+    }
+
+    fprintf(file, "time_s,group_c,brew_water_c,brew_sensor_c,brew_high_gain_adc,brew_low_gain_adc,service_water_c,service_sensor_c,brew_ssr,service_ssr,brewing,internal_state,run_state,autotune_state,brew_set_point_correction_c,group_head_mode\n");
+    for (const auto &sample: trace) {
+        fprintf(file, "%.1f,%.3f,%.3f,%.3f,%u,%u,%.3f,%.3f,%d,%d,%d,%d,%d,%d,%.3f,%d\n",
+                sample.timeS, sample.groupC, sample.brewWaterC, sample.brewSensorC, sample.brewHighGainAdc, sample.brewLowGainAdc,
+                sample.serviceWaterC, sample.serviceSensorC,
+                sample.brewSsr, sample.serviceSsr, sample.brewing, sample.internalState, sample.runState, sample.autoTuneState,
+                sample.brewSetPointCorrectionC, sample.groupHeadMode);
+    }
+
+    fclose(file);
+}
@@ -0,0 +1,109 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_SIMULATION_H
+#define SMART_LCC_SIM_SIMULATION_H
+
+#include <string>
+#include <vector>
+#include "types.h"
+#include "BoilerPlant.h"
+#include "Controller/Core1/GroupHeadController.h"
+
+struct BrewEvent {
+    float startS;
+    float durationS;
+};
+
+// A command to Core 0, as Core 1 would send it
+struct CommandEvent {
+    float atS;
+    SystemControllerCommand command;
+};
+
+// The group thermocouple reading nothing, as when its lead comes off
+struct ThermocoupleDropout {
+    float fromS;
+    float toS;
+};
+
+struct Scenario {
+    std::string name;
+    float durationS;
+    float initialBrewC;
+    float initialServiceC;
+    SettingStruct settings;
+    std::vector<BrewEvent> brews;
+    PlantParameters plant = defaultPlantParameters();
+    std::vector<CommandEvent> commands{};
+    // Whether there is a thermocouple on the group, reading the group temperature, for Core 1's group head control
+    bool groupThermocouple = false;
+    std::vector<ThermocoupleDropout> thermocoupleDropouts{};
+};
+
+// One sample per control cycle
+struct TraceSample {
+    float timeS;
+    float groupC;
+    float brewWaterC;
+    float brewSensorC;
+    // What the control board reports for brewSensorC, so traces can be replayed through the decoding
+    uint16_t brewHighGainAdc;
+    uint16_t brewLowGainAdc;
+    float serviceWaterC;
+    float serviceSensorC;
+    bool brewSsr;
+    bool serviceSsr;
+    bool brewing;
+    SystemControllerInternalState internalState;
+    SystemControllerRunState runState;
+    AutoTuneState autoTuneState;
+    // What Core 1's group head control moves the brew set point by
+    float brewSetPointCorrectionC;
+    GroupHeadControlMode groupHeadMode;
+};
+
+/*
+ * Boiler water temperature (not the sensor) against the set point. NAN where the scenario doesn't allow measuring it,
+ * e.g. brew drop without a brew, or settling time if it never settled.
+ */
+struct BoilerMetrics {
+    // Time from the start of the simulation after which the temperature stays within the band until the first brew
+    float settlingTimeS;
+    // Highest temperature above the set point after first reaching it in normal operation, before the first brew
+    float overshootC;
+    // Peak to peak over the last RIPPLE_WINDOW_S seconds before the first brew
+    float rippleC;
+    // Largest drop from the temperature at the start of a brew to the lowest point during or shortly after it
+    float brewDropC;
+    // Highest temperature above the set point after a brew, until the next one or BREW_RECOVERY_WINDOW_S
+    float recoveryOvershootC;
+    // Integral of time-weighted absolute error until the first brew, °C·s²
+    double itae;
+};
+
+struct SimulationResult {
+    BoilerMetrics brew;
+    BoilerMetrics service;
+    uint32_t cycles;
+    uint16_t bails;
+    double wallSeconds;
+    // The last status message, e.g. for the auto-tune result and the PID settings Core 1 ended up with
+    SystemControllerStatusMessage status;
+    std::vector<TraceSample> trace;
+};
+
+#define SETTLING_BAND_BREW_C 0.5f
+#define SETTLING_BAND_SERVICE_C 1.5f
+#define RIPPLE_WINDOW_S 120.f
+#define BREW_DROP_WINDOW_S 60.f
+#define BREW_RECOVERY_WINDOW_S 300.f
+
+// Runs the real SystemController against the plant in virtual time. Settings go through Core 1's SettingsManager,
+// which also applies auto-tune results and adapts the PID settings the way Core 1 does.
+SimulationResult runSimulation(const Scenario &scenario);
+
+void writeTraceCsv(const std::vector<TraceSample> &trace, const std::string &path);
+
+#endif //SMART_LCC_SIM_SIMULATION_H
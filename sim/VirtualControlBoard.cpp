@@ -0,0 +1,107 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "VirtualControlBoard.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "utils/checksum.h"
+
+// Level probe readings for a full and a low service boiler
+#define SERVICE_BOILER_LEVEL_FULL 90
+
+typedef Q16_16 (*AdcToCelsius)(uint16_t adc);
+
+// Both channels are monotonic in the ADC value, so the inverse is a binary search over what the firmware would decode
+template <AdcToCelsius Decode, uint16_t Min, uint16_t Max> static uint16_t adcFor(float celsius) {
+    static const std::array<float, 1024> decoded = [] {
+        std::array<float, 1024> table{};
+        for (uint16_t adc = 0; adc < 1024; adc++) {
+            table[adc] = static_cast<float>(Decode(adc));
+        }
+        return table;
+    }();
+
+    auto first = decoded.begin() + Min;
+    auto last = decoded.begin() + Max + 1;
+    auto it = std::lower_bound(first, last, celsius);
+
+    if (it == last) {
+        return Max;
+    } else if (it != first && celsius - *(it - 1) < *it - celsius) {
+        --it;
+    }
+
+    return (uint16_t)(it - decoded.begin());
+}
+
+static Q16_16 decodeHighGain(uint16_t adc) { return high_gain_adc_to_celsius(adc); }
+static Q16_16 decodeLowGain(uint16_t adc) { return low_gain_adc_to_celsius(adc); }
+
+uint16_t VirtualControlBoard::highGainAdcFor(float celsius) {
+    return adcFor<decodeHighGain, NTC_ADC_MIN, NTC_ADC_MAX>(celsius);
+}
+
+uint16_t VirtualControlBoard::lowGainAdcFor(float celsius) {
+    return adcFor<decodeLowGain, 0, 1023>(celsius);
+}
+
+VirtualControlBoard::VirtualControlBoard(BoilerPlant *plant, uint32_t responseDelayUs):
+    plant(plant), responseDelayUs(responseDelayUs) {}
+
+void VirtualControlBoard::onReceive(uart_inst_t *uart, const uint8_t *data, size_t length, absolute_time_t at) {
+    for (size_t i = 0; i < length; i++) {
+        // Packets always start with 0x80, anything else before that is noise
+        if (buffered == 0 && data[i] != 0x80) {
+            continue;
+        }
+
+        buffer[buffered++] = data[i];
+
+        if (buffered == sizeof(LccRawPacket)) {
+            LccRawPacket packet;
+            memcpy(&packet, buffer, sizeof(packet));
+            buffered = 0;
+
+            handlePacket(uart, packet, at);
+        }
+    }
+}
+
+void VirtualControlBoard::handlePacket(uart_inst_t *uart, const LccRawPacket &packet, absolute_time_t at) {
+    packetCount++;
+
+    plant->advanceTo(at);
+
+    // Like the real board, an invalid packet is ignored and gets no reply
+    if (validate_lcc_raw_packet(packet) != LCC_VALIDATION_ERROR_NONE) {
+        invalidPacketCount++;
+        return;
+    }
+
+    plant->applyLccPacket(convert_lcc_raw_to_parsed(packet));
+
+    ControlBoardRawPacket reply = encodeState();
+    sim::sendToUart(uart, reinterpret_cast<const uint8_t *>(&reply), sizeof(reply), delayed_by_us(at, responseDelayUs));
+}
+
+ControlBoardRawPacket VirtualControlBoard::encodeState() const {
+    ControlBoardRawPacket packet{};
+    packet.header = 0x81;
+    packet.flags = plant->getBrewSwitch() ? 0x02 : 0x00;
+
+    float brewC = plant->getBrewBoiler().getSensorTemperature();
+    float serviceC = plant->getServiceBoiler().getSensorTemperature();
+
+    packet.brew_boiler_temperature_high_gain = int_to_triplet(highGainAdcFor(brewC));
+    packet.service_boiler_temperature_high_gain = int_to_triplet(highGainAdcFor(serviceC));
+    packet.brew_boiler_temperature_low_gain = int_to_triplet(lowGainAdcFor(brewC));
+    packet.service_boiler_temperature_low_gain = int_to_triplet(lowGainAdcFor(serviceC));
+    packet.service_boiler_level = int_to_triplet(SERVICE_BOILER_LEVEL_FULL);
+
+    packet.checksum = calculate_checksum(reinterpret_cast<const uint8_t *>(&packet) + 1, sizeof(packet) - 2, 0x01);
+
+    return packet;
+}
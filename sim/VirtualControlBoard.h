@@ -0,0 +1,42 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_VIRTUALCONTROLBOARD_H
+#define SMART_LCC_SIM_VIRTUALCONTROLBOARD_H
+
+#include "hal/SimHal.h"
+#include "BoilerPlant.h"
+#include "Controller/Core0/Protocol/control_board_protocol.h"
+
+/*
+ * The Gicar control board as seen from the LCC port: takes LCC packets, applies them to the plant and answers each one
+ * with a ControlBoardRawPacket describing the plant, encoded the way the real board does it.
+ */
+class VirtualControlBoard: public sim::UartDevice {
+public:
+    VirtualControlBoard(BoilerPlant *plant, uint32_t responseDelayUs);
+
+    void onReceive(uart_inst_t *uart, const uint8_t *data, size_t length, absolute_time_t at) override;
+
+    [[nodiscard]] inline uint32_t getPacketCount() const { return packetCount; }
+    [[nodiscard]] inline uint32_t getInvalidPacketCount() const { return invalidPacketCount; }
+
+    // The ADC readings the control board would send for a temperature, i.e. the inverse of the firmware's decoding
+    static uint16_t highGainAdcFor(float celsius);
+    static uint16_t lowGainAdcFor(float celsius);
+private:
+    BoilerPlant *plant;
+    uint32_t responseDelayUs;
+
+    uint8_t buffer[sizeof(LccRawPacket)]{};
+    size_t buffered = 0;
+
+    uint32_t packetCount = 0;
+    uint32_t invalidPacketCount = 0;
+
+    void handlePacket(uart_inst_t *uart, const LccRawPacket &packet, absolute_time_t at);
+    ControlBoardRawPacket encodeState() const;
+};
+
+#endif //SMART_LCC_SIM_VIRTUALCONTROLBOARD_H
@@ -0,0 +1,104 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdlib>
+#include "Bench.h"
+#include "utils/ExponentialMovingAverage.h"
+#include "utils/MovingAverage.h"
+#include "utils/MovingMedian.h"
+
+#define AVERAGE_BENCH_ITERATIONS 20000000
+#define AVERAGE_BENCH_SAMPLES 1024
+
+namespace legacy {
+    // MovingAverage as it was: a calloc'd ring, summed over in double on every average()
+    template <class T> class MovingAverage {
+    public:
+        explicit MovingAverage(uint16_t num): _limit(num) {
+            _array = (T*)calloc(num, sizeof(T));
+        }
+
+        ~MovingAverage() {
+            free(_array);
+        }
+
+        void addValue(T val) {
+            _array[_head++] = val;
+            if (_head >= _limit) {
+                _head = 0;
+                _wrapped = true;
+            }
+        }
+
+        double average() {
+            double sum = 0.f;
+
+            uint16_t limit = _limit;
+            if (!_wrapped) {
+                limit = _head;
+            }
+
+            if (limit == 0) {
+                return 0.f;
+            }
+
+            for (uint16_t i = 0; i < limit; ++i) {
+                sum += (double)_array[i];
+            }
+
+            return sum / limit;
+        }
+    private:
+        uint16_t _limit;
+        uint16_t _head = 0;
+        T* _array;
+        bool _wrapped = false;
+    };
+}
+
+// One sample in and the result out, as the controller does every cycle
+template <class T, class F> static void runFilter(const char *name, F &&addAndRead) {
+    static T samples[AVERAGE_BENCH_SAMPLES];
+    for (int i = 0; i < AVERAGE_BENCH_SAMPLES; i++) {
+        samples[i] = T(105.f + sinf((float)i * 0.1f) + 0.3f * sinf((float)i * 2.1f));
+    }
+
+    uint32_t i = 0;
+    bench::run(name, AVERAGE_BENCH_ITERATIONS, [&]() {
+        bench::keep(addAndRead(samples[i++ % AVERAGE_BENCH_SAMPLES]));
+    });
+}
+
+BENCHMARK(average) {
+    legacy::MovingAverage<float> oldAverage(5);
+    runFilter<float>("MovingAverage<float> (old, calloc)", [&](float value) {
+        oldAverage.addValue(value);
+        return oldAverage.average();
+    });
+
+    MovingAverage<float, 5> floatAverage;
+    runFilter<float>("MovingAverage<float, 5>", [&](float value) {
+        floatAverage.addValue(value);
+        return floatAverage.average();
+    });
+
+    MovingAverage<Q16_16, 5> fixedPointAverage;
+    runFilter<Q16_16>("MovingAverage<Q16_16, 5>", [&](Q16_16 value) {
+        fixedPointAverage.addValue(value);
+        return fixedPointAverage.average();
+    });
+
+    ExponentialMovingAverage<Q16_16, 3> exponentialAverage;
+    runFilter<Q16_16>("ExponentialMovingAverage<Q16_16, 3>", [&](Q16_16 value) {
+        exponentialAverage.addValue(value);
+        return exponentialAverage.average();
+    });
+
+    MovingMedian<Q16_16, 5> median;
+    runFilter<Q16_16>("MovingMedian<Q16_16, 5>", [&](Q16_16 value) {
+        median.addValue(value);
+        return median.median();
+    });
+}
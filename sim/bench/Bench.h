@@ -0,0 +1,68 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_BENCH_BENCH_H
+#define SMART_LCC_SIM_BENCH_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Host micro-benchmarks of the Core 0 building blocks, all in smart_lcc_bench.
+ *
+ * The host has an FPU, a cache and a branch predictor, the M0+ has none of them, so the absolute numbers say little
+ * about the firmware. They're for comparing implementations against each other, and catching regressions.
+ *
+ * Each BENCHMARK runs on its own when its name contains the filter given on the command line, or always without one.
+ */
+namespace bench {
+    typedef void (*BenchmarkFunction)();
+
+    struct Registration {
+        Registration(const char *name, BenchmarkFunction function);
+    };
+
+    // Keeps the compiler from optimising away a result that's otherwise unused
+    template <class T> inline void keep(const T &value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Times `iterations` calls of fn, and prints the time per call and calls per second. The calls are split over a few
+    // rounds, and the fastest one counts, so whatever else the host is doing doesn't.
+    template <class F> double run(const char *name, uint64_t iterations, F &&fn) {
+        const int rounds = 20;
+        uint64_t perRound = iterations / rounds;
+
+        // Warm up
+        for (uint64_t i = 0; i < perRound; i++) {
+            fn();
+        }
+
+        double bestSeconds = 0;
+        for (int round = 0; round < rounds; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < perRound; i++) {
+                fn();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (round == 0 || seconds < bestSeconds) {
+                bestSeconds = seconds;
+            }
+        }
+
+        double nsPerCall = bestSeconds * 1e9 / (double)perRound;
+        printf("  %-44s %10.1f ns %14.0f /s\n", name, nsPerCall, 1e9 / nsPerCall);
+
+        return nsPerCall;
+    }
+}
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static bench::Registration name##Registration(#name, name); \
+    static void name()
+
+#endif //SMART_LCC_SIM_BENCH_BENCH_H
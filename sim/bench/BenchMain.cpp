@@ -0,0 +1,41 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstring>
+#include <vector>
+#include "Bench.h"
+
+/*
+ * Usage: smart_lcc_bench [filter]
+ */
+
+struct Benchmark {
+    const char *name;
+    bench::BenchmarkFunction function;
+};
+
+// Registrations run during static initialisation, in no particular order across files
+static std::vector<Benchmark> &benchmarks() {
+    static std::vector<Benchmark> all;
+    return all;
+}
+
+bench::Registration::Registration(const char *name, BenchmarkFunction function) {
+    benchmarks().push_back(Benchmark{name, function});
+}
+
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+
+    for (const Benchmark &benchmark: benchmarks()) {
+        if (filter != nullptr && strstr(benchmark.name, filter) == nullptr) {
+            continue;
+        }
+
+        printf("%s\n", benchmark.name);
+        benchmark.function();
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "Bench.h"
+#include "CommandChannel.h"
+#include "utils/PicoQueue.h"
+
+#define COMMAND_BENCH_ITERATIONS 5000000
+#define COMMAND_BENCH_BATCH 4
+
+/*
+ * Commands through CommandChannel and the PicoQueue it replaced, pushed and popped on the same thread, so it's the cost
+ * each core pays per command rather than how the two threads happen to get scheduled. The batch is what Core 1
+ * actually sends these days: mostly set point corrections, the odd flow mode change and unbail.
+ */
+static const SystemControllerCommand batch[COMMAND_BENCH_BATCH] = {
+        SystemControllerCommand{.type = COMMAND_SET_BREW_SET_POINT_CORRECTION, .float1 = 0.4f},
+        SystemControllerCommand{.type = COMMAND_SET_FLOW_MODE, .int1 = 1},
+        SystemControllerCommand{.type = COMMAND_UNBAIL},
+        SystemControllerCommand{.type = COMMAND_SET_BREW_SET_POINT_CORRECTION, .float1 = 0.5f},
+};
+
+BENCHMARK(command) {
+    static PicoQueue<SystemControllerCommand> queue(100);
+    SystemControllerCommand received[COMMAND_BENCH_BATCH];
+
+    bench::run("PicoQueue, 4 commands one by one", COMMAND_BENCH_ITERATIONS, [&]() {
+        for (const auto &command: batch) {
+            queue.tryAdd(const_cast<SystemControllerCommand *>(&command));
+        }
+
+        for (auto &command: received) {
+            queue.tryRemove(&command);
+        }
+
+        bench::keep(received);
+    });
+
+    static CommandChannel channel;
+
+    bench::run("CommandChannel, 4 commands one by one", COMMAND_BENCH_ITERATIONS, [&]() {
+        for (const auto &command: batch) {
+            channel.tryPush(command);
+        }
+
+        bench::keep(channel.popBatch(received, COMMAND_BENCH_BATCH));
+        bench::keep(received);
+    });
+
+    bench::run("CommandChannel, 4 commands as a batch", COMMAND_BENCH_ITERATIONS, [&]() {
+        channel.tryPushBatch(batch, COMMAND_BENCH_BATCH);
+
+        bench::keep(channel.popBatch(received, COMMAND_BENCH_BATCH));
+        bench::keep(received);
+    });
+}
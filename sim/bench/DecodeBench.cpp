@@ -0,0 +1,84 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <vector>
+#include "Bench.h"
+#include "LegacyControlBoardProtocol.h"
+
+#define DECODE_BENCH_ITERATIONS 5000000
+
+/*
+ * Control board packets, decoded the old way and by decode_control_board_packet. The old way is
+ * validate_raw_packet and convert_raw_control_board_packet, each with its own pow/log per channel, and the service
+ * boiler triplets unpacked once more for the status message.
+ *
+ * The packets are replayed from bench/data/control_board_packets.csv: the simulated control board's replies through a
+ * brew and the recovery after it, as they went over the UART.
+ */
+
+static std::vector<ControlBoardRawPacket> readPackets(const char *path) {
+    std::vector<ControlBoardRawPacket> packets;
+
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return packets;
+    }
+
+    char line[128];
+    // Header
+    fgets(line, sizeof(line), file);
+
+    float timeS;
+    char hex[2 * sizeof(ControlBoardRawPacket) + 1];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (sscanf(line, "%f,%36s", &timeS, hex) != 2) {
+            continue;
+        }
+
+        ControlBoardRawPacket packet;
+        auto *bytes = reinterpret_cast<uint8_t *>(&packet);
+        bool valid = true;
+        for (size_t i = 0; i < sizeof(packet); i++) {
+            unsigned byte;
+            valid = valid && sscanf(hex + 2 * i, "%2x", &byte) == 1;
+            bytes[i] = (uint8_t)byte;
+        }
+
+        if (valid) {
+            packets.push_back(packet);
+        }
+    }
+
+    fclose(file);
+    return packets;
+}
+
+BENCHMARK(decode) {
+    static std::vector<ControlBoardRawPacket> packets = readPackets(DECODE_BENCH_CAPTURE);
+    if (packets.empty()) {
+        return;
+    }
+
+    uint32_t i = 0;
+
+    bench::run("validate + convert + status triplets (old)", DECODE_BENCH_ITERATIONS, [&]() {
+        const ControlBoardRawPacket &raw = packets[i++ % packets.size()];
+
+        uint16_t validation = legacy::validate_raw_packet(raw);
+        legacy::ControlBoardParsedPacket parsed = legacy::convert_raw_control_board_packet(raw);
+        uint16_t sbLow = triplet_to_int(raw.service_boiler_temperature_low_gain);
+        uint16_t sbHi = triplet_to_int(raw.service_boiler_temperature_high_gain);
+
+        bench::keep(validation);
+        bench::keep(parsed);
+        bench::keep(sbLow);
+        bench::keep(sbHi);
+    });
+
+    bench::run("decode_control_board_packet", DECODE_BENCH_ITERATIONS, [&]() {
+        bench::keep(decode_control_board_packet(packets[i++ % packets.size()]));
+    });
+}
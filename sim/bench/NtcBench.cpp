@@ -0,0 +1,27 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "Bench.h"
+#include "LegacyControlBoardProtocol.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+
+#define NTC_BENCH_ITERATIONS 20000000
+
+/*
+ * One high gain NTC reading to °C, the old pow/log way and from the table. The M0+ has no FPU, so on target the
+ * difference is far larger than here.
+ */
+BENCHMARK(ntc) {
+    uint16_t adc = NTC_ADC_MIN;
+
+    bench::run("pow/log in float (old)", NTC_BENCH_ITERATIONS, [&]() {
+        bench::keep(legacy::ntc_ohm_to_celsius(legacy::high_gain_adc_to_ohm(adc), NTC_R25, NTC_B));
+        adc = adc < NTC_ADC_MAX ? adc + 1 : NTC_ADC_MIN;
+    });
+
+    bench::run("high_gain_adc_to_celsius", NTC_BENCH_ITERATIONS, [&]() {
+        bench::keep(high_gain_adc_to_celsius(adc));
+        adc = adc < NTC_ADC_MAX ? adc + 1 : NTC_ADC_MIN;
+    });
+}
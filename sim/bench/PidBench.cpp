@@ -0,0 +1,47 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include "Bench.h"
+#include "hal/SimHal.h"
+#include "Controller/Core0/Util/PIDController.h"
+
+#define PID_BENCH_ITERATIONS 2000000
+#define PID_BENCH_SAMPLES 1024
+
+// One PID update per 100 ms cycle of virtual time, on a temperature wandering around the set point
+template <class Controller> static void runPid(const char *name) {
+    SettingStruct defaults{};
+    Controller controller(defaults.brewPidParameters, defaults.brewTemperatureTarget);
+
+    float samples[PID_BENCH_SAMPLES];
+    for (int i = 0; i < PID_BENCH_SAMPLES; i++) {
+        samples[i] = defaults.brewTemperatureTarget + 2.f * sinf((float)i * 0.05f) + 0.1f * sinf((float)i * 1.3f);
+    }
+
+    sim::resetHal();
+    uint32_t i = 0;
+    absolute_time_t now = 0;
+
+    bench::run(name, PID_BENCH_ITERATIONS, [&]() {
+        now += 100000;
+        sim::runUntil(now);
+        bench::keep(controller.getControlSignal(samples[i++ % PID_BENCH_SAMPLES]));
+    });
+}
+
+BENCHMARK(pid) {
+    sim::resetHal();
+    absolute_time_t now = 0;
+
+    // What the loop costs without a controller, to take off the others
+    bench::run("virtual clock only", PID_BENCH_ITERATIONS, [&]() {
+        now += 100000;
+        sim::runUntil(now);
+    });
+
+    runPid<PIDController>("PIDController (Q16.16)");
+    runPid<BasicPIDController<double, BackCalculationAntiWindup, FilteredDerivativeOnMeasurement>>("PIDController policies in double");
+    runPid<DoublePIDController>("DoublePIDController");
+}
@@ -0,0 +1,297 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "SimHal.h"
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <utility>
+
+struct uart_inst {
+    uint num = 0;
+    uint baudrate = 115200;
+    bool rxInterruptEnabled = false;
+    sim::UartDevice *device = nullptr;
+    std::deque<std::pair<absolute_time_t, uint8_t>> inFlight{};
+    std::deque<uint8_t> rxFifo{};
+};
+
+struct SimAlarm {
+    bool claimed = false;
+    bool armed = false;
+    absolute_time_t target = nil_time;
+    hardware_alarm_callback_t callback = nullptr;
+};
+
+#define SIM_NUM_IRQS 32
+
+static thread_local absolute_time_t now = 0;
+static thread_local bool eventRegister = false;
+static thread_local uart_inst uarts[2];
+static thread_local SimAlarm alarms[NUM_TIMERS];
+static thread_local irq_handler_t irqHandlers[SIM_NUM_IRQS];
+static thread_local bool irqEnabled[SIM_NUM_IRQS];
+
+static uint irqFor(const uart_inst_t *uart) {
+    return uart->num == 0 ? UART0_IRQ : UART1_IRQ;
+}
+
+static uint64_t characterTimeUs(const uart_inst_t *uart) {
+    // 8N1, so ten bits per byte
+    return (10ull * 1000 * 1000 + uart->baudrate - 1) / uart->baudrate;
+}
+
+// Finds the earliest pending event. Returns false if there is none.
+static bool nextEventAt(absolute_time_t *at) {
+    bool found = false;
+
+    for (auto &alarm: alarms) {
+        if (alarm.armed && (!found || alarm.target < *at)) {
+            *at = alarm.target;
+            found = true;
+        }
+    }
+
+    for (auto &uart: uarts) {
+        if (!uart.inFlight.empty() && (!found || uart.inFlight.front().first < *at)) {
+            *at = uart.inFlight.front().first;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static bool runNextEvent() {
+    absolute_time_t at = nil_time;
+    if (!nextEventAt(&at)) {
+        return false;
+    }
+
+    if (at > now) {
+        now = at;
+    }
+
+    for (uint i = 0; i < NUM_TIMERS; i++) {
+        if (alarms[i].armed && alarms[i].target == at) {
+            alarms[i].armed = false;
+            if (alarms[i].callback != nullptr) {
+                alarms[i].callback(i);
+            }
+            return true;
+        }
+    }
+
+    for (auto &uart: uarts) {
+        if (!uart.inFlight.empty() && uart.inFlight.front().first == at) {
+            uart.rxFifo.push_back(uart.inFlight.front().second);
+            uart.inFlight.pop_front();
+
+            uint irq = irqFor(&uart);
+            if (uart.rxInterruptEnabled && irqEnabled[irq] && irqHandlers[irq] != nullptr) {
+                irqHandlers[irq]();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+namespace sim {
+    void resetHal() {
+        now = 0;
+        eventRegister = false;
+
+        for (uint i = 0; i < 2; i++) {
+            uarts[i] = uart_inst{};
+            uarts[i].num = i;
+        }
+
+        for (auto &alarm: alarms) {
+            alarm = SimAlarm{};
+        }
+
+        for (uint i = 0; i < SIM_NUM_IRQS; i++) {
+            irqHandlers[i] = nullptr;
+            irqEnabled[i] = false;
+        }
+    }
+
+    void connectUart(uart_inst_t *uart, UartDevice *device) {
+        uart->device = device;
+    }
+
+    void sendToUart(uart_inst_t *uart, const uint8_t *data, size_t length, absolute_time_t at) {
+        // Bytes can't overtake the ones already on the wire
+        if (!uart->inFlight.empty() && at <= uart->inFlight.back().first) {
+            at = uart->inFlight.back().first + characterTimeUs(uart);
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            uart->inFlight.emplace_back(at + i * characterTimeUs(uart), data[i]);
+        }
+    }
+
+    void runUntil(absolute_time_t t) {
+        absolute_time_t at = nil_time;
+        while (nextEventAt(&at) && at <= t) {
+            runNextEvent();
+        }
+
+        if (t > now) {
+            now = t;
+        }
+    }
+}
+
+absolute_time_t get_absolute_time() {
+    return now;
+}
+
+void sleep_until(absolute_time_t t) {
+    sim::runUntil(t);
+}
+
+void sleep_us(uint64_t us) {
+    sleep_until(delayed_by_us(now, us));
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_until(delayed_by_ms(now, ms));
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout) {
+    if (time_reached(timeout)) {
+        return true;
+    }
+
+    if (eventRegister) {
+        eventRegister = false;
+        return false;
+    }
+
+    absolute_time_t at = nil_time;
+    if (nextEventAt(&at) && at <= timeout) {
+        runNextEvent();
+        return time_reached(timeout);
+    }
+
+    now = timeout;
+    return true;
+}
+
+void __wfe() {
+    if (eventRegister) {
+        eventRegister = false;
+        return;
+    }
+
+    if (!runNextEvent()) {
+        // On hardware this would sleep forever
+        fprintf(stderr, "Simulated core waiting for an event with nothing pending at %llu us\n", (unsigned long long)now);
+        abort();
+    }
+}
+
+void __sev() {
+    eventRegister = true;
+}
+
+uint32_t time_us_32() {
+    return (uint32_t)now;
+}
+
+uint64_t time_us_64() {
+    return now;
+}
+
+int hardware_alarm_claim_unused(bool required) {
+    for (uint i = 0; i < NUM_TIMERS; i++) {
+        if (!alarms[i].claimed) {
+            alarms[i].claimed = true;
+            return (int)i;
+        }
+    }
+
+    if (required) {
+        fprintf(stderr, "No free hardware alarms\n");
+        abort();
+    }
+
+    return -1;
+}
+
+void hardware_alarm_unclaim(uint alarm_num) {
+    alarms[alarm_num] = SimAlarm{};
+}
+
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback) {
+    alarms[alarm_num].callback = callback;
+}
+
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    if (t <= now) {
+        alarms[alarm_num].armed = false;
+        return true;
+    }
+
+    alarms[alarm_num].armed = true;
+    alarms[alarm_num].target = t;
+    return false;
+}
+
+void hardware_alarm_cancel(uint alarm_num) {
+    alarms[alarm_num].armed = false;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    irqHandlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    irqEnabled[num] = enabled;
+}
+
+uart_inst_t *sim_uart_get_instance(uint num) {
+    uarts[num].num = num;
+    return &uarts[num];
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    uart->baudrate = baudrate;
+    return baudrate;
+}
+
+void uart_set_fifo_enabled(uart_inst_t *, bool) {
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool) {
+    uart->rxInterruptEnabled = rx_has_data;
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    return !uart->rxFifo.empty();
+}
+
+char uart_getc(uart_inst_t *uart) {
+    while (uart->rxFifo.empty()) {
+        __wfe();
+    }
+
+    uint8_t ch = uart->rxFifo.front();
+    uart->rxFifo.pop_front();
+    return (char)ch;
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len) {
+    sim::runUntil(delayed_by_us(now, len * characterTimeUs(uart)));
+
+    if (uart->device != nullptr) {
+        uart->device->onReceive(uart, src, len, now);
+    }
+}
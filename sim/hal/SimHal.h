@@ -0,0 +1,45 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_SIMHAL_H
+#define SMART_LCC_SIM_SIMHAL_H
+
+#include <hardware/uart.h>
+#include <pico/time.h>
+
+/*
+ * Simulator side of the HAL stub.
+ *
+ * The firmware sees a normal pico-sdk: a microsecond clock, hardware alarms, UARTs with RX interrupts and WFE/SEV.
+ * Underneath, everything runs on a single thread and a virtual clock. Whenever the firmware sleeps or waits for an
+ * event, the clock jumps straight to the next alarm or incoming UART byte and the matching interrupt handler is run,
+ * so a simulation runs as fast as the code under test does.
+ *
+ * All of that state is per thread. Separate threads can run independent simulations, as long as the firmware code
+ * they run keeps no static state of its own. The controllers and the plant don't, but the control board receiver and
+ * the cycle scheduler do, so a whole SystemController can only run on one thread at a time.
+ */
+namespace sim {
+    // Whatever is on the other end of a UART, e.g. the control board
+    class UartDevice {
+    public:
+        virtual ~UartDevice() = default;
+
+        // Called once the bytes written by the firmware have been completely transmitted
+        virtual void onReceive(uart_inst_t *uart, const uint8_t *data, size_t length, absolute_time_t at) = 0;
+    };
+
+    // Puts the clock back at zero and forgets all alarms, interrupt handlers, devices and bytes in flight
+    void resetHal();
+
+    void connectUart(uart_inst_t *uart, UartDevice *device);
+
+    // Sends bytes to the firmware. They arrive one character time apart, the first one at `at`.
+    void sendToUart(uart_inst_t *uart, const uint8_t *data, size_t length, absolute_time_t at);
+
+    // Runs every event up to and including t, and leaves the clock at t
+    void runUntil(absolute_time_t t);
+}
+
+#endif //SMART_LCC_SIM_SIMHAL_H
@@ -0,0 +1,160 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <hardware/sync.h>
+#include <pico/util/queue.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define SIM_NUM_SPIN_LOCKS 32
+
+// Unlike the rest of the HAL, these are shared between threads, the same way the real ones are between the cores
+static std::atomic_flag spinLocks[SIM_NUM_SPIN_LOCKS] = {};
+static std::atomic<uint32_t> claimedSpinLocks{0};
+
+int spin_lock_claim_unused(bool required) {
+    for (uint i = 0; i < SIM_NUM_SPIN_LOCKS; i++) {
+        uint32_t bit = 1u << i;
+        if ((claimedSpinLocks.fetch_or(bit) & bit) == 0) {
+            return (int)i;
+        }
+    }
+
+    if (required) {
+        fprintf(stderr, "No spin locks left\n");
+        abort();
+    }
+
+    return -1;
+}
+
+void spin_lock_unclaim(uint lock_num) {
+    claimedSpinLocks.fetch_and(~(1u << lock_num));
+}
+
+uint32_t spin_lock_blocking(uint lock_num) {
+    uint32_t saved = save_and_disable_interrupts();
+    while (spinLocks[lock_num].test_and_set(std::memory_order_acquire)) {}
+    return saved;
+}
+
+void spin_unlock(uint lock_num, uint32_t saved_irq) {
+    spinLocks[lock_num].clear(std::memory_order_release);
+    restore_interrupts(saved_irq);
+}
+
+static inline uint8_t *element_ptr(queue_t *q, uint index) {
+    return q->data + index * q->element_size;
+}
+
+static inline uint16_t inc_index(queue_t *q, uint16_t index) {
+    if (++index > q->element_count) {
+        index = 0;
+    }
+
+    return index;
+}
+
+void queue_init_with_spinlock(queue_t *q, uint element_size, uint element_count, uint spinlock_num) {
+    q->spin_lock_num = (int)spinlock_num;
+    // One spare element, so full and empty can be told apart
+    q->data = (uint8_t *)calloc(element_count + 1, element_size);
+    q->element_count = (uint16_t)element_count;
+    q->element_size = (uint16_t)element_size;
+    q->wptr = 0;
+    q->rptr = 0;
+}
+
+void queue_free(queue_t *q) {
+    free(q->data);
+}
+
+uint queue_get_level_unsafe(queue_t *q) {
+    int32_t rc = (int32_t)q->wptr - (int32_t)q->rptr;
+    if (rc < 0) {
+        rc += q->element_count + 1;
+    }
+
+    return (uint)rc;
+}
+
+uint queue_get_level(queue_t *q) {
+    uint32_t save = spin_lock_blocking(q->spin_lock_num);
+    uint level = queue_get_level_unsafe(q);
+    spin_unlock(q->spin_lock_num, save);
+
+    return level;
+}
+
+static bool queue_add_internal(queue_t *q, const void *data, bool block) {
+    do {
+        uint32_t save = spin_lock_blocking(q->spin_lock_num);
+        if (queue_get_level_unsafe(q) != q->element_count) {
+            memcpy(element_ptr(q, q->wptr), data, q->element_size);
+            q->wptr = inc_index(q, q->wptr);
+            spin_unlock(q->spin_lock_num, save);
+            __sev();
+            return true;
+        }
+
+        spin_unlock(q->spin_lock_num, save);
+        if (block) {
+            __wfe();
+        }
+    } while (block);
+
+    return false;
+}
+
+static bool queue_remove_internal(queue_t *q, void *data, bool block, bool remove) {
+    do {
+        uint32_t save = spin_lock_blocking(q->spin_lock_num);
+        if (queue_get_level_unsafe(q) != 0) {
+            if (data != nullptr) {
+                memcpy(data, element_ptr(q, q->rptr), q->element_size);
+            }
+
+            if (remove) {
+                q->rptr = inc_index(q, q->rptr);
+            }
+
+            spin_unlock(q->spin_lock_num, save);
+            __sev();
+            return true;
+        }
+
+        spin_unlock(q->spin_lock_num, save);
+        if (block) {
+            __wfe();
+        }
+    } while (block);
+
+    return false;
+}
+
+bool queue_try_add(queue_t *q, const void *data) {
+    return queue_add_internal(q, data, false);
+}
+
+bool queue_try_remove(queue_t *q, void *data) {
+    return queue_remove_internal(q, data, false, true);
+}
+
+bool queue_try_peek(queue_t *q, void *data) {
+    return queue_remove_internal(q, data, false, false);
+}
+
+void queue_add_blocking(queue_t *q, const void *data) {
+    queue_add_internal(q, data, true);
+}
+
+void queue_remove_blocking(queue_t *q, void *data) {
+    queue_remove_internal(q, data, true, true);
+}
+
+void queue_peek_blocking(queue_t *q, void *data) {
+    queue_remove_internal(q, data, true, false);
+}
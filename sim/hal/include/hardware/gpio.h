@@ -0,0 +1,10 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_GPIO_H
+#define SMART_LCC_SIM_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+#endif //SMART_LCC_SIM_HARDWARE_GPIO_H
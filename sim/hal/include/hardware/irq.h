@@ -0,0 +1,18 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_IRQ_H
+#define SMART_LCC_SIM_HARDWARE_IRQ_H
+
+#include "pico/types.h"
+
+#define UART0_IRQ 20
+#define UART1_IRQ 21
+
+typedef void (*irq_handler_t)();
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif //SMART_LCC_SIM_HARDWARE_IRQ_H
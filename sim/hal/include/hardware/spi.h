@@ -0,0 +1,13 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_SPI_H
+#define SMART_LCC_SIM_HARDWARE_SPI_H
+
+#include "pico/types.h"
+
+// Only the type, for SettingsFlash. The simulator's SettingsFlash keeps the sector in memory rather than talking SPI.
+typedef struct spi_inst spi_inst_t;
+
+#endif //SMART_LCC_SIM_HARDWARE_SPI_H
@@ -0,0 +1,26 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_SYNC_H
+#define SMART_LCC_SIM_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+// Runs the next pending event (alarm or UART byte) unless one has been signalled since the last wait
+void __wfe();
+void __sev();
+
+inline void __compiler_memory_barrier() { __asm__ volatile ("" : : : "memory"); }
+
+// Interrupt handlers only ever run from within a wait, so there's nothing to mask
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t) {}
+
+// The 32 hardware spin locks, as atomic flags
+int spin_lock_claim_unused(bool required);
+void spin_lock_unclaim(uint lock_num);
+uint32_t spin_lock_blocking(uint lock_num);
+void spin_unlock(uint lock_num, uint32_t saved_irq);
+
+#endif //SMART_LCC_SIM_HARDWARE_SYNC_H
@@ -0,0 +1,25 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_TIMER_H
+#define SMART_LCC_SIM_HARDWARE_TIMER_H
+
+#include "pico/time.h"
+
+#define NUM_TIMERS 4
+
+typedef void (*hardware_alarm_callback_t)(uint alarm_num);
+
+uint32_t time_us_32();
+uint64_t time_us_64();
+
+int hardware_alarm_claim_unused(bool required);
+void hardware_alarm_unclaim(uint alarm_num);
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback);
+
+// Returns true if the target has already passed, in which case the alarm doesn't fire
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t);
+void hardware_alarm_cancel(uint alarm_num);
+
+#endif //SMART_LCC_SIM_HARDWARE_TIMER_H
@@ -0,0 +1,27 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_UART_H
+#define SMART_LCC_SIM_HARDWARE_UART_H
+
+#include "pico/types.h"
+
+typedef struct uart_inst uart_inst_t;
+
+uart_inst_t *sim_uart_get_instance(uint num);
+
+#define uart0 (sim_uart_get_instance(0))
+#define uart1 (sim_uart_get_instance(1))
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool tx_needs_data);
+
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+
+// Takes as long as sending the bytes at the configured baud rate would
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
+
+#endif //SMART_LCC_SIM_HARDWARE_UART_H
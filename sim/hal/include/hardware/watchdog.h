@@ -0,0 +1,11 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_HARDWARE_WATCHDOG_H
+#define SMART_LCC_SIM_HARDWARE_WATCHDOG_H
+
+// The simulator always starts from power on
+inline bool watchdog_enable_caused_reboot() { return false; }
+
+#endif //SMART_LCC_SIM_HARDWARE_WATCHDOG_H
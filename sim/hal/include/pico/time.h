@@ -0,0 +1,35 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_PICO_TIME_H
+#define SMART_LCC_SIM_PICO_TIME_H
+
+#include "pico/types.h"
+
+/*
+ * The parts of the pico-sdk time API the controller uses, running on the simulator's virtual clock. Time only moves
+ * when the firmware sleeps or waits, and then straight to the next event.
+ */
+
+static constexpr absolute_time_t nil_time = 0;
+
+absolute_time_t get_absolute_time();
+
+inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t)ms * 1000; }
+inline absolute_time_t make_timeout_time_us(uint64_t us) { return delayed_by_us(get_absolute_time(), us); }
+inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return delayed_by_ms(get_absolute_time(), ms); }
+inline bool time_reached(absolute_time_t t) { return get_absolute_time() >= t; }
+
+void sleep_until(absolute_time_t t);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+// Returns true if the timeout was reached, false if woken up by an event before that
+bool best_effort_wfe_or_timeout(absolute_time_t timeout);
+
+#endif //SMART_LCC_SIM_PICO_TIME_H
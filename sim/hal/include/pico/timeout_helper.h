@@ -0,0 +1,10 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_PICO_TIMEOUT_HELPER_H
+#define SMART_LCC_SIM_PICO_TIMEOUT_HELPER_H
+
+#include "pico/time.h"
+
+#endif //SMART_LCC_SIM_PICO_TIMEOUT_HELPER_H
@@ -0,0 +1,16 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_PICO_TYPES_H
+#define SMART_LCC_SIM_PICO_TYPES_H
+
+#include <cstdint>
+#include <cstddef>
+
+typedef unsigned int uint;
+
+// Microseconds since boot, same as the SDK with PICO_OPAQUE_ABSOLUTE_TIME_T off
+typedef uint64_t absolute_time_t;
+
+#endif //SMART_LCC_SIM_PICO_TYPES_H
@@ -0,0 +1,39 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_PICO_UTIL_QUEUE_H
+#define SMART_LCC_SIM_PICO_UTIL_QUEUE_H
+
+#include "pico/types.h"
+
+/*
+ * The pico-sdk queue, as in pico/util/queue.c: a fixed size element ring behind a spin lock, every element copied in
+ * and out whole. Only here so PicoQueue can be compared with CommandChannel.
+ */
+typedef struct {
+    int spin_lock_num;
+    uint8_t *data;
+    uint16_t wptr;
+    uint16_t rptr;
+    uint16_t element_size;
+    uint16_t element_count;
+} queue_t;
+
+void queue_init_with_spinlock(queue_t *q, uint element_size, uint element_count, uint spinlock_num);
+void queue_free(queue_t *q);
+
+uint queue_get_level_unsafe(queue_t *q);
+uint queue_get_level(queue_t *q);
+
+static inline bool queue_is_empty(queue_t *q) { return queue_get_level(q) == 0; }
+static inline bool queue_is_full(queue_t *q) { return queue_get_level(q) == q->element_count; }
+
+bool queue_try_add(queue_t *q, const void *data);
+bool queue_try_remove(queue_t *q, void *data);
+bool queue_try_peek(queue_t *q, void *data);
+void queue_add_blocking(queue_t *q, const void *data);
+void queue_remove_blocking(queue_t *q, void *data);
+void queue_peek_blocking(queue_t *q, void *data);
+
+#endif //SMART_LCC_SIM_PICO_UTIL_QUEUE_H
@@ -0,0 +1,359 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "Simulation.h"
+
+/*
+ * Closed loop benchmark suite: the real Core 0 controller against a simulated Bianca, in virtual time.
+ *
+ * Usage: smart_lcc_sim [--trace-dir <dir>]
+ *
+ * With --trace-dir, a per cycle CSV trace of every scenario is written to <dir>/<scenario>.csv.
+ *
+ * After the benchmark scenarios, the brew boiler is auto-tuned, and a warm start with the PID settings that come out of
+ * it is compared with one on the defaults.
+ */
+
+#define AUTOTUNE_START_S 60.f
+// How long after the auto-tune the boiler has to be back within the settling band
+#define AUTOTUNE_HANDOVER_WINDOW_S 300.f
+
+// Group thermocouple settling band, and when the group cascade scenario brews, and loses and gets back the thermocouple
+#define GROUP_CASCADE_BAND_C 0.5f
+#define GROUP_CASCADE_BREW_S (40 * 60.f)
+#define GROUP_CASCADE_LOST_S (50 * 60.f)
+#define GROUP_CASCADE_RECOVERY_S (60 * 60.f)
+
+// Warm enough to skip the heat up routine, so this is a plain step response
+static Scenario warmStart(const SettingStruct &settings) {
+    return Scenario{
+            .name = "warm-start",
+            .durationS = 15 * 60,
+            .initialBrewC = 80.f,
+            .initialServiceC = 80.f,
+            .settings = settings,
+            .brews = {{12 * 60, 30}},
+    };
+}
+
+static std::vector<Scenario> benchmarkScenarios() {
+    SettingStruct defaults{};
+
+    SettingStruct eco = defaults;
+    eco.ecoMode = true;
+
+    SettingStruct smith = defaults;
+    smith.brewSmithPredictor.enabled = true;
+
+    SettingStruct scheduled = defaults;
+    scheduled.brewPidSchedule.enabled = true;
+
+    return {
+            Scenario{
+                    .name = "cold-start",
+                    .durationS = 40 * 60,
+                    .initialBrewC = 20.f,
+                    .initialServiceC = 20.f,
+                    .settings = defaults,
+                    .brews = {{37 * 60, 30}},
+            },
+            warmStart(defaults),
+            Scenario{
+                    .name = "back-to-back",
+                    .durationS = 12 * 60,
+                    .initialBrewC = defaults.brewTemperatureTarget,
+                    .initialServiceC = defaults.serviceTemperatureTarget,
+                    .settings = defaults,
+                    .brews = {{5 * 60, 28}, {6 * 60, 28}, {7 * 60, 28}},
+            },
+            Scenario{
+                    .name = "eco-mode",
+                    .durationS = 15 * 60,
+                    .initialBrewC = 70.f,
+                    .initialServiceC = 20.f,
+                    .settings = eco,
+                    .brews = {{13 * 60, 30}},
+            },
+            // The same as above, with the brew boiler Smith predictor on
+            Scenario{
+                    .name = "cold-start-smith",
+                    .durationS = 40 * 60,
+                    .initialBrewC = 20.f,
+                    .initialServiceC = 20.f,
+                    .settings = smith,
+                    .brews = {{37 * 60, 30}},
+            },
+            Scenario{
+                    .name = "warm-start-smith",
+                    .durationS = 15 * 60,
+                    .initialBrewC = 80.f,
+                    .initialServiceC = 80.f,
+                    .settings = smith,
+                    .brews = {{12 * 60, 30}},
+            },
+            Scenario{
+                    .name = "back-to-back-smith",
+                    .durationS = 12 * 60,
+                    .initialBrewC = defaults.brewTemperatureTarget,
+                    .initialServiceC = defaults.serviceTemperatureTarget,
+                    .settings = smith,
+                    .brews = {{5 * 60, 28}, {6 * 60, 28}, {7 * 60, 28}},
+            },
+            // And with the brew PID gain schedule on
+            Scenario{
+                    .name = "back-to-back-sched",
+                    .durationS = 12 * 60,
+                    .initialBrewC = defaults.brewTemperatureTarget,
+                    .initialServiceC = defaults.serviceTemperatureTarget,
+                    .settings = scheduled,
+                    .brews = {{5 * 60, 28}, {6 * 60, 28}, {7 * 60, 28}},
+            },
+    };
+}
+
+static void printMetric(float value) {
+    if (std::isnan(value)) {
+        printf(" %9s", "-");
+    } else {
+        printf(" %9.2f", value);
+    }
+}
+
+static void printMetrics(const char *scenario, const char *boiler, const BoilerMetrics &metrics) {
+    printf("%-20s %-8s", scenario, boiler);
+    printMetric(metrics.settlingTimeS);
+    printMetric(metrics.overshootC);
+    printMetric(metrics.rippleC);
+    printMetric(metrics.brewDropC);
+    printMetric(metrics.recoveryOvershootC);
+    printf("\n");
+}
+
+static void writeTrace(const char *traceDir, const std::string &name, const SimulationResult &result) {
+    if (traceDir != nullptr) {
+        writeTraceCsv(result.trace, std::string(traceDir) + "/" + name + ".csv");
+    }
+}
+
+// A warm start on other brew PID settings against one on the defaults
+static bool compareWarmStart(const char *name, const PidSettings &brewPidSettings, const char *traceDir) {
+    SettingStruct defaults{};
+    SettingStruct other = defaults;
+    other.brewPidParameters = brewPidSettings;
+
+    SimulationResult before = runSimulation(warmStart(defaults));
+    SimulationResult after = runSimulation(warmStart(other));
+
+    std::string scenario = std::string("warm-start-") + name;
+    writeTrace(traceDir, scenario, after);
+
+    printf("%-20s brew ITAE %.0f with the defaults, %.0f %s (%+.0f%%)\n", "warm-start",
+           before.brew.itae, after.brew.itae, name, 100. * (after.brew.itae / before.brew.itae - 1.));
+    printMetrics(scenario.c_str(), "brew", after.brew);
+
+    return after.bails == 0;
+}
+
+// Relay auto-tune of the brew boiler from normal operation, then a warm start on what it came up with
+static bool runAutoTune(const char *traceDir) {
+    SettingStruct defaults{};
+
+    Scenario tune{
+            .name = "autotune-brew",
+            .durationS = 50 * 60,
+            .initialBrewC = defaults.brewTemperatureTarget,
+            .initialServiceC = defaults.serviceTemperatureTarget,
+            .settings = defaults,
+            .brews = {},
+            .commands = {{AUTOTUNE_START_S, SystemControllerCommand{.type = COMMAND_START_AUTOTUNE, .int1 = AUTOTUNE_BOILER_BREW}}},
+    };
+
+    SimulationResult tuned = runSimulation(tune);
+    writeTrace(traceDir, tune.name, tuned);
+
+    const AutoTuneStatus &autoTune = tuned.status.autoTune;
+    if (autoTune.state != AUTOTUNE_STATE_DONE) {
+        printf("%-20s ended in state %u, abort reason %u\n", tune.name.c_str(), autoTune.state, autoTune.abortReason);
+        return false;
+    }
+
+    float doneS = NAN;
+    float handOverErrorC = 0.f;
+    for (const auto &sample: tuned.trace) {
+        if (std::isnan(doneS) && sample.autoTuneState == AUTOTUNE_STATE_DONE) {
+            doneS = sample.timeS;
+        } else if (!std::isnan(doneS) && sample.timeS > doneS + AUTOTUNE_HANDOVER_WINDOW_S - RIPPLE_WINDOW_S &&
+                   sample.timeS <= doneS + AUTOTUNE_HANDOVER_WINDOW_S) {
+            handOverErrorC = std::fmax(handOverErrorC, std::fabs(sample.brewWaterC - defaults.brewTemperatureTarget));
+        }
+    }
+
+    const PidSettings &result = tuned.status.brewPidSettings;
+    printf("\n%-20s done after %.1f min, Ku %.2f, Tu %.0f s: Kp %.3f, Ki %.4f, Kd %.2f, windup %.2f\n",
+           tune.name.c_str(), (doneS - AUTOTUNE_START_S) / 60.f, autoTune.ultimateGain, autoTune.ultimatePeriodS,
+           result.Kp, result.Ki, result.Kd, result.windupHigh);
+    printf("%-20s %.2f C off the set point at most, %.0f to %.0f s after\n", tune.name.c_str(), handOverErrorC,
+           AUTOTUNE_HANDOVER_WINDOW_S - RIPPLE_WINDOW_S, AUTOTUNE_HANDOVER_WINDOW_S);
+
+    return compareWarmStart("autotuned", result, traceDir) && tuned.bails == 0;
+}
+
+// Cold start and a few brews with adaptive PID settings on, then a warm start on what Core 1 adopted
+static bool runAdaptivePid(const char *traceDir) {
+    SettingStruct adaptive{};
+    adaptive.adaptivePid = true;
+
+    Scenario adapt{
+            .name = "adaptive-pid",
+            .durationS = 60 * 60,
+            .initialBrewC = 20.f,
+            .initialServiceC = 20.f,
+            .settings = adaptive,
+            .brews = {{37 * 60, 30}, {45 * 60, 28}, {50 * 60, 28}},
+    };
+
+    SimulationResult adapted = runSimulation(adapt);
+    writeTrace(traceDir, adapt.name, adapted);
+
+    const PlantModelEstimate &model = adapted.status.brewPlantModel;
+    const PidSettings &result = adapted.status.brewPidSettings;
+    printf("\n%-20s brew model K %.1f C, tau %.0f s, dead time %.1f s: Kp %.3f, Ki %.4f, Kd %.2f, windup %.2f\n",
+           adapt.name.c_str(), model.gainC, model.timeConstantS, model.deadTimeS,
+           result.Kp, result.Ki, result.Kd, result.windupHigh);
+
+    if (!model.valid || result == adaptive.brewPidParameters) {
+        printf("%-20s kept the default brew PID settings\n", adapt.name.c_str());
+        return false;
+    }
+
+    return compareWarmStart("adaptive", result, traceDir) && adapted.bails == 0;
+}
+
+// Time after which the group stays within GROUP_CASCADE_BAND_C of the target, from fromS until toS. NAN if it doesn't.
+static float groupSettledAfter(const SimulationResult &result, float targetC, float fromS, float toS) {
+    float settledAtS = NAN;
+    for (const auto &sample: result.trace) {
+        if (sample.timeS < fromS) {
+            continue;
+        } else if (sample.timeS >= toS) {
+            break;
+        }
+
+        if (std::fabs(sample.groupC - targetC) > GROUP_CASCADE_BAND_C) {
+            settledAtS = NAN;
+        } else if (std::isnan(settledAtS)) {
+            settledAtS = sample.timeS;
+        }
+    }
+
+    return settledAtS - fromS;
+}
+
+// The group thermocouple cascade from a warm start, through a brew, then with the thermocouple lost for a while
+static bool runGroupHeadCascade(const char *traceDir) {
+    SettingStruct cascade{};
+    cascade.groupHeadCascade.enabled = true;
+
+    Scenario scenario{
+            .name = "group-cascade",
+            .durationS = GROUP_CASCADE_RECOVERY_S + 40 * 60,
+            .initialBrewC = 80.f,
+            .initialServiceC = 80.f,
+            .settings = cascade,
+            .brews = {{GROUP_CASCADE_BREW_S, 30}},
+            .groupThermocouple = true,
+            .thermocoupleDropouts = {{GROUP_CASCADE_LOST_S, GROUP_CASCADE_RECOVERY_S}},
+    };
+
+    SimulationResult result = runSimulation(scenario);
+    writeTrace(traceDir, scenario.name, result);
+
+    const float targetC = cascade.groupHeadCascade.targetC;
+    float settledS = groupSettledAfter(result, targetC, 0.f, GROUP_CASCADE_BREW_S);
+    float brewSettledS = groupSettledAfter(result, targetC, GROUP_CASCADE_BREW_S, GROUP_CASCADE_LOST_S);
+    float resettledS = groupSettledAfter(result, targetC, GROUP_CASCADE_RECOVERY_S, scenario.durationS);
+
+    // The correction isn't dropped until Core 1 sees the thermocouple gone, so time that and what's left after it
+    float overshootC = 0.f, correctionC = 0.f, brewErrorC = 0.f, droppedAfterS = NAN, lostCorrectionC = 0.f;
+    bool reachedTarget = false;
+    for (const auto &sample: result.trace) {
+        reachedTarget = reachedTarget || sample.groupC >= targetC;
+        if (reachedTarget && sample.timeS < GROUP_CASCADE_BREW_S) {
+            overshootC = std::fmax(overshootC, sample.groupC - targetC);
+        }
+
+        if (sample.timeS < GROUP_CASCADE_BREW_S) {
+            correctionC = sample.brewSetPointCorrectionC;
+        } else if (sample.timeS < GROUP_CASCADE_LOST_S) {
+            brewErrorC = std::fmax(brewErrorC, std::fabs(sample.groupC - targetC));
+        } else if (sample.timeS < GROUP_CASCADE_RECOVERY_S) {
+            if (std::isnan(droppedAfterS)) {
+                if (sample.brewSetPointCorrectionC == 0.f) {
+                    droppedAfterS = sample.timeS - GROUP_CASCADE_LOST_S;
+                }
+            } else {
+                lostCorrectionC = std::fmax(lostCorrectionC, std::fabs(sample.brewSetPointCorrectionC));
+            }
+        }
+    }
+
+    printf("\n%-20s group within %.1f C of %.1f C after %.0f s, overshoot %.2f C, brew set point %+.2f C\n",
+           scenario.name.c_str(), GROUP_CASCADE_BAND_C, targetC, settledS, overshootC, correctionC);
+    printf("%-20s brew moves the group %.2f C, back within %.1f C after %.0f s\n", scenario.name.c_str(), brewErrorC,
+           GROUP_CASCADE_BAND_C, brewSettledS);
+    printf("%-20s thermocouple lost for %.0f s, correction dropped after %.1f s and %.2f C at most after that\n",
+           scenario.name.c_str(), GROUP_CASCADE_RECOVERY_S - GROUP_CASCADE_LOST_S, droppedAfterS, lostCorrectionC);
+    printf("%-20s thermocouple back, group within %.1f C again after %.0f s\n", scenario.name.c_str(),
+           GROUP_CASCADE_BAND_C, resettledS);
+
+    return result.bails == 0 && !std::isnan(settledS) && !std::isnan(brewSettledS) && !std::isnan(resettledS) &&
+           !std::isnan(droppedAfterS) && lostCorrectionC == 0.f;
+}
+
+int main(int argc, char **argv) {
+    const char *traceDir = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace-dir") == 0 && i + 1 < argc) {
+            traceDir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--trace-dir <dir>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%-20s %-8s %9s %9s %9s %9s %9s\n", "scenario", "boiler", "settle s", "over C", "ripple C", "drop C", "post C");
+
+    double simulatedSeconds = 0;
+    double wallSeconds = 0;
+    bool bailed = false;
+
+    for (const auto &scenario: benchmarkScenarios()) {
+        SimulationResult result = runSimulation(scenario);
+
+        printMetrics(scenario.name.c_str(), "brew", result.brew);
+        printMetrics(scenario.name.c_str(), "service", result.service);
+
+        if (result.bails > 0) {
+            printf("%-20s bailed %u times\n", scenario.name.c_str(), result.bails);
+            bailed = true;
+        }
+
+        writeTrace(traceDir, scenario.name, result);
+
+        simulatedSeconds += scenario.durationS;
+        wallSeconds += result.wallSeconds;
+    }
+
+    bailed = !runAutoTune(traceDir) || bailed;
+    bailed = !runAdaptivePid(traceDir) || bailed;
+    bailed = !runGroupHeadCascade(traceDir) || bailed;
+
+    printf("\nSimulated %.0f s in %.2f s (%.0fx real time)\n", simulatedSeconds, wallSeconds, simulatedSeconds / wallSeconds);
+
+    return bailed ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SIM_TESTS_CHECK_H
+#define SMART_LCC_SIM_TESTS_CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+/*
+ * Just enough for the host tests. Each test is a plain executable run by ctest: failed checks are printed and counted,
+ * and check::result() is what main() returns, so a test fails if any of its checks did.
+ */
+namespace check {
+    inline int &failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result() {
+        if (failures() > 0) {
+            fprintf(stderr, "%d check(s) failed\n", failures());
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+#define CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            check::failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do { \
+        double checkActual = (double)(actual); \
+        double checkExpected = (double)(expected); \
+        if (!(std::fabs(checkActual - checkExpected) <= (double)(tolerance))) { \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #actual, #expected, \
+                    #tolerance, checkActual, checkExpected); \
+            check::failures()++; \
+        } \
+    } while (0)
+
+#endif //SMART_LCC_SIM_TESTS_CHECK_H
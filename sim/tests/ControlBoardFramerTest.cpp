@@ -0,0 +1,221 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "Controller/Core0/Util/ControlBoardFramer.h"
+#include "utils/checksum.h"
+
+/*
+ * ControlBoardFramer over byte streams the way the UART can deliver them: joined halfway through a packet, with packets
+ * cut short and with bits flipped. It must never hand out a frame that wasn't sent, and must pick up every intact
+ * packet that follows a broken one.
+ */
+
+#define FRAMER_TEST_PACKETS 10000
+
+static const size_t packetSize = sizeof(ControlBoardRawPacket);
+
+// A packet with random payload, which like the real ones only has the high bit set in the header
+static ControlBoardRawPacket randomPacket(std::mt19937 &random) {
+    std::uniform_int_distribution<int> payload(0, 0x7F);
+
+    uint8_t bytes[packetSize];
+    bytes[0] = CONTROL_BOARD_FRAME_HEADER;
+    for (size_t i = 1; i < packetSize - 1; i++) {
+        bytes[i] = (uint8_t)payload(random);
+    }
+    bytes[packetSize - 1] = calculate_checksum(bytes + 1, packetSize - 2, 0x01);
+
+    ControlBoardRawPacket packet{};
+    memcpy(&packet, bytes, packetSize);
+    return packet;
+}
+
+static bool samePacket(const ControlBoardRawPacket &a, const ControlBoardRawPacket &b) {
+    return memcmp(&a, &b, packetSize) == 0;
+}
+
+static void append(std::vector<uint8_t> &stream, const ControlBoardRawPacket &packet, size_t from = 0,
+                   size_t to = packetSize) {
+    auto bytes = reinterpret_cast<const uint8_t *>(&packet);
+    stream.insert(stream.end(), bytes + from, bytes + to);
+}
+
+static std::vector<ControlBoardRawPacket> frame(ControlBoardFramer &framer, const std::vector<uint8_t> &stream) {
+    std::vector<ControlBoardRawPacket> frames;
+    for (uint8_t byte: stream) {
+        if (framer.push(byte)) {
+            frames.push_back(framer.getFrame());
+        }
+    }
+
+    return frames;
+}
+
+static void testCleanStream() {
+    std::mt19937 random(1);
+    std::vector<ControlBoardRawPacket> sent;
+    std::vector<uint8_t> stream;
+
+    for (int i = 0; i < FRAMER_TEST_PACKETS; i++) {
+        sent.push_back(randomPacket(random));
+        append(stream, sent.back());
+    }
+
+    ControlBoardFramer framer;
+    std::vector<ControlBoardRawPacket> received = frame(framer, stream);
+
+    CHECK(received.size() == sent.size());
+    for (size_t i = 0; i < received.size() && i < sent.size(); i++) {
+        CHECK(samePacket(received[i], sent[i]));
+    }
+
+    CHECK(framer.getResyncCount() == 0);
+    CHECK(framer.getDroppedBytes() == 0);
+}
+
+// Joined at every possible offset into the first packet, the framer drops the rest of it and gets all the others
+static void testShiftedStream() {
+    std::mt19937 random(2);
+
+    for (size_t shift = 1; shift < packetSize; shift++) {
+        std::vector<ControlBoardRawPacket> sent;
+        std::vector<uint8_t> stream;
+
+        append(stream, randomPacket(random), shift);
+        for (int i = 0; i < 10; i++) {
+            sent.push_back(randomPacket(random));
+            append(stream, sent.back());
+        }
+
+        ControlBoardFramer framer;
+        std::vector<ControlBoardRawPacket> received = frame(framer, stream);
+
+        CHECK(received.size() == sent.size());
+        for (size_t i = 0; i < received.size() && i < sent.size(); i++) {
+            CHECK(samePacket(received[i], sent[i]));
+        }
+
+        CHECK(framer.getResyncCount() == 1);
+        CHECK(framer.getDroppedBytes() == packetSize - shift);
+    }
+}
+
+// Packets cut short at random, with the next one straight after, as when the control board resets mid-packet
+static void testTruncatedStream() {
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> coin(0, 3);
+    std::uniform_int_distribution<size_t> length(1, packetSize - 1);
+
+    std::vector<ControlBoardRawPacket> expected;
+    std::vector<uint8_t> stream;
+    uint32_t truncated = 0;
+
+    for (int i = 0; i < FRAMER_TEST_PACKETS; i++) {
+        ControlBoardRawPacket packet = randomPacket(random);
+        if (coin(random) == 0) {
+            append(stream, packet, 0, length(random));
+            truncated++;
+        } else {
+            append(stream, packet);
+            expected.push_back(packet);
+        }
+    }
+
+    ControlBoardFramer framer;
+    std::vector<ControlBoardRawPacket> received = frame(framer, stream);
+
+    printf("Truncated: %u of %d packets cut short, %zu received, %u resyncs\n",
+           truncated, FRAMER_TEST_PACKETS, received.size(), framer.getResyncCount());
+
+    CHECK(received.size() == expected.size());
+    for (size_t i = 0; i < received.size() && i < expected.size(); i++) {
+        CHECK(samePacket(received[i], expected[i]));
+    }
+
+    // A packet cut short at the end of the stream is forgotten on reset, and doesn't spoil the next one
+    std::vector<uint8_t> tail;
+    append(tail, randomPacket(random), 0, packetSize / 2);
+    CHECK(frame(framer, tail).empty());
+    framer.reset();
+
+    ControlBoardRawPacket next = randomPacket(random);
+    std::vector<uint8_t> nextStream;
+    append(nextStream, next);
+    received = frame(framer, nextStream);
+    CHECK(received.size() == 1 && samePacket(received[0], next));
+}
+
+// A bit flipped in some of the packets. The 7 bit checksum catches any single flipped bit in the payload, and a flip
+// that sets the high bit looks like a header, so a broken packet must never come out, and all the others must.
+static void testNoisyStream() {
+    std::mt19937 random(4);
+    std::uniform_int_distribution<int> coin(0, 3);
+    std::uniform_int_distribution<size_t> byteIndex(0, packetSize - 1);
+    std::uniform_int_distribution<int> bitIndex(0, 7);
+
+    std::vector<ControlBoardRawPacket> expected;
+    std::vector<uint8_t> stream;
+    uint32_t corrupted = 0;
+
+    for (int i = 0; i < FRAMER_TEST_PACKETS; i++) {
+        ControlBoardRawPacket packet = randomPacket(random);
+        if (coin(random) == 0) {
+            auto bytes = reinterpret_cast<uint8_t *>(&packet);
+            bytes[byteIndex(random)] ^= (uint8_t)(1u << bitIndex(random));
+            corrupted++;
+        } else {
+            expected.push_back(packet);
+        }
+
+        append(stream, packet);
+    }
+
+    ControlBoardFramer framer;
+    std::vector<ControlBoardRawPacket> received = frame(framer, stream);
+
+    printf("Noisy: %u of %d packets corrupted, %zu received, %u resyncs, %u bytes dropped\n",
+           corrupted, FRAMER_TEST_PACKETS, received.size(), framer.getResyncCount(), framer.getDroppedBytes());
+
+    CHECK(received.size() == expected.size());
+    for (size_t i = 0; i < received.size() && i < expected.size(); i++) {
+        CHECK(samePacket(received[i], expected[i]));
+    }
+
+    CHECK(framer.getResyncCount() > 0);
+}
+
+// A packet with a payload bit flipped is kept aside as rejected, and doesn't spoil the one after it
+static void testChecksumError() {
+    std::mt19937 random(5);
+
+    ControlBoardRawPacket corrupted = randomPacket(random);
+    reinterpret_cast<uint8_t *>(&corrupted)[5] ^= 0x04;
+    ControlBoardRawPacket next = randomPacket(random);
+
+    std::vector<uint8_t> stream;
+    append(stream, corrupted);
+    append(stream, next);
+
+    ControlBoardFramer framer;
+    std::vector<ControlBoardRawPacket> received = frame(framer, stream);
+
+    CHECK(received.size() == 1 && samePacket(received[0], next));
+    CHECK(framer.getChecksumErrorCount() == 1);
+    CHECK(samePacket(framer.getRejectedFrame(), corrupted));
+}
+
+int main() {
+    testCleanStream();
+    testShiftedStream();
+    testTruncatedStream();
+    testNoisyStream();
+    testChecksumError();
+
+    return check::result();
+}
@@ -0,0 +1,149 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include "Check.h"
+#include "Simulation.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "Controller/Core0/Util/FopdtEstimator.h"
+#include "utils/MovingAverage.h"
+
+/*
+ * FopdtEstimator against a plant that really is first order plus dead time, and against DoubleFopdtEstimator, the
+ * double precision reference, on the simulated Bianca.
+ */
+
+#define FOPDT_TEST_CYCLE_S 0.1f
+#define FOPDT_TEST_SET_POINT_C 95.f
+
+struct KnownPlant {
+    float gainC;
+    float timeConstantS;
+    float deadTimeS;
+    float ambientC;
+};
+
+// Random heater duty around what holds FOPDT_TEST_SET_POINT_C, changed every ten SSR windows, so there is something
+// to fit
+static void runKnownPlant(const KnownPlant &plant, FopdtEstimator &fixedPoint, DoubleFopdtEstimator &reference) {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> dutySlots(5, 20);
+
+    float temperature = FOPDT_TEST_SET_POINT_C;
+    std::deque<bool> heater((size_t)(plant.deadTimeS / FOPDT_TEST_CYCLE_S), false);
+    int slots = 0;
+
+    for (int cycle = 0; cycle < 3 * 60 * 60 * 10; cycle++) {
+        int slot = cycle % FOPDT_SAMPLE_CYCLES;
+        if (slot == 0 && cycle % (10 * FOPDT_SAMPLE_CYCLES) == 0) {
+            slots = dutySlots(random);
+        }
+
+        bool heaterOn = slot < slots;
+        heater.push_back(heaterOn);
+        bool delayedOn = heater.front();
+        heater.pop_front();
+
+        float target = plant.ambientC + (delayedOn ? plant.gainC : 0.f);
+        temperature += (target - temperature) * FOPDT_TEST_CYCLE_S / plant.timeConstantS;
+
+        fixedPoint.update(Q16_16(temperature), heaterOn, false);
+        reference.update((double)temperature, heaterOn, false);
+    }
+}
+
+static void testKnownPlant() {
+    const KnownPlant plant{.gainC = 150.f, .timeConstantS = 600.f, .deadTimeS = 10.f, .ambientC = 20.f};
+
+    FopdtEstimator fixedPoint(100.f);
+    DoubleFopdtEstimator reference(100.f);
+    fixedPoint.updateSetPoint(FOPDT_TEST_SET_POINT_C);
+    reference.updateSetPoint(FOPDT_TEST_SET_POINT_C);
+
+    runKnownPlant(plant, fixedPoint, reference);
+
+    for (const auto *estimate: {&fixedPoint.getEstimate(), &reference.getEstimate()}) {
+        printf("Known plant: K %.1f C, tau %.0f s, dead time %.1f s, holding duty %.3f\n",
+               estimate->gainC, estimate->timeConstantS, estimate->deadTimeS, estimate->holdingDuty);
+
+        CHECK(estimate->valid);
+        CHECK_NEAR(estimate->gainC, plant.gainC, 0.1f * plant.gainC);
+        CHECK_NEAR(estimate->timeConstantS, plant.timeConstantS, 0.1f * plant.timeConstantS);
+        CHECK_NEAR(estimate->deadTimeS, plant.deadTimeS, FOPDT_SAMPLE_PERIOD_S);
+        CHECK_NEAR(estimate->holdingDuty, (FOPDT_TEST_SET_POINT_C - plant.ambientC) / plant.gainC, 0.05f);
+    }
+}
+
+// A set point the boiler holds without any heat, where windup limits scaled by the holding duty would switch off the
+// integral
+static void testNoHoldingDuty() {
+    const KnownPlant plant{.gainC = 150.f, .timeConstantS = 600.f, .deadTimeS = 10.f, .ambientC = 20.f};
+
+    FopdtEstimator fixedPoint(100.f);
+    DoubleFopdtEstimator reference(100.f);
+    fixedPoint.updateSetPoint(plant.ambientC - 5.f);
+    reference.updateSetPoint(plant.ambientC - 5.f);
+
+    runKnownPlant(plant, fixedPoint, reference);
+
+    for (const auto *estimate: {&fixedPoint.getEstimate(), &reference.getEstimate()}) {
+        CHECK(!estimate->valid);
+        CHECK(estimate->holdingDuty == 0.f);
+    }
+}
+
+// The simulated Bianca isn't first order, so only check that fixed point comes up with what double precision does
+static void testSimulatedBoiler() {
+    SettingStruct defaults{};
+    Scenario scenario{
+            .name = "cold-start",
+            .durationS = 60 * 60,
+            .initialBrewC = 20.f,
+            .initialServiceC = 20.f,
+            .settings = defaults,
+            .brews = {{37 * 60, 30}, {45 * 60, 28}, {50 * 60, 28}},
+    };
+
+    SimulationResult result = runSimulation(scenario);
+
+    FopdtEstimator fixedPoint(100.f);
+    DoubleFopdtEstimator reference(100.f);
+    fixedPoint.updateSetPoint(defaults.brewTemperatureTarget);
+    reference.updateSetPoint(defaults.brewTemperatureTarget);
+
+    // What the controller feeds it, see SystemController::estimate
+    MovingAverage<Q16_16, 5> average;
+    for (const auto &sample: result.trace) {
+        average.addValue(high_gain_adc_to_celsius(sample.brewHighGainAdc));
+
+        fixedPoint.update(average.average(), sample.brewSsr, sample.brewing);
+        reference.update((double)average.average(), sample.brewSsr, sample.brewing);
+    }
+
+    const PlantModelEstimate &fixed = fixedPoint.getEstimate();
+    const PlantModelEstimate &exact = reference.getEstimate();
+
+    printf("Simulated boiler, fixed point: K %.1f C, tau %.0f s, dead time %.1f s, Kp %.3f, Ki %.4f\n",
+           fixed.gainC, fixed.timeConstantS, fixed.deadTimeS, fixed.suggestedPid.Kp, fixed.suggestedPid.Ki);
+    printf("Simulated boiler, double:      K %.1f C, tau %.0f s, dead time %.1f s, Kp %.3f, Ki %.4f\n",
+           exact.gainC, exact.timeConstantS, exact.deadTimeS, exact.suggestedPid.Kp, exact.suggestedPid.Ki);
+
+    CHECK(fixed.valid && exact.valid);
+    CHECK_NEAR(fixed.gainC, exact.gainC, 0.1f * exact.gainC);
+    CHECK_NEAR(fixed.timeConstantS, exact.timeConstantS, 0.1f * exact.timeConstantS);
+    CHECK_NEAR(fixed.deadTimeS, exact.deadTimeS, FOPDT_SAMPLE_PERIOD_S);
+    CHECK_NEAR(fixed.suggestedPid.Kp, exact.suggestedPid.Kp, 0.15f * exact.suggestedPid.Kp);
+    CHECK_NEAR(fixed.suggestedPid.Ki, exact.suggestedPid.Ki, 0.15f * exact.suggestedPid.Ki);
+}
+
+int main() {
+    testKnownPlant();
+    testNoHoldingDuty();
+    testSimulatedBoiler();
+
+    return check::result();
+}
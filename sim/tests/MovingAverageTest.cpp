@@ -0,0 +1,176 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "utils/ExponentialMovingAverage.h"
+#include "utils/MovingAverage.h"
+#include "utils/MovingMedian.h"
+
+/*
+ * MovingAverage, ExponentialMovingAverage and MovingMedian against brute force over random samples, for each kind of
+ * type they handle differently.
+ */
+
+#define FILTER_TEST_SAMPLES 100000
+
+// The window as a brute force implementation would keep it
+template <class T> struct Window {
+    explicit Window(size_t capacity): capacity(capacity) {}
+
+    size_t capacity;
+    std::deque<T> samples{};
+
+    void add(T value) {
+        samples.push_back(value);
+        if (samples.size() > capacity) {
+            samples.pop_front();
+        }
+    }
+
+    [[nodiscard]] double mean() const {
+        double sum = 0;
+        for (T sample: samples) {
+            sum += (double)sample;
+        }
+        return samples.empty() ? 0. : sum / (double)samples.size();
+    }
+
+    [[nodiscard]] T lowerMedian() const {
+        std::vector<T> sorted(samples.begin(), samples.end());
+        std::sort(sorted.begin(), sorted.end());
+        return sorted.empty() ? T() : sorted[(sorted.size() - 1) / 2];
+    }
+};
+
+// Around a boiler temperature, with the odd spike
+static float randomTemperature(std::mt19937 &random) {
+    std::normal_distribution<float> noise(0.f, 0.5f);
+    std::uniform_int_distribution<int> spike(0, 50);
+
+    float value = 105.f + noise(random);
+    return spike(random) == 0 ? value + 20.f : value;
+}
+
+template <class T, uint16_t N> static void testMovingAverage(const char *name, double tolerance) {
+    std::mt19937 random(1);
+    MovingAverage<T, N> average;
+    Window<T> window(N);
+    double worstError = 0;
+
+    CHECK((double)average.average() == 0.);
+
+    for (int i = 0; i < FILTER_TEST_SAMPLES; i++) {
+        T value = T(randomTemperature(random));
+        average.addValue(value);
+        window.add(value);
+
+        CHECK(average.count() == window.samples.size());
+        worstError = std::fmax(worstError, std::fabs((double)average.average() - window.mean()));
+    }
+
+    printf("MovingAverage<%s, %u>: worst error %.2e\n", name, N, worstError);
+    CHECK(worstError <= tolerance);
+
+    average.reset();
+    CHECK(average.count() == 0);
+    CHECK((double)average.average() == 0.);
+}
+
+template <class T, uint8_t Shift> static void testExponentialMovingAverage(const char *name, double tolerance) {
+    std::mt19937 random(2);
+    ExponentialMovingAverage<T, Shift> average;
+    double reference = 0;
+    double worstError = 0;
+
+    for (int i = 0; i < FILTER_TEST_SAMPLES; i++) {
+        T value = T(randomTemperature(random));
+        average.addValue(value);
+
+        // The first sample seeds it
+        reference = i == 0 ? (double)value : reference + ((double)value - reference) / (double)(1u << Shift);
+        worstError = std::fmax(worstError, std::fabs((double)average.average() - reference));
+    }
+
+    printf("ExponentialMovingAverage<%s, %u>: worst error %.2e\n", name, Shift, worstError);
+    CHECK(worstError <= tolerance);
+
+    average.reset();
+    average.addValue(T(50.f));
+    CHECK((double)average.average() == (double)T(50.f));
+}
+
+template <class T, uint16_t N> static void testMovingMedian(const char *name) {
+    std::mt19937 random(3);
+    MovingMedian<T, N> median;
+    Window<T> window(N);
+    int mismatches = 0;
+
+    for (int i = 0; i < FILTER_TEST_SAMPLES; i++) {
+        T value = T(randomTemperature(random));
+        median.addValue(value);
+        window.add(value);
+
+        CHECK(median.count() == window.samples.size());
+        mismatches += (double)median.median() != (double)window.lowerMedian();
+    }
+
+    printf("MovingMedian<%s, %u>: %d mismatches\n", name, N, mismatches);
+    CHECK(mismatches == 0);
+}
+
+// Repeated values, which the removal from the sorted copy has to find by equality
+static void testMovingMedianDuplicates() {
+    std::mt19937 random(4);
+    std::uniform_int_distribution<int> values(0, 3);
+    MovingMedian<int, 6> median;
+    Window<int> window(6);
+    int mismatches = 0;
+
+    for (int i = 0; i < FILTER_TEST_SAMPLES; i++) {
+        int value = values(random);
+        median.addValue(value);
+        window.add(value);
+        mismatches += median.median() != window.lowerMedian();
+    }
+
+    CHECK(mismatches == 0);
+}
+
+// A single sample spike doesn't get through a median of three, where it moves a mean of three by a third
+static void testMovingMedianRejectsSpikes() {
+    MovingMedian<float, 3> median;
+    MovingAverage<float, 3> average;
+
+    for (float value: {105.f, 105.f, 125.f, 105.f}) {
+        median.addValue(value);
+        average.addValue(value);
+
+        CHECK(median.median() == 105.f);
+    }
+
+    CHECK(average.average() > 105.f);
+}
+
+int main() {
+    testMovingAverage<float, 5>("float", 1e-9);
+    testMovingAverage<int32_t, 16>("int32_t", 0);
+    testMovingAverage<Q16_16, 5>("Q16_16", 1. / 65536.);
+
+    testExponentialMovingAverage<float, 3>("float", 1e-3);
+    // The shift drops up to an LSB every step, and the average only takes back 1/2^Shift of it
+    testExponentialMovingAverage<Q16_16, 5>("Q16_16", 32. / 65536.);
+
+    testMovingMedian<float, 5>("float");
+    testMovingMedian<Q16_16, 7>("Q16_16");
+    testMovingMedianDuplicates();
+    testMovingMedianRejectsSpikes();
+
+    return check::result();
+}
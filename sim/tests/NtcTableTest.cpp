@@ -0,0 +1,96 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include "Check.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "LegacyControlBoardProtocol.h"
+
+/*
+ * The NTC lookup tables against the double precision formulas they're generated from, and against the float decoding
+ * the firmware used before them, for every ADC value that reads as a temperature the boilers live in.
+ */
+
+#define NTC_TEST_MIN_C 15.
+#define NTC_TEST_MAX_C 140.
+// What ntc_table.h promises in that range
+#define NTC_TEST_MAX_ERROR_C 0.01
+// The old decoding truncated the resistance to whole ohms and worked in float, which is worth this much on its own
+#define NTC_TEST_MAX_LEGACY_ERROR_C 0.05
+
+// The same formulas, but with the standard library rather than constexpr_math
+static double highGainCelsius(double adc) {
+    double ohm = 7181.23 * std::pow(-(adc - 1018.15) / (adc - 1.56789), (8000. / 8043.));
+    return (1. / (std::log(ohm / NTC_R25) / NTC_B + (1. / 298.15))) - 273.15;
+}
+
+static void testHighGain() {
+    double worstErrorC = 0, worstMathErrorC = 0, worstLegacyErrorC = 0;
+    int checked = 0;
+
+    for (uint16_t adc = NTC_ADC_MIN; adc <= NTC_ADC_MAX; adc++) {
+        double exactC = ntc_detail::ntc_ohm_to_celsius(ntc_detail::high_gain_adc_to_ohm(adc), NTC_R25, NTC_B);
+        double legacyC = legacy::ntc_ohm_to_celsius(legacy::high_gain_adc_to_ohm(adc), NTC_R25, NTC_B);
+
+        worstMathErrorC = std::fmax(worstMathErrorC, std::fabs(exactC - highGainCelsius(adc)));
+
+        if (exactC < NTC_TEST_MIN_C || exactC > NTC_TEST_MAX_C) {
+            continue;
+        }
+
+        CHECK(high_gain_adc_is_valid(adc));
+        worstErrorC = std::fmax(worstErrorC, std::fabs((double)high_gain_adc_to_celsius(adc) - exactC));
+        worstLegacyErrorC = std::fmax(worstLegacyErrorC, std::fabs((double)high_gain_adc_to_celsius(adc) - legacyC));
+        checked++;
+    }
+
+    printf("High gain: %d ADC values, worst error %.4f °C, against the old decoding %.4f °C, constexpr_math against libm %.2e °C\n",
+           checked, worstErrorC, worstLegacyErrorC, worstMathErrorC);
+
+    CHECK(checked > 100);
+    CHECK(worstErrorC < NTC_TEST_MAX_ERROR_C);
+    CHECK(worstLegacyErrorC < NTC_TEST_MAX_LEGACY_ERROR_C);
+    CHECK(worstMathErrorC < 1e-6);
+}
+
+static void testLowGain() {
+    double worstErrorC = 0;
+    int checked = 0;
+
+    for (uint16_t adc = 0; adc <= 1023; adc++) {
+        double exactC = ntc_detail::low_gain_adc_to_celsius(adc);
+
+        if (exactC < NTC_TEST_MIN_C || exactC > NTC_TEST_MAX_C) {
+            continue;
+        }
+
+        worstErrorC = std::fmax(worstErrorC, std::fabs((double)low_gain_adc_to_celsius(adc) - exactC));
+        checked++;
+    }
+
+    printf("Low gain: %d ADC values, worst error %.4f °C\n", checked, worstErrorC);
+
+    CHECK(checked > 100);
+    CHECK(worstErrorC < NTC_TEST_MAX_ERROR_C);
+}
+
+// Both ends of the valid range, and the open or shorted sensor outside of it
+static void testLimits() {
+    CHECK(!high_gain_adc_is_valid(NTC_ADC_MIN - 1));
+    CHECK(high_gain_adc_is_valid(NTC_ADC_MIN));
+    CHECK(high_gain_adc_is_valid(NTC_ADC_MAX));
+    CHECK(!high_gain_adc_is_valid(NTC_ADC_MAX + 1));
+
+    CHECK((double)high_gain_adc_to_celsius(0) == (double)high_gain_adc_to_celsius(NTC_ADC_MIN));
+    CHECK((double)high_gain_adc_to_celsius(1023) == (double)high_gain_adc_to_celsius(NTC_ADC_MAX));
+}
+
+int main() {
+    testHighGain();
+    testLowGain();
+    testLimits();
+
+    return check::result();
+}
@@ -0,0 +1,121 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Check.h"
+#include "hal/SimHal.h"
+#include "Controller/Core0/Util/PIDController.h"
+
+/*
+ * The Q16.16 PID controller against double precision, over the brew boiler sensor temperature recorded in the
+ * simulator through three back-to-back brews. The PIDs only see the recording, so they don't feed back into it.
+ *
+ * Both the original controller (DoublePIDController, with its clamped integral and derivative on error) and the one
+ * the boilers run on are compared with the same policies in the other numeric type.
+ *
+ * Usage: smart_lcc_test_pid_equivalence <brew_sensor.csv>
+ */
+
+typedef BasicPIDController<Q16_16, ClampedIntegralAntiWindup, DerivativeOnError> FixedPointReferencePIDController;
+typedef BasicPIDController<double, BackCalculationAntiWindup, FilteredDerivativeOnMeasurement> DoubleBoilerPIDController;
+
+struct Sample {
+    float timeS;
+    float temperatureC;
+};
+
+static std::vector<Sample> readSamples(const char *path) {
+    std::vector<Sample> samples;
+
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return samples;
+    }
+
+    char line[64];
+    // Header
+    fgets(line, sizeof(line), file);
+
+    Sample sample{};
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (sscanf(line, "%f,%f", &sample.timeS, &sample.temperatureC) == 2) {
+            samples.push_back(sample);
+        }
+    }
+
+    fclose(file);
+    return samples;
+}
+
+struct Comparison {
+    int cycles = 0;
+    int differentCycles = 0;
+    int worstSlotDifference = 0;
+    double worstIntegralDifference = 0;
+};
+
+template <class FixedPoint, class Double>
+static Comparison compare(const std::vector<Sample> &samples, const PidSettings &settings, float setPoint) {
+    sim::resetHal();
+
+    FixedPoint fixedPoint(settings, setPoint);
+    Double reference(settings, setPoint);
+    Comparison comparison{};
+
+    for (const Sample &sample: samples) {
+        sim::runUntil((absolute_time_t)(sample.timeS * 1e6f));
+
+        int fixedPointSlots = fixedPoint.getControlSignal(sample.temperatureC);
+        int referenceSlots = reference.getControlSignal(sample.temperatureC);
+
+        int slotDifference = abs(fixedPointSlots - referenceSlots);
+        comparison.cycles++;
+        comparison.differentCycles += slotDifference > 0;
+        comparison.worstSlotDifference = std::max(comparison.worstSlotDifference, slotDifference);
+        comparison.worstIntegralDifference = std::fmax(comparison.worstIntegralDifference,
+                                                       std::fabs((double)fixedPoint.integral - reference.integral));
+    }
+
+    return comparison;
+}
+
+static void print(const char *name, const Comparison &comparison) {
+    printf("%-28s %d of %d cycles differ, by at most %d slot(s), integral by at most %.5f\n", name,
+           comparison.differentCycles, comparison.cycles, comparison.worstSlotDifference, comparison.worstIntegralDifference);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <brew_sensor.csv>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Sample> samples = readSamples(argv[1]);
+    CHECK(!samples.empty());
+
+    SettingStruct defaults{};
+
+    Comparison original = compare<FixedPointReferencePIDController, DoublePIDController>(
+            samples, defaults.brewPidParameters, defaults.brewTemperatureTarget);
+    print("DoublePIDController", original);
+
+    Comparison boiler = compare<PIDController, DoubleBoilerPIDController>(
+            samples, defaults.brewPidParameters, defaults.brewTemperatureTarget);
+    print("PIDController", boiler);
+
+    // The PID output is rounded to whole steps of 2.5 slots. That only comes out differently right at the boundary
+    // between two steps, and then by one step.
+    CHECK(original.worstSlotDifference <= 3);
+    CHECK(original.differentCycles * 100 <= original.cycles);
+    CHECK(boiler.worstSlotDifference <= 3);
+    CHECK(boiler.differentCycles * 100 <= boiler.cycles);
+
+    CHECK(original.worstIntegralDifference < 0.01);
+    CHECK(boiler.worstIntegralDifference < 0.01);
+
+    return check::result();
+}
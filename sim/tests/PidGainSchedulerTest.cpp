@@ -0,0 +1,82 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include "Check.h"
+#include "Controller/Core0/Util/PidGainScheduler.h"
+
+/*
+ * PidGainScheduler only handing out PID settings when they change: on the first cycle, on a change of regime or
+ * settings, and on every cycle of a blend. Steady cycles come up with nothing, so the PID isn't reconfigured.
+ */
+
+#define SCHEDULER_TEST_CYCLE_US 100000
+
+static PidScheduleSettings enabledSchedule() {
+    PidScheduleSettings schedule = SettingStruct{}.brewPidSchedule;
+    schedule.enabled = true;
+    schedule.transitionS = 1.f;
+    schedule.brewing.Kp = 2.f;
+
+    return schedule;
+}
+
+int main() {
+    const PidSettings base = SettingStruct{}.brewPidParameters;
+    PidGainScheduler scheduler;
+    absolute_time_t now = 0;
+
+    auto cycle = [&](PidRegime regime) {
+        now = delayed_by_us(now, SCHEDULER_TEST_CYCLE_US);
+        scheduler.updateSettings(base, enabledSchedule());
+        return scheduler.update(regime, now);
+    };
+
+    auto first = cycle(PID_REGIME_IDLE);
+    CHECK(first.has_value() && first.value() == base);
+
+    // Nothing changes while idle, however often the same settings come in
+    uint32_t idleUpdates = 0;
+    for (int i = 0; i < 50; i++) {
+        idleUpdates += cycle(PID_REGIME_IDLE).has_value();
+    }
+    CHECK(idleUpdates == 0);
+
+    // A brew starts: new settings on every cycle of the 1 s blend, and then none
+    uint32_t blendUpdates = 0;
+    float lastKp = base.Kp;
+    bool rising = true;
+    for (int i = 0; i < 10; i++) {
+        auto settings = cycle(PID_REGIME_BREWING);
+        if (settings.has_value()) {
+            blendUpdates++;
+            rising = rising && settings.value().Kp > lastKp;
+            lastKp = settings.value().Kp;
+        }
+    }
+
+    printf("Blend: %u updates over 1 s, Kp up to %.2f\n", blendUpdates, lastKp);
+    CHECK(blendUpdates == 10);
+    CHECK(rising);
+    CHECK(lastKp == enabledSchedule().brewing.Kp);
+
+    uint32_t brewingUpdates = 0;
+    for (int i = 0; i < 50; i++) {
+        brewingUpdates += cycle(PID_REGIME_BREWING).has_value();
+    }
+    CHECK(brewingUpdates == 0);
+
+    // A settings change comes through once
+    PidScheduleSettings changed = enabledSchedule();
+    changed.brewing.Ki = 0.5f;
+    scheduler.updateSettings(base, changed);
+    now = delayed_by_us(now, SCHEDULER_TEST_CYCLE_US);
+    auto updated = scheduler.update(PID_REGIME_BREWING, now);
+    CHECK(updated.has_value() && updated.value().Ki == 0.5f);
+
+    now = delayed_by_us(now, SCHEDULER_TEST_CYCLE_US);
+    CHECK(!scheduler.update(PID_REGIME_BREWING, now).has_value());
+
+    return check::result();
+}
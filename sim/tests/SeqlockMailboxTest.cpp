@@ -0,0 +1,116 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "Check.h"
+#include "utils/SeqlockMailbox.h"
+
+/*
+ * SeqlockMailbox with a writer and a reader thread hammering it, like Core 0 and Core 1 but with no pause between
+ * publications. Every word of a published value is stamped with its publication number, so a read that mixes two
+ * publications shows up as words that disagree. Also a mailbox whose writer was reset halfway through a publish.
+ */
+
+#define SEQLOCK_TEST_DURATION_S 1.0
+// Large enough that a copy often gets preempted halfway, even with both threads on one host core
+#define SEQLOCK_TEST_WORDS 512
+
+struct Stamped {
+    uint32_t words[SEQLOCK_TEST_WORDS];
+};
+
+// What a writer reset between the two sequence stores leaves behind: the sequence is the mailbox's first member
+static void testInterruptedPublish() {
+    static_assert(std::is_standard_layout<SeqlockMailbox<uint32_t>>::value, "The test reaches into the mailbox");
+    SeqlockMailbox<uint32_t> mailbox;
+    mailbox.publish(1);
+    reinterpret_cast<std::atomic<uint32_t> *>(&mailbox)->store(3);
+
+    uint32_t value = 0, publication = 0;
+    CHECK(!mailbox.tryRead(&value));
+
+    for (uint32_t next = 2; next <= 4; next++) {
+        mailbox.publish(next);
+        CHECK(mailbox.tryRead(&value, &publication));
+        CHECK(value == next);
+        CHECK(publication == mailbox.getSequence());
+    }
+
+    printf("Interrupted publish: read %u as publication %u afterwards\n", value, publication);
+}
+
+int main() {
+    testInterruptedPublish();
+
+    static SeqlockMailbox<Stamped> mailbox;
+    std::atomic<bool> done{false};
+
+    Stamped unpublished{};
+    CHECK(!mailbox.tryRead(&unpublished));
+
+    std::thread writer([&]() {
+        static Stamped value{};
+        uint32_t publication = 0;
+
+        while (!done.load(std::memory_order_relaxed)) {
+            publication++;
+            for (uint32_t &word: value.words) {
+                word = publication;
+            }
+
+            mailbox.publish(value);
+        }
+    });
+
+    static Stamped value{};
+    uint32_t reads = 0, failedReads = 0, tornReads = 0, mislabeledReads = 0, backwardsReads = 0;
+    uint32_t lastPublication = 0;
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(SEQLOCK_TEST_DURATION_S);
+    while (std::chrono::steady_clock::now() < end) {
+        uint32_t publication;
+        if (!mailbox.tryRead(&value, &publication)) {
+            failedReads++;
+            continue;
+        }
+
+        reads++;
+
+        bool torn = false;
+        for (uint32_t word: value.words) {
+            torn = torn || word != value.words[0];
+        }
+
+        tornReads += torn;
+        // The sequence the reader got it with is the one it was published with
+        mislabeledReads += value.words[0] != publication;
+        backwardsReads += publication < lastPublication;
+        lastPublication = publication;
+
+        mailbox.acknowledge(publication);
+    }
+
+    done = true;
+    writer.join();
+
+    printf("%u publications, %u reads, %u failed reads (writer kept interfering), %u torn, %u mislabeled, %u backwards\n",
+           mailbox.getSequence(), reads, failedReads, tornReads, mislabeledReads, backwardsReads);
+
+    CHECK(reads > 0);
+    CHECK(tornReads == 0);
+    CHECK(mislabeledReads == 0);
+    CHECK(backwardsReads == 0);
+
+    // Nothing has been published since the writer stopped, so the reader catches up with it
+    uint32_t publication;
+    CHECK(mailbox.tryRead(&value, &publication));
+    CHECK(publication == mailbox.getSequence());
+    mailbox.acknowledge(publication);
+    CHECK(mailbox.getReaderLag() == 0);
+
+    return check::result();
+}
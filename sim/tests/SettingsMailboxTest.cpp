@@ -0,0 +1,141 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "Check.h"
+#include "Controller/Core0/SystemSettings.h"
+#include "Controller/Core1/SettingsManager.h"
+
+/*
+ * Settings go from Core 1 to Core 0 as whole snapshots through a SeqlockMailbox<SettingStruct>. With a writer and a
+ * reader thread going at it, Core 0 must only ever see complete sets of settings: never one setter's change halfway
+ * through, nor some fields of one set and some of another.
+ */
+
+#define SETTINGS_TEST_DURATION_S 0.5
+
+// Every field different from the defaults
+static SettingStruct otherSettings() {
+    SettingStruct settings{};
+    settings.brewTemperatureOffset = -16.5f;
+    settings.sleepMode = true;
+    settings.ecoMode = true;
+    settings.brewTemperatureTarget = 93.f;
+    settings.serviceTemperatureTarget = 125.f;
+    settings.autoSleepMin = 30;
+    settings.brewPidParameters = PidSettings{.Kp = 1.1f, .Ki = 0.2f, .Kd = 8.f, .windupLow = -5.f, .windupHigh = 5.f,
+            .setPointWeight = 0.5f, .derivativeFilterS = 3.f, .setPointRampCPerS = 0.5f};
+    settings.servicePidParameters = PidSettings{.Kp = 0.9f, .Ki = 0.05f, .Kd = 2.f, .windupLow = -8.f, .windupHigh = 8.f,
+            .setPointWeight = 0.7f, .derivativeFilterS = 4.f, .setPointRampCPerS = 1.f};
+    settings.adaptivePid = true;
+    settings.brewFeedForward.gain = settings.brewFeedForward.gain + 0.5f;
+    settings.brewSmithPredictor.enabled = true;
+    settings.brewPidSchedule.enabled = true;
+    settings.brewTemperatureFilter.enabled = true;
+    settings.groupHeadCascade.enabled = true;
+
+    return settings;
+}
+
+static bool sameSettings(const SettingStruct &a, const SettingStruct &b) {
+    return memcmp(&a, &b, sizeof(SettingStruct)) == 0;
+}
+
+// Whole snapshots published straight to the mailbox, alternating between two sets
+static void testWholeSnapshots() {
+    static SeqlockMailbox<SettingStruct> mailbox;
+    static const SettingStruct first{};
+    static const SettingStruct second = otherSettings();
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]() {
+        for (uint32_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+            mailbox.publish(i % 2 == 0 ? first : second);
+        }
+    });
+
+    SystemSettings settings;
+    uint32_t reads = 0, mixed = 0;
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(SETTINGS_TEST_DURATION_S);
+    while (std::chrono::steady_clock::now() < end) {
+        SettingStruct latest{};
+        if (!mailbox.tryRead(&latest)) {
+            continue;
+        }
+
+        settings.update(latest);
+        reads++;
+
+        mixed += !sameSettings(latest, first) && !sameSettings(latest, second);
+        // What Core 0 reads through SystemSettings is all from one set
+        bool firstPid = settings.getBrewPidParameters().Kp == first.brewPidParameters.Kp;
+        mixed += firstPid != (settings.getTargetBrewTemp() == first.brewTemperatureTarget);
+        mixed += firstPid != (settings.getServicePidParameters().Ki == first.servicePidParameters.Ki);
+    }
+
+    done = true;
+    writer.join();
+
+    printf("Snapshots: %u publications, %u reads, %u mixed\n", mailbox.getSequence(), reads, mixed);
+
+    CHECK(reads > 0);
+    CHECK(mixed == 0);
+}
+
+// Through SettingsManager, the way Core 1 actually changes settings: a setter replacing a whole PidSettings
+static void testSettingsManager() {
+    static SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    manager.initialize();
+
+    const PidSettings first = SettingStruct{}.brewPidParameters;
+    const PidSettings second = otherSettings().brewPidParameters;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]() {
+        for (uint32_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+            manager.setBrewPidParameters(i % 2 == 0 ? second : first);
+        }
+    });
+
+    uint32_t reads = 0, mixed = 0, lastPublication = 0, backwards = 0;
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(SETTINGS_TEST_DURATION_S);
+    while (std::chrono::steady_clock::now() < end) {
+        SettingStruct latest{};
+        uint32_t publication;
+        if (!mailbox.tryRead(&latest, &publication)) {
+            continue;
+        }
+
+        reads++;
+        backwards += publication < lastPublication;
+        lastPublication = publication;
+
+        const PidSettings &pid = latest.brewPidParameters;
+        mixed += memcmp(&pid, &first, sizeof(PidSettings)) != 0 && memcmp(&pid, &second, sizeof(PidSettings)) != 0;
+    }
+
+    done = true;
+    writer.join();
+
+    printf("SettingsManager: %u publications, %u reads, %u mixed\n", mailbox.getSequence(), reads, mixed);
+
+    CHECK(reads > 0);
+    CHECK(mixed == 0);
+    CHECK(backwards == 0);
+}
+
+int main() {
+    testWholeSnapshots();
+    testSettingsManager();
+
+    return check::result();
+}
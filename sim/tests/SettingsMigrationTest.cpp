@@ -0,0 +1,151 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <cstring>
+#include "Check.h"
+#include "SimSettingsFlash.h"
+#include "Controller/Core1/SettingsManager.h"
+#include "utils/crc32.h"
+
+/*
+ * SettingsManager reading what earlier firmware left in the settings flash. Version 1 settings, the baseline layout,
+ * are migrated and written back in the current version. Anything else it doesn't know falls back to the defaults.
+ */
+
+// The layouts on flash, as the baseline firmware wrote them
+struct TestSettingsHeader {
+    uint8_t version;
+    crc32_t crc;
+    size_t len;
+};
+
+struct TestPidSettingsV1 {
+    float Kp;
+    float Ki;
+    float Kd;
+    float windupLow;
+    float windupHigh;
+};
+
+struct TestSettingStructV1 {
+    float brewTemperatureOffset;
+    bool sleepMode;
+    bool ecoMode;
+    float brewTemperatureTarget;
+    float serviceTemperatureTarget;
+    uint16_t autoSleepMin;
+    TestPidSettingsV1 brewPidParameters;
+    TestPidSettingsV1 servicePidParameters;
+};
+
+static const TestSettingStructV1 v1Settings{
+        .brewTemperatureOffset = -12.f,
+        .sleepMode = false,
+        .ecoMode = true,
+        .brewTemperatureTarget = 103.f,
+        .serviceTemperatureTarget = 125.f,
+        .autoSleepMin = 45,
+        .brewPidParameters = {.Kp = 1.1f, .Ki = 0.1f, .Kd = 10.f, .windupLow = -6.f, .windupHigh = 6.f},
+        .servicePidParameters = {.Kp = 0.7f, .Ki = 0.08f, .Kd = 2.f, .windupLow = -9.f, .windupHigh = 9.f},
+};
+
+static void writePage(uint8_t version, const void *payload, size_t len, bool corrupt = false) {
+    TestSettingsHeader header{.version = version, .crc = 0, .len = len};
+    crc32(payload, len, &header.crc);
+    if (corrupt) {
+        header.crc ^= 1;
+    }
+
+    sim::eraseSettingsFlash();
+    memcpy(sim::settingsFlashSector(), &header, sizeof(TestSettingsHeader));
+    memcpy(sim::settingsFlashSector() + sizeof(TestSettingsHeader), payload, len);
+}
+
+static bool samePidGains(const PidSettings &settings, const TestPidSettingsV1 &v1) {
+    return settings.Kp == v1.Kp && settings.Ki == v1.Ki && settings.Kd == v1.Kd &&
+           settings.windupLow == v1.windupLow && settings.windupHigh == v1.windupHigh;
+}
+
+static void checkMigrated(const SettingsManager &manager) {
+    const SettingStruct defaults{};
+
+    CHECK(manager.getBrewTemperatureOffset() == v1Settings.brewTemperatureOffset);
+    CHECK(manager.getEcoMode() == v1Settings.ecoMode);
+    CHECK(manager.getTargetBrewTemp() == v1Settings.brewTemperatureTarget);
+    CHECK(manager.getTargetServiceTemp() == v1Settings.serviceTemperatureTarget);
+    CHECK(manager.getAutoSleepMin() == v1Settings.autoSleepMin);
+    CHECK(samePidGains(manager.getBrewPidParameters(), v1Settings.brewPidParameters));
+    CHECK(samePidGains(manager.getServicePidParameters(), v1Settings.servicePidParameters));
+
+    // What version 1 didn't have starts out at the defaults
+    CHECK(manager.getBrewPidParameters().setPointWeight == defaults.brewPidParameters.setPointWeight);
+    CHECK(manager.getBrewPidParameters().derivativeFilterS == defaults.brewPidParameters.derivativeFilterS);
+    CHECK(manager.getServicePidParameters().derivativeFilterS == defaults.servicePidParameters.derivativeFilterS);
+    CHECK(manager.getAdaptivePid() == defaults.adaptivePid);
+    CHECK(manager.getBrewFeedForward().gain == defaults.brewFeedForward.gain);
+    CHECK(manager.getBrewPidSchedule().recoveryS == defaults.brewPidSchedule.recoveryS);
+    CHECK(manager.getGroupHeadCascade().targetC == defaults.groupHeadCascade.targetC);
+}
+
+static void testMigratesVersion1() {
+    writePage(0x01, &v1Settings, sizeof(TestSettingStructV1));
+
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    manager.initialize();
+
+    checkMigrated(manager);
+
+    // Written back in the current version, and read as such after a restart
+    manager.writeSettingsIfChanged();
+    TestSettingsHeader header{};
+    memcpy(&header, sim::settingsFlashSector(), sizeof(TestSettingsHeader));
+    CHECK(header.version != 0x01 && header.len == sizeof(SettingStruct));
+
+    SettingsManager restarted(&mailbox, &flash);
+    restarted.initialize();
+    checkMigrated(restarted);
+}
+
+static void testFallsBackToDefaults() {
+    const SettingStruct defaults{};
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+
+    struct {
+        const char *name;
+        uint8_t version;
+        bool corrupt;
+    } cases[] = {
+            {"corrupt version 1", 0x01, true},
+            {"unknown version", 0x7F, false},
+            {"erased", 0xFF, false},
+    };
+
+    for (const auto &c: cases) {
+        if (c.version == 0xFF) {
+            sim::eraseSettingsFlash();
+        } else {
+            writePage(c.version, &v1Settings, sizeof(TestSettingStructV1), c.corrupt);
+        }
+
+        SettingsManager manager(&mailbox, &flash);
+        manager.initialize();
+
+        bool isDefault = manager.getTargetBrewTemp() == defaults.brewTemperatureTarget &&
+                         manager.getAutoSleepMin() == defaults.autoSleepMin &&
+                         manager.getBrewPidParameters().Kp == defaults.brewPidParameters.Kp;
+        printf("%s: %s\n", c.name, isDefault ? "defaults" : "not the defaults");
+        CHECK(isDefault);
+    }
+}
+
+int main() {
+    testMigratesVersion1();
+    testFallsBackToDefaults();
+
+    return check::result();
+}
@@ -0,0 +1,228 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include "Check.h"
+#include "SimSettingsFlash.h"
+#include "Controller/Core1/SettingsManager.h"
+
+/*
+ * SettingsManager refusing PID gains and shaping, brew feed forward, Smith predictor and temperature filter settings
+ * the controllers can't work with, whichever setter they come through. Refused settings leave the current ones as they were. The brew PID
+ * schedule's times are clamped instead, as Core 0 turns them into microseconds.
+ */
+
+static void testPidSettings() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    const PidSettings defaults = SettingStruct{}.brewPidParameters;
+
+    PidSettings valid = defaults;
+    valid.setPointWeight = 0.f;
+    valid.derivativeFilterS = 0.f;
+    valid.setPointRampCPerS = 0.5f;
+    CHECK(manager.setBrewPidParameters(valid));
+    CHECK(manager.getBrewPidParameters() == valid);
+    CHECK(manager.setBrewPidParameters(defaults));
+
+    PidSettings invalid[] = {defaults, defaults, defaults, defaults, defaults, defaults, defaults, defaults};
+    invalid[0].setPointWeight = 1.5f;
+    invalid[1].setPointWeight = -0.1f;
+    invalid[2].setPointWeight = NAN;
+    invalid[3].derivativeFilterS = -1.f;
+    invalid[4].derivativeFilterS = INFINITY;
+    invalid[5].setPointRampCPerS = -0.5f;
+    invalid[6].setPointRampCPerS = NAN;
+    invalid[7].Kp = NAN;
+
+    for (const auto &params: invalid) {
+        CHECK(!manager.setBrewPidParameters(params));
+        CHECK(!manager.setServicePidParameters(params));
+    }
+
+    CHECK(manager.getBrewPidParameters() == defaults);
+    CHECK(manager.getServicePidParameters() == SettingStruct{}.servicePidParameters);
+}
+
+static void testBrewFeedForward() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    const BrewFeedForwardSettings defaults = SettingStruct{}.brewFeedForward;
+
+    BrewFeedForwardSettings off = defaults;
+    off.gain = 0.f;
+    CHECK(manager.setBrewFeedForward(off));
+    CHECK(manager.setBrewFeedForward(defaults));
+
+    BrewFeedForwardSettings invalid[] = {defaults, defaults, defaults, defaults, defaults, defaults, defaults, defaults};
+    invalid[0].gain = -1.f;
+    invalid[1].pumpFlowGramsPerS = NAN;
+    invalid[2].lineFlowGramsPerS = -0.5f;
+    invalid[3].tankTemperatureC = 150.f;
+    invalid[4].heatExchangerEffectiveness = 1.2f;
+    invalid[5].leadGain = INFINITY;
+    invalid[6].leadTimeS = -5.f;
+    invalid[7].gain = NAN;
+
+    uint32_t refused = 0;
+    for (const auto &feedForward: invalid) {
+        refused += !manager.setBrewFeedForward(feedForward);
+    }
+
+    printf("Brew feed forward: %u of %zu invalid settings refused\n", refused, sizeof(invalid) / sizeof(invalid[0]));
+    CHECK(refused == sizeof(invalid) / sizeof(invalid[0]));
+    CHECK(manager.getBrewFeedForward() == defaults);
+}
+
+static void testPidSchedule() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    struct {
+        float seconds;
+        bool zero;
+    } cases[] = {{NAN, true}, {-INFINITY, true}, {-5.f, true}, {INFINITY, false}, {1e30f, false}};
+
+    for (const auto &c: cases) {
+        PidScheduleSettings schedule = SettingStruct{}.brewPidSchedule;
+        schedule.transitionS = c.seconds;
+        schedule.recoveryS = c.seconds;
+        manager.setBrewPidSchedule(schedule);
+
+        const PidScheduleSettings &applied = manager.getBrewPidSchedule();
+        printf("Brew PID schedule: %g s becomes %g s transition, %g s recovery\n", c.seconds, applied.transitionS,
+               applied.recoveryS);
+
+        CHECK(std::isfinite(applied.transitionS) && std::isfinite(applied.recoveryS));
+        CHECK((applied.transitionS == 0.f) == c.zero);
+        CHECK((applied.recoveryS == 0.f) == c.zero);
+        // Ten minutes of blending and an hour of recovery at most
+        CHECK(applied.transitionS <= 600.f && applied.recoveryS <= 3600.f);
+    }
+
+    PidScheduleSettings normal = SettingStruct{}.brewPidSchedule;
+    manager.setBrewPidSchedule(normal);
+    CHECK(manager.getBrewPidSchedule() == normal);
+}
+
+static void testSmithPredictor() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    const SmithPredictorSettings defaults = SettingStruct{}.brewSmithPredictor;
+
+    SmithPredictorSettings longest = defaults;
+    longest.enabled = true;
+    longest.deadTimeS = SMITH_PREDICTOR_MAX_DEAD_TIME_S;
+    CHECK(manager.setBrewSmithPredictor(longest));
+    CHECK(manager.setBrewSmithPredictor(defaults));
+
+    SmithPredictorSettings invalid[] = {defaults, defaults, defaults, defaults, defaults, defaults, defaults};
+    invalid[0].gainC = NAN;
+    invalid[1].gainC = INFINITY;
+    invalid[2].timeConstantS = -1.f;
+    invalid[3].deadTimeS = NAN;
+    invalid[4].deadTimeS = -0.5f;
+    invalid[5].deadTimeS = SMITH_PREDICTOR_MAX_DEAD_TIME_S + 1.f;
+    invalid[6].deadTimeS = 1e9f;
+
+    for (auto &smithPredictor: invalid) {
+        smithPredictor.enabled = true;
+        CHECK(!manager.setBrewSmithPredictor(smithPredictor));
+    }
+
+    CHECK(manager.getBrewSmithPredictor() == defaults);
+}
+
+static void testTemperatureFilter() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    const TemperatureFilterSettings defaults = SettingStruct{}.brewTemperatureFilter;
+
+    TemperatureFilterSettings enabled = defaults;
+    enabled.enabled = true;
+    enabled.heaterLagS = 0.f;
+    CHECK(manager.setBrewTemperatureFilter(enabled));
+    CHECK(manager.setBrewTemperatureFilter(defaults));
+
+    TemperatureFilterSettings invalid[] = {defaults, defaults, defaults, defaults, defaults, defaults, defaults};
+    invalid[0].heaterRateCPerS = NAN;
+    invalid[1].heaterRateCPerS = -0.1f;
+    invalid[2].heaterLagS = INFINITY;
+    invalid[3].rateNoise = NAN;
+    invalid[4].rateNoise = 100.f;
+    invalid[5].measurementNoiseC = -0.03f;
+    invalid[6].measurementNoiseC = 1e20f;
+
+    for (const auto &filter: invalid) {
+        CHECK(!manager.setBrewTemperatureFilter(filter));
+    }
+
+    CHECK(manager.getBrewTemperatureFilter() == defaults);
+}
+
+// Idle writes straight to the brew PID parameters, so it is held to the same as setBrewPidParameters
+static void testPidScheduleGains() {
+    SeqlockMailbox<SettingStruct> mailbox;
+    SettingsFlash flash(nullptr, 0);
+    SettingsManager manager(&mailbox, &flash);
+    sim::eraseSettingsFlash();
+    manager.initialize();
+
+    const SettingStruct defaults{};
+    const PidGains valid{.Kp = 1.5f, .Ki = 0.1f, .Kd = 8.f, .windupLow = -5.f, .windupHigh = 5.f};
+
+    PidGains invalid[] = {valid, valid, valid, valid, valid, valid};
+    invalid[0].Kp = NAN;
+    invalid[1].Ki = -0.1f;
+    invalid[2].Kd = INFINITY;
+    invalid[3].windupLow = -INFINITY;
+    invalid[4].windupHigh = NAN;
+    invalid[5].windupLow = 6.f;
+
+    for (PidRegime regime: {PID_REGIME_IDLE, PID_REGIME_BREWING, PID_REGIME_RECOVERY, PID_REGIME_SLEEP}) {
+        for (const auto &gains: invalid) {
+            CHECK(!manager.setBrewPidScheduleGains(regime, gains));
+        }
+    }
+
+    CHECK(manager.getBrewPidParameters() == defaults.brewPidParameters);
+    CHECK(manager.getBrewPidSchedule() == defaults.brewPidSchedule);
+
+    CHECK(manager.setBrewPidScheduleGains(PID_REGIME_IDLE, valid));
+    CHECK(manager.getBrewPidParameters().Kp == valid.Kp && manager.getBrewPidParameters().windupHigh == valid.windupHigh);
+    CHECK(manager.setBrewPidScheduleGains(PID_REGIME_BREWING, valid));
+    CHECK(manager.getBrewPidSchedule().brewing == valid);
+}
+
+int main() {
+    testPidSettings();
+    testBrewFeedForward();
+    testSmithPredictor();
+    testTemperatureFilter();
+    testPidSchedule();
+    testPidScheduleGains();
+
+    return check::result();
+}
@@ -0,0 +1,198 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <vector>
+#include "Check.h"
+#include "Simulation.h"
+#include "Controller/Core0/Util/SsrSlotPlanner.h"
+
+/*
+ * SsrSlotPlanner against the duty requests SystemController made of it in two stretches of the simulator: the cold
+ * start heat up, where power sharing splits the whole window between the boilers, and three back-to-back brews.
+ *
+ * Usage: smart_lcc_test_ssr_slot_planner <ssr_requests.csv>
+ */
+
+#define SLOTS_PER_WINDOW 25
+
+struct Request {
+    uint8_t brewSlots;
+    uint8_t serviceSlots;
+};
+
+static std::vector<Request> readRequests(const char *path) {
+    std::vector<Request> requests;
+
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return requests;
+    }
+
+    char line[64];
+    // Header
+    fgets(line, sizeof(line), file);
+
+    unsigned brew, service;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (sscanf(line, "%u,%u", &brew, &service) == 2) {
+            requests.push_back(Request{(uint8_t)brew, (uint8_t)service});
+        }
+    }
+
+    fclose(file);
+    return requests;
+}
+
+// Slot delivery for one boiler: how far it is from its requested duty, and how long it waits for the first slot
+struct DutyTracker {
+    // On-slots delivered minus on-slots requested (in windows), since the request last went up from zero
+    float errorSlots = 0.f;
+    float worstErrorSlots = 0.f;
+
+    // Slots since the request went up from zero without getting one, or -1 once it has
+    int waitingSlots = -1;
+    uint8_t waitingFor = 0;
+    // The worst wait, relative to what the request alone allows for
+    int worstExtraWaitSlots = 0;
+
+    uint8_t previousRequest = 0;
+
+    void update(uint8_t requested, bool on) {
+        if (requested == 0) {
+            errorSlots = 0.f;
+            waitingSlots = -1;
+        } else if (previousRequest == 0) {
+            waitingSlots = 0;
+            waitingFor = requested;
+        }
+
+        previousRequest = requested;
+
+        errorSlots += (on ? 1.f : 0.f) - (float)requested / SLOTS_PER_WINDOW;
+        worstErrorSlots = std::fmax(worstErrorSlots, std::fabs(errorSlots));
+
+        if (waitingSlots >= 0) {
+            waitingSlots++;
+
+            if (on) {
+                // The accumulator fills up after this many slots
+                int dueAfter = (SLOTS_PER_WINDOW + waitingFor - 1) / waitingFor;
+                worstExtraWaitSlots = std::max(worstExtraWaitSlots, waitingSlots - dueAfter);
+                waitingSlots = -1;
+            }
+        }
+    }
+};
+
+static void testRecordedRequests(const std::vector<Request> &requests) {
+    SsrSlotPlanner planner(SLOTS_PER_WINDOW);
+    DutyTracker brew, service;
+
+    for (const Request &request: requests) {
+        // Power sharing already happened
+        CHECK(request.brewSlots + request.serviceSlots <= SLOTS_PER_WINDOW);
+
+        SsrState state = planner.nextSlot(request.brewSlots, request.serviceSlots);
+
+        CHECK(state == BOTH_SSRS_OFF || state == BREW_BOILER_SSR_ON || state == SERVICE_BOILER_SSR_ON);
+        // A boiler that doesn't ask for a slot never gets one
+        CHECK(request.brewSlots > 0 || state != BREW_BOILER_SSR_ON);
+        CHECK(request.serviceSlots > 0 || state != SERVICE_BOILER_SSR_ON);
+
+        brew.update(request.brewSlots, state == BREW_BOILER_SSR_ON);
+        service.update(request.serviceSlots, state == SERVICE_BOILER_SSR_ON);
+    }
+
+    printf("Duty error: brew %.2f slots, service %.2f slots\n", brew.worstErrorSlots, service.worstErrorSlots);
+    printf("Extra wait for the first slot: brew %d slots, service %d slots\n", brew.worstExtraWaitSlots, service.worstExtraWaitSlots);
+
+    // Each accumulator stays within a window of its target, plus the one slot a boiler can lose to the other
+    CHECK(brew.worstErrorSlots <= 2.f);
+    CHECK(service.worstErrorSlots <= 2.f);
+    CHECK(brew.worstExtraWaitSlots <= 1);
+    CHECK(service.worstExtraWaitSlots <= 1);
+}
+
+// A changed request is acted upon on the very next slot, nothing is committed ahead of time
+static void testReallocationDelay() {
+    SsrSlotPlanner planner(SLOTS_PER_WINDOW);
+
+    // The service boiler has the whole window, and the brew boiler suddenly wants all of it
+    for (int i = 0; i < 3 * SLOTS_PER_WINDOW; i++) {
+        CHECK(planner.nextSlot(0, SLOTS_PER_WINDOW) == SERVICE_BOILER_SSR_ON);
+    }
+
+    for (int i = 0; i < 3 * SLOTS_PER_WINDOW; i++) {
+        CHECK(planner.nextSlot(SLOTS_PER_WINDOW, 0) == BREW_BOILER_SSR_ON);
+    }
+
+    // And dropping a request stops the slots straight away too
+    CHECK(planner.nextSlot(0, 0) == BOTH_SSRS_OFF);
+}
+
+// Every split of the window comes out exactly over a whole number of windows, give or take the slot still owed
+static void testExactDuty() {
+    for (uint8_t brewSlots = 0; brewSlots <= SLOTS_PER_WINDOW; brewSlots++) {
+        for (uint8_t serviceSlots = 0; brewSlots + serviceSlots <= SLOTS_PER_WINDOW; serviceSlots++) {
+            SsrSlotPlanner planner(SLOTS_PER_WINDOW);
+            int brewOn = 0, serviceOn = 0;
+
+            for (int i = 0; i < 100 * SLOTS_PER_WINDOW; i++) {
+                SsrState state = planner.nextSlot(brewSlots, serviceSlots);
+                brewOn += state == BREW_BOILER_SSR_ON;
+                serviceOn += state == SERVICE_BOILER_SSR_ON;
+            }
+
+            // Whichever boiler lost the last contested slot is still owed it, but not both
+            CHECK(brewOn == 100 * brewSlots || brewOn == 100 * brewSlots - 1);
+            CHECK(serviceOn == 100 * serviceSlots || serviceOn == 100 * serviceSlots - 1);
+            CHECK(brewOn + serviceOn >= 100 * (brewSlots + serviceSlots) - 1);
+        }
+    }
+}
+
+// Through the whole controller, both SSRs are never on in the same slot
+static void testMutualExclusionClosedLoop() {
+    SettingStruct defaults{};
+
+    SimulationResult result = runSimulation(Scenario{
+            .name = "cold-start",
+            .durationS = 40 * 60,
+            .initialBrewC = 20.f,
+            .initialServiceC = 20.f,
+            .settings = defaults,
+            .brews = {{37 * 60, 30}},
+    });
+
+    int bothOn = 0, brewOn = 0, serviceOn = 0;
+    for (const auto &sample: result.trace) {
+        bothOn += sample.brewSsr && sample.serviceSsr;
+        brewOn += sample.brewSsr;
+        serviceOn += sample.serviceSsr;
+    }
+
+    CHECK(bothOn == 0);
+    // Both boilers did actually heat
+    CHECK(brewOn > 0);
+    CHECK(serviceOn > 0);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <ssr_requests.csv>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Request> requests = readRequests(argv[1]);
+    CHECK(!requests.empty());
+
+    testRecordedRequests(requests);
+    testReallocationDelay();
+    testExactDuty();
+    testMutualExclusionClosedLoop();
+
+    return check::result();
+}
@@ -0,0 +1,354 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cstdio>
+#include <memory>
+#include "Check.h"
+#include "hal/SimHal.h"
+#include "BoilerPlant.h"
+#include "VirtualControlBoard.h"
+#include "Controller/Core0/SystemController.h"
+#include "utils/checksum.h"
+#include "utils/triplet.h"
+
+/*
+ * The stages of SystemController's control cycle (ingest, decode, estimate, control, arbitrate, emit) one at a time,
+ * each with the inputs the previous one would hand it. runSimulation covers them all together.
+ */
+
+#define TEST_BREW_TARGET_C 94.f
+#define TEST_SERVICE_TARGET_C 120.f
+
+class SystemControllerTestAccess {
+public:
+    typedef SystemController::ControlDemand ControlDemand;
+
+    explicit SystemControllerTestAccess(SystemController *controller): controller(controller) {}
+
+    // What loop() does around the stages
+    void startCycles() { controller->cycleScheduler.restart(); }
+    void handleCommands() { controller->handleCommands(); }
+
+    bool ingest() {
+        controller->cycleScheduler.waitForNextCycle();
+        return controller->ingest();
+    }
+
+    ControlBoardDecodedPacket decode(bool received) { return controller->decode(received); }
+
+    ControlBoardDecodedPacket decode(const ControlBoardRawPacket &packet) {
+        controller->currentControlBoardRawPacket = packet;
+        return controller->decode(true);
+    }
+
+    void estimate(const ControlBoardDecodedPacket &packet) { controller->estimate(packet); }
+    ControlDemand control(const ControlBoardDecodedPacket &packet) { return controller->control(packet); }
+
+    // The result is what goes out with the next ingest
+    LccParsedPacket arbitrate(const ControlDemand &demand) {
+        return controller->currentLccParsedPacket = controller->arbitrate(demand);
+    }
+
+    void emit(const ControlBoardDecodedPacket &packet) { controller->emit(packet); }
+
+    [[nodiscard]] const ControlBoardRawPacket &rawPacket() const { return controller->currentControlBoardRawPacket; }
+    [[nodiscard]] SystemControllerInternalState internalState() const { return controller->internalState; }
+    [[nodiscard]] SystemControllerRunState runState() const { return controller->runState; }
+    [[nodiscard]] SystemControllerBailReason bailReason() const { return controller->bail_reason; }
+    [[nodiscard]] float brewTemperature() const { return static_cast<float>(controller->controlledBrewTemperature()); }
+    [[nodiscard]] float serviceTemperature() const { return static_cast<float>(controller->serviceTempAverage.average()); }
+    [[nodiscard]] const SystemSettings &settings() const { return *controller->settings; }
+private:
+    SystemController *controller;
+};
+
+// A SystemController with its mailboxes, started and with the test settings applied
+struct TestController {
+    SeqlockMailbox<SystemControllerStatusMessage> statusMailbox;
+    CommandChannel commandChannel;
+    SeqlockMailbox<SettingStruct> settingsMailbox;
+    std::unique_ptr<SystemController> controller;
+    std::unique_ptr<SystemControllerTestAccess> access;
+
+    explicit TestController(bool ecoMode = false) {
+        sim::resetHal();
+        uart_init(uart0, 9600);
+
+        SettingStruct settings{};
+        settings.brewTemperatureTarget = TEST_BREW_TARGET_C;
+        settings.serviceTemperatureTarget = TEST_SERVICE_TARGET_C;
+        settings.ecoMode = ecoMode;
+        settingsMailbox.publish(settings);
+        commandChannel.tryPush(SystemControllerCommand{.type = COMMAND_BEGIN});
+
+        controller = std::make_unique<SystemController>(uart0, &statusMailbox, &commandChannel, &settingsMailbox);
+        access = std::make_unique<SystemControllerTestAccess>(controller.get());
+    }
+
+    SystemControllerTestAccess *operator->() const { return access.get(); }
+};
+
+// Encoded the way the control board does it
+static ControlBoardRawPacket packetFor(float brewC, float serviceC, bool brewSwitch = false, bool tankEmpty = false) {
+    ControlBoardRawPacket packet{};
+    packet.header = 0x81;
+    packet.flags = (brewSwitch ? 0x02 : 0x00) | (tankEmpty ? 0x40 : 0x00);
+    packet.brew_boiler_temperature_high_gain = int_to_triplet(VirtualControlBoard::highGainAdcFor(brewC));
+    packet.brew_boiler_temperature_low_gain = int_to_triplet(VirtualControlBoard::lowGainAdcFor(brewC));
+    packet.service_boiler_temperature_high_gain = int_to_triplet(VirtualControlBoard::highGainAdcFor(serviceC));
+    packet.service_boiler_temperature_low_gain = int_to_triplet(VirtualControlBoard::lowGainAdcFor(serviceC));
+    packet.service_boiler_level = int_to_triplet(90);
+    packet.checksum = calculate_checksum(reinterpret_cast<const uint8_t *>(&packet) + 1, sizeof(packet) - 2, 0x01);
+
+    return packet;
+}
+
+// Decode and estimate one packet per cycle for a while, as a running controller would
+static ControlBoardDecodedPacket settle(TestController &controller, const ControlBoardRawPacket &packet, int cycles) {
+    ControlBoardDecodedPacket decoded{};
+    for (int i = 0; i < cycles; i++) {
+        sim::runUntil(get_absolute_time() + 100000);
+        decoded = controller->decode(packet);
+        controller->estimate(decoded);
+    }
+
+    return decoded;
+}
+
+// Replies to every LCC packet with a warm machine, but with the checksum off
+class CorruptingControlBoard: public sim::UartDevice {
+public:
+    void onReceive(uart_inst_t *uart, const uint8_t *, size_t, absolute_time_t at) override {
+        ControlBoardRawPacket reply = packetFor(93.f, 121.f);
+        reply.checksum ^= 0x01;
+        sim::sendToUart(uart, reinterpret_cast<const uint8_t *>(&reply), sizeof(reply), delayed_by_us(at, 5000));
+    }
+};
+
+// Commands and settings are taken in, the LCC packet goes out and the reply comes back over the UART
+static void testIngest() {
+    TestController controller;
+    BoilerPlant plant(defaultPlantParameters(), 93.f, 121.f);
+    VirtualControlBoard board(&plant, 5000);
+    sim::connectUart(uart0, &board);
+
+    controller->startCycles();
+    CHECK(controller->ingest());
+    CHECK(controller->internalState() == RUNNING);
+    CHECK(controller->settings().getTargetBrewTemp() == TEST_BREW_TARGET_C);
+    CHECK(board.getPacketCount() == 1);
+
+    ControlBoardDecodedPacket decoded = controller->decode(true);
+    CHECK(decoded.validation_errors == CONTROL_BOARD_VALIDATION_ERROR_NONE);
+    CHECK_NEAR(decoded.brew_boiler_temperature, 93.f, 0.5f);
+    CHECK_NEAR(decoded.service_boiler_temperature, 121.f, 0.5f);
+
+    // A forced bail already applies to the packet sent in the same cycle
+    plant.applyLccPacket(LccParsedPacket{.brew_boiler_ssr_on = true});
+    controller.commandChannel.tryPush(SystemControllerCommand{.type = COMMAND_FORCE_HARD_BAIL});
+    CHECK(controller->ingest());
+    CHECK(controller->internalState() == HARD_BAIL);
+    CHECK(!plant.getOutputs().brew_boiler_ssr_on && !plant.getOutputs().service_boiler_ssr_on);
+
+    // No reply by the end of the cycle
+    sim::connectUart(uart0, nullptr);
+    CHECK(!controller->ingest());
+
+    // A reply with a bad checksum is an invalid packet, not a missing one
+    TestController corrupted;
+    CorruptingControlBoard corruptingBoard;
+    sim::connectUart(uart0, &corruptingBoard);
+
+    corrupted->startCycles();
+    CHECK(corrupted->ingest());
+    decoded = corrupted->decode(true);
+    CHECK(decoded.validation_errors & CONTROL_BOARD_VALIDATION_ERROR_INVALID_CHECKSUM);
+    CHECK(corrupted->internalState() == SOFT_BAIL);
+    CHECK(corrupted->bailReason() == BAIL_REASON_CB_PACKET_INVALID);
+
+    sim::connectUart(uart0, nullptr);
+}
+
+// Bails on a missing or invalid packet, and unbails after two seconds of valid ones
+static void testDecode() {
+    TestController controller;
+    controller->handleCommands();
+
+    ControlBoardRawPacket warm = packetFor(93.f, 121.f);
+    ControlBoardDecodedPacket decoded = controller->decode(warm);
+    CHECK(decoded.validation_errors == CONTROL_BOARD_VALIDATION_ERROR_NONE);
+    CHECK(controller->runState() == RUN_STATE_NORMAL);
+    // Consumed, so a missed reply doesn't decode the previous one again
+    CHECK(controller->rawPacket().header == 0);
+
+    controller->decode(false);
+    CHECK(controller->internalState() == SOFT_BAIL);
+    CHECK(controller->bailReason() == BAIL_REASON_CB_UNRESPONSIVE);
+
+    for (int i = 0; i < 15; i++) {
+        sim::runUntil(get_absolute_time() + 100000);
+        controller->decode(warm);
+    }
+    CHECK(controller->internalState() == SOFT_BAIL);
+
+    for (int i = 0; i < 10; i++) {
+        sim::runUntil(get_absolute_time() + 100000);
+        controller->decode(warm);
+    }
+    CHECK(controller->internalState() == RUNNING);
+    CHECK(controller->bailReason() == BAIL_REASON_NONE);
+
+    ControlBoardRawPacket corrupted = warm;
+    corrupted.checksum ^= 0x01;
+    decoded = controller->decode(corrupted);
+    CHECK(decoded.validation_errors & CONTROL_BOARD_VALIDATION_ERROR_INVALID_CHECKSUM);
+    CHECK(controller->internalState() == SOFT_BAIL);
+    CHECK(controller->bailReason() == BAIL_REASON_CB_PACKET_INVALID);
+
+    // A cold boiler starts the heat-up once running again
+    TestController cold;
+    cold->handleCommands();
+    cold->decode(packetFor(25.f, 25.f));
+    CHECK(cold->runState() == RUN_STATE_HEATUP_STAGE_1);
+}
+
+// Temperatures are averaged, and the water tank only counts as empty after a second
+static void testEstimate() {
+    TestController controller;
+    controller->handleCommands();
+
+    settle(controller, packetFor(90.f, 118.f), 10);
+    CHECK_NEAR(controller->brewTemperature(), 90.f, 0.2f);
+
+    settle(controller, packetFor(93.f, 121.f), 5);
+    CHECK_NEAR(controller->brewTemperature(), 93.f, 0.2f);
+    CHECK_NEAR(controller->serviceTemperature(), 121.f, 0.2f);
+
+    ControlBoardDecodedPacket brewing = settle(controller, packetFor(93.f, 121.f, true, true), 5);
+    auto demand = controller->control(brewing);
+    CHECK(demand.brewing);
+
+    TestController emptyTank;
+    emptyTank->handleCommands();
+    brewing = settle(emptyTank, packetFor(93.f, 121.f, true, true), 15);
+    demand = emptyTank->control(brewing);
+    CHECK(!demand.brewing);
+    CHECK(!demand.lcc.pump_on);
+}
+
+// The boiler controllers' signals, and what a brew asks for
+static void testControl() {
+    TestController cool;
+    cool->handleCommands();
+    ControlBoardDecodedPacket packet = settle(cool, packetFor(TEST_BREW_TARGET_C - 3.f, TEST_SERVICE_TARGET_C - 5.f), 5);
+    auto demand = cool->control(packet);
+    CHECK(demand.brewSignal > 0);
+    CHECK(demand.serviceSignal > 0);
+    CHECK(!demand.brewing && !demand.brewBoilerPriority);
+
+    TestController hot;
+    hot->handleCommands();
+    packet = settle(hot, packetFor(TEST_BREW_TARGET_C + 3.f, TEST_SERVICE_TARGET_C + 5.f), 5);
+    demand = hot->control(packet);
+    CHECK(demand.brewSignal == 0);
+    CHECK(demand.serviceSignal == 0);
+
+    packet = settle(hot, packetFor(TEST_BREW_TARGET_C + 3.f, TEST_SERVICE_TARGET_C + 5.f, true), 1);
+    demand = hot->control(packet);
+    CHECK(demand.brewing && demand.brewBoilerPriority);
+    CHECK(demand.lcc.pump_on && demand.lcc.water_line_solenoid_open && !demand.lcc.service_boiler_solenoid_open);
+}
+
+// Counts each boiler's slots over a few windows of the SSR slot planner, and that they're never on together. Whatever
+// the planner still owed from the previous demand can shift a slot either way.
+static void arbitrateWindow(TestController &controller, const SystemControllerTestAccess::ControlDemand &demand,
+                            int *brewSlots, int *serviceSlots) {
+    *brewSlots = 0;
+    *serviceSlots = 0;
+
+    for (int slot = 0; slot < 4 * 25; slot++) {
+        LccParsedPacket lcc = controller->arbitrate(demand);
+        CHECK(!(lcc.brew_boiler_ssr_on && lcc.service_boiler_ssr_on));
+        *brewSlots += lcc.brew_boiler_ssr_on;
+        *serviceSlots += lcc.service_boiler_ssr_on;
+    }
+}
+
+// Power sharing between the boilers
+static void testArbitrate() {
+    int brewSlots, serviceSlots;
+
+    {
+        TestController controller;
+        controller->handleCommands();
+
+        SystemControllerTestAccess::ControlDemand demand{.brewSignal = 10, .serviceSignal = 10};
+        arbitrateWindow(controller, demand, &brewSlots, &serviceSlots);
+        CHECK_NEAR(brewSlots, 40, 1);
+        CHECK_NEAR(serviceSlots, 40, 1);
+
+        // Both at full power, the brew boiler gets 75%, unless brewing
+        demand = {.brewSignal = 25, .serviceSignal = 25};
+        arbitrateWindow(controller, demand, &brewSlots, &serviceSlots);
+        CHECK_NEAR(brewSlots, 72, 1);
+        CHECK_NEAR(serviceSlots, 28, 1);
+
+        demand = {.brewSignal = 25, .serviceSignal = 25, .brewing = true, .brewBoilerPriority = true};
+        arbitrateWindow(controller, demand, &brewSlots, &serviceSlots);
+        CHECK_NEAR(brewSlots, 100, 1);
+        CHECK(serviceSlots <= 1);
+
+        // Auto-tuning the service boiler
+        demand = {.brewSignal = 25, .serviceSignal = 25, .serviceBoilerPriority = true};
+        arbitrateWindow(controller, demand, &brewSlots, &serviceSlots);
+        CHECK(brewSlots <= 1);
+        CHECK_NEAR(serviceSlots, 100, 1);
+
+        demand = {.lcc = LccParsedPacket{.pump_on = true}, .brewSignal = 0, .serviceSignal = 0};
+        CHECK(controller->arbitrate(demand).pump_on);
+    }
+
+    {
+        TestController eco(true);
+        eco->handleCommands();
+
+        SystemControllerTestAccess::ControlDemand demand{.brewSignal = 10, .serviceSignal = 25};
+        arbitrateWindow(eco, demand, &brewSlots, &serviceSlots);
+        CHECK_NEAR(brewSlots, 40, 1);
+        CHECK(serviceSlots == 0);
+    }
+}
+
+// The status message Core 1 gets
+static void testEmit() {
+    TestController controller;
+    controller->handleCommands();
+
+    ControlBoardDecodedPacket packet = settle(controller, packetFor(93.f, 121.f), 5);
+    LccParsedPacket lcc = controller->arbitrate(controller->control(packet));
+    controller->emit(packet);
+
+    SystemControllerStatusMessage status{};
+    CHECK(controller.statusMailbox.tryRead(&status));
+    CHECK(status.internalState == RUNNING);
+    CHECK(status.runState == RUN_STATE_NORMAL);
+    CHECK(status.brewSetPoint == TEST_BREW_TARGET_C);
+    CHECK(status.serviceSetPoint == TEST_SERVICE_TARGET_C);
+    CHECK_NEAR(status.brewTemperature, 93.f, 0.2f);
+    CHECK_NEAR(status.serviceTemperature, 121.f, 0.2f);
+    CHECK(status.brewSSRActive == lcc.brew_boiler_ssr_on);
+    CHECK(status.serviceSSRActive == lcc.service_boiler_ssr_on);
+    CHECK(!status.currentlyBrewing);
+}
+
+int main() {
+    testIngest();
+    testDecode();
+    testEstimate();
+    testControl();
+    testArbitrate();
+    testEmit();
+
+    return check::result();
+}
@@ -0,0 +1,145 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Check.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
+#include "Controller/Core0/Util/TemperatureKalmanFilter.h"
+#include "utils/MovingAverage.h"
+
+/*
+ * TemperatureKalmanFilter against DoubleTemperatureKalmanFilter, its double precision reference, and against the five
+ * sample moving average it replaces, over brew boiler readings recorded in the simulator through three back-to-back
+ * brews. The simulated board has no noise, so the recording has 1 count RMS added to both channels. The simulated
+ * sensor temperature is the truth.
+ *
+ * Usage: smart_lcc_test_temperature_kalman_filter <brew_adc.csv>
+ */
+
+// Around the fixed point filter's rounding, and what smart_lcc_filter_replay reports
+#define KALMAN_TEST_MAX_FIXED_POINT_ERROR_C 0.01
+#define KALMAN_TEST_MAX_FIXED_POINT_RATE_ERROR 0.005
+// Readings at the start left out of the statistics, while the filter pulls in
+#define KALMAN_TEST_SKIP_CYCLES 100
+// The truth's rate is its difference over this many cycles, centered
+#define KALMAN_TEST_RATE_SPAN_CYCLES 10
+
+struct Reading {
+    float timeS;
+    uint16_t highGainAdc;
+    uint16_t lowGainAdc;
+    bool brewSsr;
+    float truthC;
+};
+
+static std::vector<Reading> readReadings(const char *path) {
+    std::vector<Reading> readings;
+
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return readings;
+    }
+
+    char line[128];
+    // Header
+    fgets(line, sizeof(line), file);
+
+    unsigned highGain, lowGain, ssr;
+    Reading reading{};
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (sscanf(line, "%f,%u,%u,%u,%f", &reading.timeS, &highGain, &lowGain, &ssr, &reading.truthC) == 5) {
+            reading.highGainAdc = (uint16_t)highGain;
+            reading.lowGainAdc = (uint16_t)lowGain;
+            reading.brewSsr = ssr != 0;
+            readings.push_back(reading);
+        }
+    }
+
+    fclose(file);
+    return readings;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <brew_adc.csv>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Reading> readings = readReadings(argv[1]);
+    CHECK(readings.size() > KALMAN_TEST_SKIP_CYCLES + KALMAN_TEST_RATE_SPAN_CYCLES);
+    if (readings.size() <= KALMAN_TEST_SKIP_CYCLES + KALMAN_TEST_RATE_SPAN_CYCLES) {
+        return check::result();
+    }
+
+    TemperatureFilterSettings settings = SettingStruct{}.brewTemperatureFilter;
+    settings.enabled = true;
+
+    MovingAverage<Q16_16, 5> average;
+    TemperatureKalmanFilter filter;
+    DoubleTemperatureKalmanFilter reference;
+    filter.configure(settings);
+    reference.configure(settings);
+
+    double worstError = 0, worstRateError = 0;
+    double averageSquares = 0, filterSquares = 0, averageRateSquares = 0, filterRateSquares = 0;
+    size_t count = 0;
+    std::vector<double> averageC;
+    float lastTimeS = readings[0].timeS;
+
+    for (size_t i = 0; i < readings.size(); i++) {
+        const Reading &reading = readings[i];
+        float dT = reading.timeS - lastTimeS;
+        lastTimeS = reading.timeS;
+
+        Q16_16 highGainC = high_gain_adc_to_celsius(reading.highGainAdc);
+        Q16_16 highGainResolution = high_gain_adc_resolution(reading.highGainAdc);
+        Q16_16 lowGainC = low_gain_adc_to_celsius(reading.lowGainAdc);
+        Q16_16 lowGainResolution = low_gain_adc_resolution(reading.lowGainAdc);
+
+        average.addValue(highGainC);
+        averageC.push_back((double)average.average());
+        filter.update(highGainC, highGainResolution, lowGainC, lowGainResolution, reading.brewSsr, Q16_16(dT));
+        reference.update((double)highGainC, (double)highGainResolution, (double)lowGainC, (double)lowGainResolution,
+                         reading.brewSsr, dT);
+
+        worstError = std::fmax(worstError, std::fabs((double)filter.getTemperature() - reference.getTemperature()));
+        worstRateError = std::fmax(worstRateError, std::fabs((double)filter.getRate() - reference.getRate()));
+
+        size_t span = KALMAN_TEST_RATE_SPAN_CYCLES;
+        if (i < KALMAN_TEST_SKIP_CYCLES || i + span / 2 >= readings.size()) {
+            continue;
+        }
+
+        const Reading &from = readings[i - span / 2];
+        const Reading &to = readings[i + span / 2];
+        double truthRate = (to.truthC - from.truthC) / (to.timeS - from.timeS);
+        double averageRate = (averageC[i] - averageC[i - span]) / (reading.timeS - readings[i - span].timeS);
+
+        averageSquares += std::pow(averageC[i] - reading.truthC, 2);
+        filterSquares += std::pow((double)filter.getTemperature() - reading.truthC, 2);
+        averageRateSquares += std::pow(averageRate - truthRate, 2);
+        filterRateSquares += std::pow((double)filter.getRate() - truthRate, 2);
+        count++;
+    }
+
+    double averageRms = std::sqrt(averageSquares / (double)count);
+    double filterRms = std::sqrt(filterSquares / (double)count);
+    double averageRateRms = std::sqrt(averageRateSquares / (double)count);
+    double filterRateRms = std::sqrt(filterRateSquares / (double)count);
+
+    printf("%zu cycles: moving average RMS %.3f °C, rate %.4f °C/s; filter RMS %.3f °C, rate %.4f °C/s\n",
+           readings.size(), averageRms, averageRateRms, filterRms, filterRateRms);
+    printf("Fixed point against double: %.4f °C, %.5f °C/s at most\n", worstError, worstRateError);
+
+    CHECK(worstError <= KALMAN_TEST_MAX_FIXED_POINT_ERROR_C);
+    CHECK(worstRateError <= KALMAN_TEST_MAX_FIXED_POINT_RATE_ERROR);
+    CHECK(filterRms < averageRms);
+    // The rate is what the filter is for: the moving average's difference only moves in steps of one count
+    CHECK(filterRateRms < averageRateRms / 2);
+
+    return check::result();
+}
@@ -0,0 +1,129 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "CommandChannel.h"
+#include <cstring>
+
+typedef enum {
+    COMMAND_PAYLOAD_NONE,
+    COMMAND_PAYLOAD_FLOAT,
+    COMMAND_PAYLOAD_INT,
+    COMMAND_PAYLOAD_UNKNOWN,
+} CommandPayloadKind;
+
+static CommandPayloadKind payloadKind(SystemControllerCommandType type) {
+    switch (type) {
+        case COMMAND_SET_FLOW_MODE:
+        case COMMAND_START_AUTOTUNE:
+            return COMMAND_PAYLOAD_INT;
+        case COMMAND_SET_BREW_SET_POINT_CORRECTION:
+            return COMMAND_PAYLOAD_FLOAT;
+        case COMMAND_UNBAIL:
+        case COMMAND_TRIGGER_FIRST_RUN:
+        case COMMAND_BEGIN:
+        case COMMAND_FORCE_HARD_BAIL:
+        case COMMAND_CANCEL_AUTOTUNE:
+            return COMMAND_PAYLOAD_NONE;
+    }
+
+    return COMMAND_PAYLOAD_UNKNOWN;
+}
+
+size_t CommandChannel::encodedSize(SystemControllerCommandType type) {
+    switch (payloadKind(type)) {
+        case COMMAND_PAYLOAD_NONE:
+            return 1;
+        case COMMAND_PAYLOAD_FLOAT:
+            return 1 + sizeof(float);
+        case COMMAND_PAYLOAD_INT:
+            return 1 + sizeof(uint32_t);
+        case COMMAND_PAYLOAD_UNKNOWN:
+            break;
+    }
+
+    return 0;
+}
+
+size_t CommandChannel::encode(const SystemControllerCommand &command, uint8_t *buffer) {
+    buffer[0] = (uint8_t)command.type;
+    uint8_t *payload = buffer + 1;
+
+    switch (payloadKind(command.type)) {
+        case COMMAND_PAYLOAD_NONE:
+            break;
+        case COMMAND_PAYLOAD_FLOAT:
+            memcpy(payload, &command.float1, sizeof(float));
+            break;
+        case COMMAND_PAYLOAD_INT:
+            memcpy(payload, &command.int1, sizeof(uint32_t));
+            break;
+        case COMMAND_PAYLOAD_UNKNOWN:
+            return 0;
+    }
+
+    return encodedSize(command.type);
+}
+
+void CommandChannel::decode(const uint8_t *buffer, SystemControllerCommand *command) {
+    *command = SystemControllerCommand{.type = (SystemControllerCommandType)buffer[0]};
+    const uint8_t *payload = buffer + 1;
+
+    switch (payloadKind(command->type)) {
+        case COMMAND_PAYLOAD_NONE:
+        case COMMAND_PAYLOAD_UNKNOWN:
+            break;
+        case COMMAND_PAYLOAD_FLOAT:
+            memcpy(&command->float1, payload, sizeof(float));
+            break;
+        case COMMAND_PAYLOAD_INT:
+            memcpy(&command->int1, payload, sizeof(uint32_t));
+            break;
+    }
+}
+
+bool CommandChannel::tryPush(const SystemControllerCommand &command) {
+    return tryPushBatch(&command, 1);
+}
+
+bool CommandChannel::tryPushBatch(const SystemControllerCommand *commands, size_t count) {
+    uint8_t buffer[COMMAND_CHANNEL_SIZE];
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t size = encodedSize(commands[i].type);
+
+        if (size == 0 || length + size > ring.writeAvailable()) {
+            return false;
+        }
+
+        length += encode(commands[i], buffer + length);
+    }
+
+    // We're the only producer, so the free space can only have grown since we checked it
+    return ring.writeBuff(buffer, length) == length;
+}
+
+size_t CommandChannel::popBatch(SystemControllerCommand *commands, size_t maxCount) {
+    uint8_t buffer[maxEncodedSize];
+    size_t count = 0;
+
+    while (count < maxCount) {
+        uint8_t *tag = ring.peek();
+        if (tag == nullptr) {
+            break;
+        }
+
+        size_t size = encodedSize((SystemControllerCommandType)*tag);
+        if (size == 0 || ring.readAvailable() < size) {
+            // Can't happen unless the producer is broken, and there's no way to find the next command boundary.
+            ring.consumerClear();
+            break;
+        }
+
+        ring.readBuff(buffer, size);
+        decode(buffer, &commands[count++]);
+    }
+
+    return count;
+}
@@ -0,0 +1,47 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_COMMANDCHANNEL_H
+#define SMART_LCC_COMMANDCHANNEL_H
+
+#include <ringbuffer.hpp>
+#include "types.h"
+
+#define COMMAND_CHANNEL_SIZE 512
+
+/*
+ * Carries SystemControllerCommands from Core 1 to Core 0 over a lock free single producer, single consumer byte ring.
+ *
+ * On the wire every command is a one byte type tag followed by only the payload that type uses: nothing for unbail, a
+ * float for the set point correction, an int for the flow mode or the boiler to autotune. A whole command (or a whole
+ * batch of them) is published with a single index update, so the consumer never sees half of one.
+ *
+ * Pushing never blocks. If there's no room the push fails and the command is not enqueued at all; it's up to the
+ * caller whether to drop it, retry later or report it.
+ */
+class CommandChannel {
+public:
+    bool tryPush(const SystemControllerCommand &command);
+
+    // Either all of the commands are enqueued or none of them are
+    bool tryPushBatch(const SystemControllerCommand *commands, size_t count);
+
+    // Dequeues up to maxCount commands, returning how many were dequeued
+    size_t popBatch(SystemControllerCommand *commands, size_t maxCount);
+
+    inline bool isEmpty() const { return ring.isEmpty(); }
+    inline size_t getLevel() const { return ring.readAvailable(); }
+
+    // Size of a single encoded command, tag included. 0 for an unknown type.
+    static size_t encodedSize(SystemControllerCommandType type);
+    static constexpr size_t maxEncodedSize = 1 + (sizeof(float) > sizeof(uint32_t) ? sizeof(float) : sizeof(uint32_t));
+private:
+    jnk0le::Ringbuffer<uint8_t, COMMAND_CHANNEL_SIZE> ring;
+
+    static size_t encode(const SystemControllerCommand &command, uint8_t *buffer);
+    static void decode(const uint8_t *buffer, SystemControllerCommand *command);
+};
+
+
+#endif //SMART_LCC_COMMANDCHANNEL_H
@@ -0,0 +1,81 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "ControlBoardReceiver.h"
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+ControlBoardFramer ControlBoardReceiver::framer = {};
+ControlBoardRawPacket ControlBoardReceiver::packet = {};
+uart_inst_t* ControlBoardReceiver::interruptedUart = nullptr;
+volatile bool ControlBoardReceiver::packetComplete = false;
+absolute_time_t ControlBoardReceiver::packetReceivedAt = nil_time;
+
+void ControlBoardReceiver::initInterrupts(uart_inst_t *uart) {
+    ControlBoardReceiver::interruptedUart = uart;
+
+    uart_set_fifo_enabled(uart, false);
+
+    int UART_IRQ = uart == uart0 ? UART0_IRQ : UART1_IRQ;
+
+    irq_set_exclusive_handler(UART_IRQ, ControlBoardReceiver::onUartRx);
+    irq_set_enabled(UART_IRQ, true);
+
+    // RX only, we transmit blocking
+    uart_set_irq_enables(uart, true, false);
+}
+
+void ControlBoardReceiver::onUartRx() {
+    if (ControlBoardReceiver::interruptedUart == nullptr) {
+        return;
+    }
+
+    while (uart_is_readable(ControlBoardReceiver::interruptedUart)) {
+        uint8_t ch = uart_getc(ControlBoardReceiver::interruptedUart);
+        uint32_t checksumErrors = framer.getChecksumErrorCount();
+
+        // Only the first packet after clear() is taken as the reply
+        if (framer.push(ch)) {
+            complete(framer.getFrame());
+        } else if (framer.getChecksumErrorCount() != checksumErrors) {
+            complete(framer.getRejectedFrame());
+        }
+    }
+}
+
+void ControlBoardReceiver::complete(const ControlBoardRawPacket &received) {
+    if (packetComplete) {
+        return;
+    }
+
+    packet = received;
+    packetReceivedAt = get_absolute_time();
+    __compiler_memory_barrier();
+    packetComplete = true;
+
+    // Wake up waitForPacket()
+    __sev();
+}
+
+void ControlBoardReceiver::clear() {
+    uint32_t status = save_and_disable_interrupts();
+    framer.reset();
+    packetComplete = false;
+    restore_interrupts(status);
+}
+
+bool ControlBoardReceiver::waitForPacket(ControlBoardRawPacket *received, absolute_time_t timeout) {
+    while (!packetComplete) {
+        if (best_effort_wfe_or_timeout(timeout)) {
+            break;
+        }
+    }
+
+    if (!packetComplete) {
+        return false;
+    }
+
+    *received = packet;
+    return true;
+}
@@ -0,0 +1,49 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_CONTROLBOARDRECEIVER_H
+#define SMART_LCC_CONTROLBOARDRECEIVER_H
+
+#include <hardware/uart.h>
+#include <pico/time.h>
+#include "Controller/Core0/Protocol/control_board_protocol.h"
+#include "Controller/Core0/Util/ControlBoardFramer.h"
+
+/*
+ * Interrupt driven receive side of the control board UART.
+ *
+ * The RX interrupt feeds every byte through a ControlBoardFramer. Once that has a complete, valid packet the
+ * interrupt timestamps it and signals an event, so Core 0 can sleep in waitForPacket() instead of spinning on the
+ * UART for most of the cycle. Line noise or a reply that starts mid packet costs nothing but the dropped bytes.
+ *
+ * A complete packet with a bad checksum is still the control board's reply. It's handed out as such, so that decoding
+ * reports an invalid packet rather than no reply at all.
+ */
+class ControlBoardReceiver {
+public:
+    static void initInterrupts(uart_inst_t *uart);
+
+    // Drops any partial or unclaimed packet. Call before sending the packet we expect a reply to.
+    static void clear();
+
+    // Sleeps until a full packet has been received or the timeout is reached
+    static bool waitForPacket(ControlBoardRawPacket *received, absolute_time_t timeout);
+
+    // When the last byte of the most recent complete packet arrived
+    static inline absolute_time_t getPacketReceivedAt() { return packetReceivedAt; }
+
+    static inline uint32_t getResyncCount() { return framer.getResyncCount(); }
+private:
+    static void onUartRx();
+    static void complete(const ControlBoardRawPacket &received);
+
+    static ControlBoardFramer framer;
+    static ControlBoardRawPacket packet;
+    static uart_inst_t *interruptedUart;
+    static volatile bool packetComplete;
+    static absolute_time_t packetReceivedAt;
+};
+
+
+#endif //SMART_LCC_CONTROLBOARDRECEIVER_H
@@ -17,6 +17,8 @@ typedef enum : uint16_t {
     CONTROL_BOARD_VALIDATION_ERROR_HIGH_AND_LOW_GAIN_SERVICE_BOILER_TEMP_TOO_DIFFERENT = 1 << 4,
     CONTROL_BOARD_VALIDATION_ERROR_BREW_BOILER_TEMP_DANGEROUSLY_HIGH = 1 << 5,
     CONTROL_BOARD_VALIDATION_ERROR_SERVICE_BOILER_TEMP_DANGEROUSLY_HIGH = 1 << 6,
+    CONTROL_BOARD_VALIDATION_ERROR_BREW_BOILER_SENSOR_FAULT = 1 << 7,
+    CONTROL_BOARD_VALIDATION_ERROR_SERVICE_BOILER_SENSOR_FAULT = 1 << 8,
 } ControlBoardPacketValidationError;
 
 struct ControlBoardRawPacket {
@@ -30,16 +32,30 @@ struct ControlBoardRawPacket {
     uint8_t checksum{};
 };
 
-struct ControlBoardParsedPacket {
-    bool brew_switch;
-    bool water_tank_empty;
-    bool service_boiler_low;
-    float brew_boiler_temperature;
-    float service_boiler_temperature;
+/*
+ * Everything the system controller needs from a control board packet, decoded in a single pass.
+ */
+struct ControlBoardDecodedPacket {
+    uint16_t validation_errors = CONTROL_BOARD_VALIDATION_ERROR_NONE; // ControlBoardPacketValidationError flags
+
+    bool brew_switch = false;
+    bool water_tank_empty = false;
+    bool service_boiler_low = false;
+
+    uint16_t brew_boiler_temperature_low_gain_raw = 0;
+    uint16_t service_boiler_temperature_low_gain_raw = 0;
+    uint16_t brew_boiler_temperature_high_gain_raw = 0;
+    uint16_t service_boiler_temperature_high_gain_raw = 0;
+    uint16_t service_boiler_level_raw = 0;
+
+    // High gain channels, these are the ones used for control
+    float brew_boiler_temperature = 0.f;
+    float service_boiler_temperature = 0.f;
+
+    float brew_boiler_temperature_low_gain = 0.f;
+    float service_boiler_temperature_low_gain = 0.f;
 };
 
-uint16_t validate_raw_packet(ControlBoardRawPacket packet);
-ControlBoardParsedPacket convert_raw_control_board_packet(ControlBoardRawPacket raw_packet);
-ControlBoardRawPacket convert_parsed_control_board_packet(ControlBoardParsedPacket parsed_packet);
+ControlBoardDecodedPacket decode_control_board_packet(const ControlBoardRawPacket &raw_packet);
 
 #endif //LCC_RELAY_CONTROL_BOARD_PROTOCOL_H
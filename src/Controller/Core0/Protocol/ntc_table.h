@@ -0,0 +1,127 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_NTC_TABLE_H
+#define SMART_LCC_NTC_TABLE_H
+
+#include <cstdint>
+#include <array>
+#include "utils/FixedPoint.h"
+#include "utils/constexpr_math.h"
+
+/*
+ * Compile time lookup tables for the NTC channels of the control board.
+ *
+ * High gain: ADC value -> resistance (fitted curve) -> temperature (B parameter equation).
+ * Low gain: The older third degree polynomial fit, straight from ADC value to temperature.
+ *
+ * Both are sampled every NTC_TABLE_STEP ADC counts and stored as Q16.16 degrees Celsius. Lookups interpolate linearly
+ * between entries. Between 15 and 140 °C, the error against the double precision formulas is below 0.01 °C, and
+ * against the float pow/log decoding the tables replaced below 0.05 °C (see sim/tests/NtcTableTest.cpp).
+ *
+ * The high gain fitted curve is only defined for ADC values in [NTC_ADC_MIN, NTC_ADC_MAX]. Anything outside of that
+ * means an open or shorted sensor, and is reported as such.
+ */
+
+#define NTC_TABLE_STEP_BITS 2
+#define NTC_TABLE_STEP (1 << NTC_TABLE_STEP_BITS)
+#define NTC_TABLE_SIZE ((1024 >> NTC_TABLE_STEP_BITS) + 1)
+
+#define NTC_ADC_MIN 2
+#define NTC_ADC_MAX 1018
+
+#define NTC_R25 50000
+#define NTC_B 4018
+
+namespace ntc_detail {
+    constexpr double high_gain_adc_to_ohm(double adc) {
+        return 7181.23 * constexpr_math::pow(-(adc - 1018.15) / (adc - 1.56789), (8000. / 8043.));
+    }
+
+    constexpr double ntc_ohm_to_celsius(double ohm, double r25, double b) {
+        return (1. / (constexpr_math::log(ohm / r25) / b + (1. / 298.15))) - 273.15;
+    }
+
+    constexpr double low_gain_adc_to_celsius(double adc) {
+        return -1.99514E-07 * adc * adc * adc + 7.66659E-05 * adc * adc + 0.546325171 * adc - 17.22637553;
+    }
+
+    constexpr std::array<int32_t, NTC_TABLE_SIZE> generate_high_gain_table() {
+        std::array<int32_t, NTC_TABLE_SIZE> table{};
+
+        for (int i = 0; i < NTC_TABLE_SIZE; ++i) {
+            int adc = i * NTC_TABLE_STEP;
+
+            // Entries outside of the defined range are only ever used to interpolate values just inside of it
+            if (adc < NTC_ADC_MIN) {
+                adc = NTC_ADC_MIN;
+            } else if (adc > NTC_ADC_MAX) {
+                adc = NTC_ADC_MAX;
+            }
+
+            table[i] = Q16_16(ntc_ohm_to_celsius(high_gain_adc_to_ohm(adc), NTC_R25, NTC_B)).getRaw();
+        }
+
+        return table;
+    }
+
+    constexpr std::array<int32_t, NTC_TABLE_SIZE> generate_low_gain_table() {
+        std::array<int32_t, NTC_TABLE_SIZE> table{};
+
+        for (int i = 0; i < NTC_TABLE_SIZE; ++i) {
+            table[i] = Q16_16(low_gain_adc_to_celsius(i * NTC_TABLE_STEP)).getRaw();
+        }
+
+        return table;
+    }
+
+    constexpr std::array<int32_t, NTC_TABLE_SIZE> high_gain_table = generate_high_gain_table();
+    constexpr std::array<int32_t, NTC_TABLE_SIZE> low_gain_table = generate_low_gain_table();
+
+    inline Q16_16 interpolate(const std::array<int32_t, NTC_TABLE_SIZE> &table, uint16_t adc) {
+        if (adc > 1023) {
+            adc = 1023;
+        }
+
+        uint16_t index = adc >> NTC_TABLE_STEP_BITS;
+        int32_t remainder = adc & (NTC_TABLE_STEP - 1);
+
+        int32_t low = table[index];
+        int32_t high = table[index + 1];
+
+        return Q16_16::fromRaw(low + (int32_t)(((int64_t)(high - low) * remainder) >> NTC_TABLE_STEP_BITS));
+    }
+}
+
+inline bool high_gain_adc_is_valid(uint16_t adc) {
+    return adc >= NTC_ADC_MIN && adc <= NTC_ADC_MAX;
+}
+
+// Only meaningful if high_gain_adc_is_valid(adc)
+inline Q16_16 high_gain_adc_to_celsius(uint16_t adc) {
+    if (adc < NTC_ADC_MIN) {
+        adc = NTC_ADC_MIN;
+    } else if (adc > NTC_ADC_MAX) {
+        adc = NTC_ADC_MAX;
+    }
+
+    return ntc_detail::interpolate(ntc_detail::high_gain_table, adc);
+}
+
+inline Q16_16 low_gain_adc_to_celsius(uint16_t adc) {
+    return ntc_detail::interpolate(ntc_detail::low_gain_table, adc);
+}
+
+// How many °C one ADC count is worth at a reading, i.e. how finely the channel resolves the temperature there
+inline Q16_16 high_gain_adc_resolution(uint16_t adc) {
+    Q16_16 step = high_gain_adc_to_celsius(adc + 1) - high_gain_adc_to_celsius(adc);
+    return step < Q16_16(0) ? -step : step;
+}
+
+inline Q16_16 low_gain_adc_resolution(uint16_t adc) {
+    Q16_16 step = low_gain_adc_to_celsius(adc + 1) - low_gain_adc_to_celsius(adc);
+    return step < Q16_16(0) ? -step : step;
+}
+
+#endif //SMART_LCC_NTC_TABLE_H
@@ -8,28 +8,31 @@
 #include "pico/timeout_helper.h"
 #include <cmath>
 #include <hardware/timer.h>
-#include "utils/UartReadBlockingTimeout.h"
-#include "utils/ClearUartCruft.h"
+#include "ControlBoardReceiver.h"
+#include "Controller/Core0/Protocol/ntc_table.h"
 #include "utils/USBDebug.h"
 
 SystemController::SystemController(
         uart_inst_t * _uart,
-        PicoQueue<SystemControllerStatusMessage> *outgoingQueue,
-        PicoQueue<SystemControllerCommand> *incomingQueue)
+        SeqlockMailbox<SystemControllerStatusMessage> *outgoingMailbox,
+        CommandChannel *incomingChannel,
+        SeqlockMailbox<SettingStruct> *settingsMailbox)
         :
         uart(_uart),
-        outgoingQueue(outgoingQueue),
-        incomingQueue(incomingQueue),
-        brewBoilerController(20, 20.0f, PidSettings{}, 2.0f),
-        serviceBoilerController(20, 0.5f)
+        outgoingMailbox(outgoingMailbox),
+        incomingChannel(incomingChannel),
+        settingsMailbox(settingsMailbox),
+        brewBoilerController(20, 20.0f, PidSettings{}, 2.0f, 0.1f),
+        serviceBoilerController(20, 20.0f, PidSettings{}, 0.5f, 0.1f)
         {
+    ControlBoardReceiver::initInterrupts(uart);
     safeLccRawPacket = create_safe_packet();
     currentLccParsedPacket = LccParsedPacket();
     settings = new SystemSettings();
 }
 
 void SystemController::sendSafePacketNoWait() {
-    uart_clear_cruft(uart);
+    ControlBoardReceiver::clear();
     uart_write_blocking(uart, (uint8_t *) &safeLccRawPacket, sizeof(safeLccRawPacket));
 }
 
@@ -43,25 +46,79 @@ void SystemController::loop() {
 
         handleCommands();
 
+        // Start running cycles from scratch once we're started, rather than as hopelessly late
+        cycleScheduler.restart();
+
         return;
     }
 
-    uart_clear_cruft(uart);
+    cycleScheduler.waitForNextCycle();
+    cycleStartedAt = get_absolute_time();
+
+    stageTimer.begin(PIPELINE_STAGE_INGEST);
+    bool received = ingest();
+    stageTimer.end();
+
+    stageTimer.begin(PIPELINE_STAGE_DECODE);
+    ControlBoardDecodedPacket decodedPacket = decode(received);
+    stageTimer.end();
+
+    if (!isBailed()) {
+        stageTimer.begin(PIPELINE_STAGE_ESTIMATE);
+        estimate(currentControlBoardPacket);
+        stageTimer.end();
+
+        stageTimer.begin(PIPELINE_STAGE_CONTROL);
+        ControlDemand demand = control(currentControlBoardPacket);
+        stageTimer.end();
+
+        stageTimer.begin(PIPELINE_STAGE_ARBITRATE);
+        currentLccParsedPacket = arbitrate(demand);
+        stageTimer.end();
+    } else {
+        currentLccParsedPacket = convert_lcc_raw_to_parsed(safeLccRawPacket);
+
+        stageTimer.record(PIPELINE_STAGE_ESTIMATE, 0);
+        stageTimer.record(PIPELINE_STAGE_CONTROL, 0);
+        stageTimer.record(PIPELINE_STAGE_ARBITRATE, 0);
+    }
+
+    cycleScheduler.markControlDone();
+
+    stageTimer.begin(PIPELINE_STAGE_EMIT);
+    emit(decodedPacket);
+    stageTimer.end();
+}
+
+bool SystemController::ingest() {
+    // Commands go first, so e.g. a forced bail already applies to the packet we're about to send
+    handleCommands();
+
+    ControlBoardReceiver::clear();
+    cycleScheduler.markTxStarted();
     sendLccPacket();
 
-    // This timeout is used both as a timeout for reading from the UART and to know when to send the next packet.
-    auto timeout = make_timeout_time_ms(100); // default 100
+    absolute_time_t lccPacketSentAt = get_absolute_time();
 
-    bool success = uart_read_blocking_timeout(uart, reinterpret_cast<uint8_t *>(&currentControlBoardRawPacket),
-                                              sizeof(currentControlBoardRawPacket), timeout);
+    // The reply has to be in before the next cycle is due
+    bool received = ControlBoardReceiver::waitForPacket(&currentControlBoardRawPacket, cycleScheduler.getCycleDeadline());
 
-    if (!success) {
+    // Core 0 sleeps while the reply trickles in
+    cycleIdleUs = absolute_time_diff_us(lccPacketSentAt, get_absolute_time());
+    cycleScheduler.markRxCompleted(received ? ControlBoardReceiver::getPacketReceivedAt() : get_absolute_time());
+
+    return received;
+}
+
+ControlBoardDecodedPacket SystemController::decode(bool received) {
+    if (!received) {
         softBail(BAIL_REASON_CB_UNRESPONSIVE);
     }
 
-    uint16_t cbValidation = validate_raw_packet(currentControlBoardRawPacket);
+    ControlBoardDecodedPacket decodedPacket = decode_control_board_packet(currentControlBoardRawPacket);
+    uint16_t cbValidation = decodedPacket.validation_errors;
 
-    if (success && cbValidation != CONTROL_BOARD_VALIDATION_ERROR_NONE ) {
+    if (received && cbValidation != CONTROL_BOARD_VALIDATION_ERROR_NONE ) {
         USB_PRINTF("Received packet, validation: %u:\n", cbValidation);
         USB_PRINT_BUF(reinterpret_cast<uint8_t *>(&currentControlBoardRawPacket), sizeof(currentControlBoardRawPacket));
         USB_PRINTF("\n");
@@ -73,7 +130,7 @@ void SystemController::loop() {
 
     if (isBailed()) {
         if (isSoftBailed()) {
-            if (!success) {
+            if (!received) {
                 unbailTimer.reset();
             } else if (!unbailTimer.has_value()) {
                 unbailTimer = get_absolute_time();
@@ -82,25 +139,18 @@ void SystemController::loop() {
             }
         }
     } else if (internalState == RUNNING) {
-        currentControlBoardParsedPacket = convert_raw_control_board_packet(currentControlBoardRawPacket);
+        currentControlBoardPacket = decodedPacket;
 
         handleRunningStateAutomations();
     }
 
-    uint16_t sbLow = triplet_to_int(currentControlBoardRawPacket.service_boiler_temperature_low_gain);
-    uint16_t sbHi = triplet_to_int(currentControlBoardRawPacket.service_boiler_temperature_high_gain);
-
     // Reset the current raw packet.
     currentControlBoardRawPacket = ControlBoardRawPacket();
 
-    handleCommands();
-
-    if (!isBailed()) {
-        currentLccParsedPacket = handleControlBoardPacket(currentControlBoardParsedPacket);
-    } else {
-        currentLccParsedPacket = convert_lcc_raw_to_parsed(safeLccRawPacket);
-    }
+    return decodedPacket;
+}
 
+void SystemController::emit(const ControlBoardDecodedPacket &decodedPacket) {
     float sleepSeconds = plannedAutoSleepAt.has_value() ? (float)(absolute_time_diff_us(get_absolute_time(), plannedAutoSleepAt.value())) / 1000.f / 1000.f : INFINITY;
     if (sleepSeconds < 0) {
         sleepSeconds = 0.f;
@@ -108,11 +158,13 @@ void SystemController::loop() {
 
     SystemControllerStatusMessage message = {
             .timestamp = get_absolute_time(),
-            .brewTemperature = static_cast<float>(brewTempAverage.average()),
-            .offsetBrewTemperature = static_cast<float>(brewTempAverage.average()) + settings->getBrewTemperatureOffset(),
+            .brewTemperature = static_cast<float>(controlledBrewTemperature()),
+            .offsetBrewTemperature = static_cast<float>(controlledBrewTemperature()) + settings->getBrewTemperatureOffset(),
+            .brewTemperatureRate = static_cast<float>(brewTemperatureFilter.getRate()),
             .brewTemperatureOffset = settings->getBrewTemperatureOffset(),
-            .brewSetPoint = settings->getTargetBrewTemp(),
-            .offsetBrewSetPoint = settings->getTargetBrewTemp() + settings->getBrewTemperatureOffset(),
+            .brewSetPoint = brewSetPoint(),
+            .offsetBrewSetPoint = brewSetPoint() + settings->getBrewTemperatureOffset(),
+            .brewSetPointCorrection = brewSetPointCorrection,
             .brewPidSettings = settings->getBrewPidParameters(),
             .brewPidParameters = brewPidRuntimeParameters,
             .serviceTemperature = static_cast<float>(serviceTempAverage.average()),
@@ -127,24 +179,27 @@ void SystemController::loop() {
             .runState = runState,
             .coalescedState = externalState(),
             .bailReason = bail_reason,
-            .currentlyBrewing = !isBailed() && currentControlBoardParsedPacket.brew_switch,
+            .currentlyBrewing = !isBailed() && currentControlBoardPacket.brew_switch,
             .currentlyFillingServiceBoiler = currentLccParsedPacket.pump_on &&
                                              currentLccParsedPacket.service_boiler_solenoid_open,
-            .waterTankLow = !isBailed() && currentControlBoardParsedPacket.water_tank_empty,
+            .waterTankLow = !isBailed() && currentControlBoardPacket.water_tank_empty,
 //            .autoSleepMinutes = settings->getAutoSleepMin(),
 //            .plannedSleepInSeconds = sleepSeconds,
 //            .lastSleepModeExitAt = lastSleepModeExitAt,
             .bailCounter = bailCounter,
-            .sbRawHi = sbHi,
-            .sbRawLo = sbLow,
+            .sbRawHi = decodedPacket.service_boiler_temperature_high_gain_raw,
+            .sbRawLo = decodedPacket.service_boiler_temperature_low_gain_raw,
             .flowMode = flowMode,
+            .cycleBusyUs = (uint32_t)(absolute_time_diff_us(cycleStartedAt, get_absolute_time()) - cycleIdleUs),
+            .cbResyncCount = ControlBoardReceiver::getResyncCount(),
+            .cycleTiming = cycleScheduler.getStats(),
+            .pipelineTiming = stageTimer.getStats(),
+            .autoTune = autoTuner.getStatus(),
+            .brewPlantModel = brewPlantEstimator.getEstimate(),
+            .servicePlantModel = servicePlantEstimator.getEstimate(),
     };
 
-    if (!outgoingQueue->isFull()) {
-        outgoingQueue->tryAdd(&message);
-    }
-
-    sleep_until(timeout);
+    outgoingMailbox->publish(message);
 }
 
 void SystemController::sendLccPacket() {
@@ -179,104 +234,154 @@ void SystemController::updateForFlowMode(LccParsedPacket *parsedPacket) {
     }
 }
 
-LccParsedPacket SystemController::handleControlBoardPacket(ControlBoardParsedPacket latestParsedPacket) {
-    LccParsedPacket lcc;
-
-    waterTankEmptyLatch.set(latestParsedPacket.water_tank_empty);
-    serviceBoilerLowLatch.set(latestParsedPacket.service_boiler_low);
-
-    brewTempAverage.addValue(latestParsedPacket.brew_boiler_temperature);
-    serviceTempAverage.addValue(latestParsedPacket.service_boiler_temperature);
+void SystemController::estimate(const ControlBoardDecodedPacket &latestPacket) {
+    waterTankEmptyLatch.set(latestPacket.water_tank_empty);
+    serviceBoilerLowLatch.set(latestPacket.service_boiler_low);
+
+    brewTempAverage.addValue(Q16_16(latestPacket.brew_boiler_temperature));
+    serviceTempAverage.addValue(Q16_16(latestPacket.service_boiler_temperature));
+
+    auto now = get_absolute_time();
+    Q16_16 dT = lastEstimateAt.has_value() ? Q16_16::fromRatio(absolute_time_diff_us(lastEstimateAt.value(), now), 1000000) : Q16_16();
+    lastEstimateAt = now;
+
+    // Runs whether or not the controller uses it, so switching over doesn't start it from scratch
+    brewTemperatureFilter.update(
+            high_gain_adc_to_celsius(latestPacket.brew_boiler_temperature_high_gain_raw),
+            high_gain_adc_resolution(latestPacket.brew_boiler_temperature_high_gain_raw),
+            low_gain_adc_to_celsius(latestPacket.brew_boiler_temperature_low_gain_raw),
+            low_gain_adc_resolution(latestPacket.brew_boiler_temperature_low_gain_raw),
+            currentLccParsedPacket.brew_boiler_ssr_on,
+            dT
+            );
+
+    // The SSRs in the packet that just went out. Water coming in, for a brew or to fill the service boiler, is
+    // outside the plant model.
+    bool waterFlowing = currentLccParsedPacket.pump_on;
+    brewPlantEstimator.update(brewTempAverage.average(), currentLccParsedPacket.brew_boiler_ssr_on, waterFlowing);
+    servicePlantEstimator.update(serviceTempAverage.average(), currentLccParsedPacket.service_boiler_ssr_on, waterFlowing);
+}
 
-    bool brewing = false;
+SystemController::ControlDemand SystemController::control(const ControlBoardDecodedPacket &latestPacket) {
+    ControlDemand demand{};
 
     // If we're not already brewing, don't start a brew or fill the service boiler if there is no water in the tank
     if (!brewStartedAt.has_value()) {
         if (!waterTankEmptyLatch.get()) {
-            if (latestParsedPacket.brew_switch) {
-                updateForFlowMode(&lcc);
+            if (latestPacket.brew_switch) {
+                updateForFlowMode(&demand.lcc);
 
-                brewing = true;
+                demand.brewing = true;
 
                 onBrewStarted();
             } else if (serviceBoilerLowLatch.get()) { // Starting a brew has priority over filling the service boiler
-                lcc.pump_on = true;
-                lcc.water_line_solenoid_open = true;
-                lcc.service_boiler_solenoid_open = true;
+                demand.lcc.pump_on = true;
+                demand.lcc.water_line_solenoid_open = true;
+                demand.lcc.service_boiler_solenoid_open = true;
             }
         }
     } else { // If we are brewing, keep brewing even if there is no water in the tank
-        if (latestParsedPacket.brew_switch) {
-            updateForFlowMode(&lcc);
-            brewing = true;
+        if (latestPacket.brew_switch) {
+            updateForFlowMode(&demand.lcc);
+            demand.brewing = true;
         } else { // Filling the service boiler is not an option while brewing
             onBrewEnded();
         }
     }
 
-    /*
-     * New algorithm:
-     *
-     * Cap BB and SB at 25 respectively. Divide time into 25 x 100 ms slots.
-     *
-     * If BB + SB < 25: Both get what they want.
-     * Else: They get a proportional share of what they want.
-     *   I.e. if BB = 17 and SB = 13, BB gets round((17/(17+13))*25) = 14 and SB gets round((13/(17+13))*25) = 11.
-     */
-    if (ssrStateQueue.isEmpty()) {
-        float feedForward = 0.0f;
-        if (brewStartedAt.has_value()) {
-            feedForward = feedForwardK * ((float)absolute_time_diff_us(brewStartedAt.value(), get_absolute_time()) / 1000.f) + feedForwardM;
+    // From the flow mode as applied above. The pump also runs to fill the service boiler, but that water doesn't go
+    // through the brew boiler.
+    Q16_16 feedForward = brewFeedForward.update(
+            demand.brewing && demand.lcc.pump_on,
+            demand.brewing && demand.lcc.water_line_solenoid_open,
+            controlledBrewTemperature(),
+            serviceTempAverage.average(),
+            get_absolute_time()
+            );
+
+    auto brewPidParameters = brewGainScheduler.update(brewPidRegime(), get_absolute_time());
+    if (brewPidParameters.has_value()) {
+        brewBoilerController.setPidParameters(brewPidParameters.value());
+    }
+
+    // The packet that just went out, after power sharing
+    brewBoilerController.recordHeaterOutput(currentLccParsedPacket.brew_boiler_ssr_on);
+    demand.brewSignal = brewBoilerController.getControlSignal(
+            static_cast<float>(controlledBrewTemperature()),
+            static_cast<float>(feedForward),
+            shouldForceHysteresisForBrewBoiler()
+            );
+    serviceBoilerController.recordHeaterOutput(currentLccParsedPacket.service_boiler_ssr_on);
+    demand.serviceSignal = serviceBoilerController.getControlSignal(static_cast<float>(serviceTempAverage.average()));
+    demand.brewBoilerPriority = demand.brewing;
+
+    // The relay overrides the tuned boiler's controller. That one keeps running, but its integral only follows the
+    // relay's full on and off, so finishAutoTune() hands the boiler back at the relay's average duty.
+    if (runState == RUN_STATE_AUTOTUNE) {
+        bool tuningBrewBoiler = autoTuner.getStatus().boiler == AUTOTUNE_BOILER_BREW;
+        float value = static_cast<float>(tuningBrewBoiler ? controlledBrewTemperature() : serviceTempAverage.average());
+        uint8_t relaySignal = autoTuner.update(value, get_absolute_time()) ? ssrSlotPlanner.getSlotsPerWindow() : 0;
+
+        if (tuningBrewBoiler) {
+            demand.brewSignal = relaySignal;
+            demand.brewBoilerPriority = true;
+        } else {
+            demand.serviceSignal = relaySignal;
+            demand.serviceBoilerPriority = true;
+        }
+
+        if (!autoTuner.isRunning()) {
+            finishAutoTune();
         }
+    }
 
-        uint8_t bbSignal = brewBoilerController.getControlSignal(
-                brewTempAverage.average(),
-                brewing ? feedForward : 0.f,
-                shouldForceHysteresisForBrewBoiler()
-                );
-        uint8_t sbSignal = serviceBoilerController.getControlSignal(serviceTempAverage.average());
+//    printf("Raw signals. BB: %u SB: %u\n", demand.brewSignal, demand.serviceSignal);
 
-//        printf("Raw signals. BB: %u SB: %u\n", bbSignal, sbSignal);
+    brewPidRuntimeParameters = brewBoilerController.getRuntimeParameters();
+    servicePidRuntimeParameters = serviceBoilerController.getRuntimeParameters();
 
-        if (settings->getEcoMode()) {
-            sbSignal = 0;
-        }
+    return demand;
+}
 
-        // Power-sharing
-        if (bbSignal + sbSignal > 25) {
-            if (!brewing) {
+LccParsedPacket SystemController::arbitrate(const ControlDemand &demand) {
+    LccParsedPacket lcc = demand.lcc;
+    uint8_t bbSignal = demand.brewSignal;
+    uint8_t sbSignal = demand.serviceSignal;
+
+    if (settings->getEcoMode()) {
+        sbSignal = 0;
+    }
+
+    /*
+     * Power sharing:
+     *
+     * Cap BB and SB at 25 respectively, i.e. the number of 100 ms slots in a 2.5 s window they want to be on.
+     *
+     * If BB + SB < 25: Both get what they want.
+     * Else: If we're brewing the brew boiler gets everything it wants, otherwise it gets 75% of what it wants.
+     *       The service boiler gets the rest. When auto-tuning the service boiler, it's the other way around.
+     *
+     * This is recalculated every cycle, and the planner spreads the resulting on-slots evenly across the window,
+     * so a brew start or set point change is acted upon on the next slot.
+     */
+    if (bbSignal + sbSignal > 25) {
+        if (demand.serviceBoilerPriority) {
+            bbSignal = 25 - sbSignal;
+        } else {
+            if (!demand.brewBoilerPriority) {
                 // If we're brewing, prioritize the brew boiler fully
                 // Otherwise, give the brew boiler slightly less than 75% priority
                 bbSignal = floor((float)bbSignal * 0.75);
             }
             sbSignal = 25 - bbSignal;
         }
-
-        uint8_t noSignal = 25 - bbSignal - sbSignal;
-
-        //printf("Adding new controls to the queue. BB: %u SB: %u NB: %u\n", bbSignal, sbSignal, noSignal);
-
-        for (uint8_t i = 0; i < bbSignal; ++i) {
-            SsrState state = BREW_BOILER_SSR_ON;
-            ssrStateQueue.tryAdd(&state);
-        }
-
-        for (uint8_t i = 0; i < sbSignal; ++i) {
-            SsrState state = SERVICE_BOILER_SSR_ON;
-            ssrStateQueue.tryAdd(&state);
-        }
-
-        for (uint8_t i = 0; i < noSignal; ++i) {
-            SsrState state = BOTH_SSRS_OFF;
-            ssrStateQueue.tryAdd(&state);
-        }
     }
 
-    SsrState state;
-    if (!ssrStateQueue.tryRemove(&state)) {
-        hardBail(BAIL_REASON_SSR_QUEUE_EMPTY);
-        return lcc;
-    }
+    // Whatever power sharing (or the hysteresis controller, or the auto-tuner) made of its request
+    brewBoilerController.trackAppliedSignal(bbSignal);
+    serviceBoilerController.trackAppliedSignal(sbSignal);
+
+    SsrState state = ssrSlotPlanner.nextSlot(bbSignal, sbSignal);
 
     if (state == BREW_BOILER_SSR_ON) {
         lcc.brew_boiler_ssr_on = true;
@@ -284,94 +389,111 @@ LccParsedPacket SystemController::handleControlBoardPacket(ControlBoardParsedPac
         lcc.service_boiler_ssr_on = true;
     }
 
-    brewPidRuntimeParameters = brewBoilerController.getRuntimeParameters();
-    //servicePidRuntimeParameters = serviceBoilerController.getRuntimeParameters();
-
     return lcc;
 }
 
 void SystemController::handleCommands() {
-    SystemControllerCommand command;
-    //printf("Q: %u\n", incomingQueue->getLevelUnsafe());
-    while (!incomingQueue->isEmpty()) {
-        incomingQueue->removeBlocking(&command);
-
-        switch (command.type) {
-            case COMMAND_SET_BREW_SET_POINT:
-                settings->setTargetBrewTemp(command.float1);
-                break;
-            case COMMAND_SET_OFFSET_BREW_SET_POINT:
-                settings->setOffsetTargetBrewTemp(command.float1);
-                break;
-            case COMMAND_SET_BREW_OFFSET:
-                settings->setBrewTemperatureOffset(command.float1);
-                break;
-            case COMMAND_SET_BREW_PID_PARAMETERS:
-                settings->setBrewPidParameters(PidSettings{
-                    .Kp = command.float1,
-                    .Ki = command.float2,
-                    .Kd = command.float3,
-                    .windupLow = command.float4,
-                    .windupHigh = command.float5
-                });
-                break;
-            case COMMAND_SET_SERVICE_SET_POINT:
-                settings->setTargetServiceTemp(command.float1);
-                break;
-            case COMMAND_SET_SERVICE_PID_PARAMETERS:
-                settings->setServicePidParameters(PidSettings{
-                        .Kp = command.float1,
-                        .Ki = command.float2,
-                        .Kd = command.float3,
-                        .windupLow = command.float4,
-                        .windupHigh = command.float5
-                });
-                break;
-            case COMMAND_SET_ECO_MODE:
-                settings->setEcoMode(command.bool1);
-                break;
-            case COMMAND_SET_SLEEP_MODE:
-                setSleepMode(command.bool1);
-                break;
-            case COMMAND_SET_AUTO_SLEEP_MINUTES:
-                setAutoSleepMinutes(command.float1);
-                break;
-            case COMMAND_UNBAIL:
-                unbail();
-                break;
-            case COMMAND_TRIGGER_FIRST_RUN:
-                break;
-            case COMMAND_BEGIN:
-                internalState = RUNNING;
-                break;
-            case COMMAND_FORCE_HARD_BAIL:
-                hardBail(BAIL_REASON_FORCED);
-                break;
-            case COMMAND_SET_FLOW_MODE:
-                switch (command.int1) {
-                    case PUMP_ON_SOLENOID_OPEN:
-                        flowMode = PUMP_ON_SOLENOID_OPEN;
-                        break;
-                    case PUMP_OFF_SOLENOID_OPEN:
-                        flowMode = PUMP_OFF_SOLENOID_OPEN;
-                        break;
-                    case PUMP_ON_SOLENOID_CLOSED:
-                        flowMode = PUMP_ON_SOLENOID_CLOSED;
-                        break;
-                    case PUMP_OFF_SOLENOID_CLOSED:
-                        flowMode = PUMP_OFF_SOLENOID_CLOSED;
-                        break;
-                }
-                break;
+    applySettings();
+
+    SystemControllerCommand commands[8];
+    size_t count;
+    //printf("Q: %u\n", incomingChannel->getLevel());
+    while ((count = incomingChannel->popBatch(commands, 8)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            handleCommand(commands[i]);
         }
     }
 
     updateControllerSettings();
 }
 
+void SystemController::handleCommand(const SystemControllerCommand &command) {
+    switch (command.type) {
+        case COMMAND_UNBAIL:
+            unbail();
+            break;
+        case COMMAND_TRIGGER_FIRST_RUN:
+            break;
+        case COMMAND_BEGIN:
+            internalState = RUNNING;
+            break;
+        case COMMAND_FORCE_HARD_BAIL:
+            hardBail(BAIL_REASON_FORCED);
+            break;
+        case COMMAND_SET_FLOW_MODE:
+            switch (command.int1) {
+                case PUMP_ON_SOLENOID_OPEN:
+                    flowMode = PUMP_ON_SOLENOID_OPEN;
+                    break;
+                case PUMP_OFF_SOLENOID_OPEN:
+                    flowMode = PUMP_OFF_SOLENOID_OPEN;
+                    break;
+                case PUMP_ON_SOLENOID_CLOSED:
+                    flowMode = PUMP_ON_SOLENOID_CLOSED;
+                    break;
+                case PUMP_OFF_SOLENOID_CLOSED:
+                    flowMode = PUMP_OFF_SOLENOID_CLOSED;
+                    break;
+            }
+            break;
+        case COMMAND_START_AUTOTUNE:
+            switch (command.int1) {
+                case AUTOTUNE_BOILER_BREW:
+                    startAutoTune(AUTOTUNE_BOILER_BREW);
+                    break;
+                case AUTOTUNE_BOILER_SERVICE:
+                    startAutoTune(AUTOTUNE_BOILER_SERVICE);
+                    break;
+            }
+            break;
+        case COMMAND_CANCEL_AUTOTUNE:
+            abortAutoTune(AUTOTUNE_ABORT_CANCELLED);
+            break;
+        case COMMAND_SET_BREW_SET_POINT_CORRECTION:
+            setBrewSetPointCorrection(command.float1);
+            break;
+    }
+}
+
+void SystemController::applySettings() {
+    SettingStruct latest{};
+    uint32_t version;
+
+    // Only ever a complete set of settings, and at most one new version per cycle
+    if (!settingsMailbox->tryRead(&latest, &version) || version == settingsVersion) {
+        return;
+    }
+
+    bool wasSleeping = settings->getSleepMode();
+
+    settings->update(latest);
+    settingsVersion = version;
+
+    if (latest.ecoMode && runState == RUN_STATE_AUTOTUNE && autoTuner.getStatus().boiler == AUTOTUNE_BOILER_SERVICE) {
+        abortAutoTune(AUTOTUNE_ABORT_ECO_MODE);
+    }
+
+    if (latest.sleepMode && !wasSleeping) {
+        onSleepModeEntered();
+    } else if (!latest.sleepMode && wasSleeping) {
+        onSleepModeExited();
+    }
+}
+
 void SystemController::updateControllerSettings() {
-    brewBoilerController.setPidParameters(settings->getBrewPidParameters());
-    //serviceBoilerController.setPidParameters(servicePidParameters);
+    brewGainScheduler.updateSettings(settings->getBrewPidParameters(), settings->getBrewPidSchedule());
+    serviceBoilerController.setPidParameters(settings->getServicePidParameters());
+    brewBoilerController.setSmithPredictor(settings->getBrewSmithPredictor());
+    brewFeedForward.updateSettings(settings->getBrewFeedForward());
+    brewTemperatureFilter.configure(settings->getBrewTemperatureFilter());
+
+    if (brewSetPointCorrectedAt.has_value() && absolute_time_diff_us(brewSetPointCorrectedAt.value(), get_absolute_time()) > BREW_SET_POINT_CORRECTION_TIMEOUT_MS * 1000ll) {
+        setBrewSetPointCorrection(0.f);
+    }
+
+    // Suggested PID settings are for normal operation, whatever the controllers are doing right now
+    brewPlantEstimator.updateSetPoint(settings->getTargetBrewTemp());
+    servicePlantEstimator.updateSetPoint(settings->getTargetServiceTemp());
 
     if (settings->getSleepMode()) {
         brewBoilerController.updateSetPoint(70.f);
@@ -383,12 +505,14 @@ void SystemController::updateControllerSettings() {
         brewBoilerController.updateSetPoint(130.f);
         serviceBoilerController.updateSetPoint(settings->getTargetServiceTemp());
     } else {
-        brewBoilerController.updateSetPoint(settings->getTargetBrewTemp());
+        brewBoilerController.updateSetPoint(brewSetPoint());
         serviceBoilerController.updateSetPoint(settings->getTargetServiceTemp());
     }
 }
 
 void SystemController::softBail(SystemControllerBailReason reason) {
+    abortAutoTune(AUTOTUNE_ABORT_BAILED);
+
     if (!isBailed()) {
         bailCounter++;
     }
@@ -405,6 +529,8 @@ void SystemController::softBail(SystemControllerBailReason reason) {
 }
 
 void SystemController::hardBail(SystemControllerBailReason reason) {
+    abortAutoTune(AUTOTUNE_ABORT_BAILED);
+
     if (!isBailed()) {
         bailCounter++;
     }
@@ -430,6 +556,8 @@ SystemControllerCoalescedState SystemController::externalState() {
                 case RUN_STATE_HEATUP_STAGE_1:
                 case RUN_STATE_HEATUP_STAGE_2:
                     return SYSTEM_CONTROLLER_COALESCED_STATE_HEATUP;
+                case RUN_STATE_AUTOTUNE:
+                    return SYSTEM_CONTROLLER_COALESCED_STATE_AUTOTUNING;
                 case RUN_STATE_NORMAL:
                 default:
                     return areTemperaturesAtSetPoint() ? SYSTEM_CONTROLLER_COALESCED_STATE_WARM : SYSTEM_CONTROLLER_COALESCED_STATE_TEMPS_NORMALIZING;
@@ -448,22 +576,15 @@ void SystemController::unbail() {
     runState = RUN_STATE_UNDETEMINED;
     bail_reason = BAIL_REASON_NONE;
     unbailTimer.reset();
+    ssrSlotPlanner.reset();
+    brewPlantEstimator.restart();
+    brewTemperatureFilter.reset();
+    servicePlantEstimator.restart();
+    brewFeedForward.reset();
     USB_PRINTF("Unbailed\n");
 
 }
 
-void SystemController::setSleepMode(bool _sleepMode) {
-    if (_sleepMode) {
-        onSleepModeEntered();
-    } else {
-        onSleepModeExited();
-    }
-
-    settings->setSleepMode(_sleepMode);
-
-    updateControllerSettings();
-}
-
 void SystemController::initiateHeatup() {
     runState = RUN_STATE_HEATUP_STAGE_1;
     updateControllerSettings();
@@ -481,17 +602,88 @@ void SystemController::finishHeatup() {
     updateControllerSettings();
 }
 
+void SystemController::startAutoTune(AutoTuneBoiler boiler) {
+    if (runState == RUN_STATE_AUTOTUNE) {
+        return;
+    }
+
+    bool boilerDisabled = boiler == AUTOTUNE_BOILER_SERVICE && settings->getEcoMode();
+
+    if (internalState != RUNNING || runState != RUN_STATE_NORMAL || settings->getSleepMode() || brewStartedAt.has_value() || boilerDisabled) {
+        autoTuner.abort(AUTOTUNE_ABORT_NOT_READY);
+        return;
+    }
+
+    float setPoint = boiler == AUTOTUNE_BOILER_BREW ? settings->getTargetBrewTemp() : settings->getTargetServiceTemp();
+
+    autoTuner.start(boiler, setPoint, get_absolute_time());
+    runState = RUN_STATE_AUTOTUNE;
+
+    USB_PRINTF("Auto-tune started, boiler: %u, set point: %.1f\n", boiler, setPoint);
+}
+
+void SystemController::abortAutoTune(AutoTuneAbortReason reason) {
+    if (runState != RUN_STATE_AUTOTUNE) {
+        return;
+    }
+
+    autoTuner.abort(reason);
+    finishAutoTune();
+}
+
+void SystemController::finishAutoTune() {
+    runState = RUN_STATE_NORMAL;
+
+    // Aborted before the relay got through a measured cycle, that's nothing, and the integral starts over
+    auto slots = (uint8_t)lroundf(autoTuner.getAverageDuty() * (float)ssrSlotPlanner.getSlotsPerWindow());
+    if (autoTuner.getStatus().boiler == AUTOTUNE_BOILER_BREW) {
+        brewBoilerController.handOver(slots);
+    } else {
+        serviceBoilerController.handOver(slots);
+    }
+
+    updateControllerSettings();
+
+    USB_PRINTF("Auto-tune ended, state: %u, reason: %u\n", autoTuner.getStatus().state, autoTuner.getStatus().abortReason);
+}
+
+Q16_16 SystemController::controlledBrewTemperature() const {
+    if (settings->getBrewTemperatureFilter().enabled) {
+        return brewTemperatureFilter.getTemperature();
+    }
+
+    return brewTempAverage.average();
+}
+
+float SystemController::brewSetPoint() const {
+    return settings->getTargetBrewTemp() + brewSetPointCorrection;
+}
+
+void SystemController::setBrewSetPointCorrection(float correction) {
+    if (std::isnan(correction)) {
+        correction = 0.f;
+    }
+
+    if (correction == 0.f) {
+        brewSetPointCorrectedAt.reset();
+    } else {
+        brewSetPointCorrectedAt = get_absolute_time();
+    }
+
+    brewSetPointCorrection = std::fmin(std::fmax(correction, -BREW_SET_POINT_CORRECTION_LIMIT_C), BREW_SET_POINT_CORRECTION_LIMIT_C);
+}
+
 bool SystemController::areTemperaturesAtSetPoint() const {
-    float bbsplo = settings->getTargetBrewTemp() - 2.f;
-    float bbsphi = settings->getTargetBrewTemp() + 2.f;
+    float bbsplo = brewSetPoint() - 2.f;
+    float bbsphi = brewSetPoint() + 2.f;
     float sbsplo = settings->getTargetServiceTemp() - 4.f;
     float sbsphi = settings->getTargetServiceTemp() + 4.f;
 
-    if (currentControlBoardParsedPacket.brew_boiler_temperature < bbsplo || currentControlBoardParsedPacket.brew_boiler_temperature > bbsphi) {
+    if (currentControlBoardPacket.brew_boiler_temperature < bbsplo || currentControlBoardPacket.brew_boiler_temperature > bbsphi) {
         return false;
     }
 
-    if (!settings->getEcoMode() && (currentControlBoardParsedPacket.service_boiler_temperature < sbsplo || currentControlBoardParsedPacket.service_boiler_temperature > sbsphi)) {
+    if (!settings->getEcoMode() && (currentControlBoardPacket.service_boiler_temperature < sbsplo || currentControlBoardPacket.service_boiler_temperature > sbsphi)) {
         return false;
     }
 
@@ -501,6 +693,8 @@ bool SystemController::areTemperaturesAtSetPoint() const {
 void SystemController::onBrewStarted() {
     brewStartedAt = get_absolute_time();
 
+    abortAutoTune(AUTOTUNE_ABORT_BREW_STARTED);
+
 /*    // Starting a brew exits sleep mode
     if (settings->getSleepMode()) {
         // @todo This doesn't play nicely with the settings move
@@ -512,13 +706,24 @@ void SystemController::onBrewStarted() {
 
 void SystemController::onBrewEnded() {
     brewStartedAt.reset();
+    brewEndedAt = get_absolute_time();
 }
 
-void SystemController::setAutoSleepMinutes(float minutes) {
-/*    auto autoSleepMinutes = (uint16_t)minutes;
-    settings->setAutoSleepMin(autoSleepMinutes);
+PidRegime SystemController::brewPidRegime() const {
+    if (settings->getSleepMode()) {
+        return PID_REGIME_SLEEP;
+    }
 
-    resetPlannedSleep();*/
+    if (brewStartedAt.has_value()) {
+        return PID_REGIME_BREWING;
+    }
+
+    auto recoveryUs = (int64_t)(settings->getBrewPidSchedule().recoveryS * 1e6f);
+    if (brewEndedAt.has_value() && absolute_time_diff_us(brewEndedAt.value(), get_absolute_time()) < recoveryUs) {
+        return PID_REGIME_RECOVERY;
+    }
+
+    return PID_REGIME_IDLE;
 }
 
 void SystemController::updatePlannedAutoSleep() {
@@ -531,6 +736,8 @@ void SystemController::updatePlannedAutoSleep() {
 }
 
 void SystemController::onSleepModeEntered() {
+    abortAutoTune(AUTOTUNE_ABORT_SLEEP_MODE);
+
     if (runState == RUN_STATE_HEATUP_STAGE_2) {
         heatupStage2Timer.reset();
     }
@@ -543,13 +750,13 @@ void SystemController::onSleepModeExited() {
 
 void SystemController::handleRunningStateAutomations() {
     if (runState == RUN_STATE_UNDETEMINED) {
-        if (settings->getTargetBrewTemp() > 80 && currentControlBoardParsedPacket.brew_boiler_temperature < 65) {
+        if (settings->getTargetBrewTemp() > 80 && currentControlBoardPacket.brew_boiler_temperature < 65) {
             initiateHeatup();
         } else {
             runState = RUN_STATE_NORMAL;
         }
     } else if (runState == RUN_STATE_HEATUP_STAGE_1) {
-        if (currentControlBoardParsedPacket.brew_boiler_temperature > 128) {
+        if (currentControlBoardPacket.brew_boiler_temperature > 128) {
             transitionToHeatupStage2();
         }
     } else if (runState == RUN_STATE_HEATUP_STAGE_2) {
@@ -12,62 +12,70 @@
 #include "Controller/Core0/Util/TimedLatch.h"
 #include "Controller/Core0/Util/HysteresisController.h"
 #include "Controller/Core0/Util/HybridController.h"
+#include "Controller/Core0/Util/SsrSlotPlanner.h"
+#include "Controller/Core0/Util/CycleScheduler.h"
+#include "Controller/Core0/Util/StageTimer.h"
+#include "Controller/Core0/Util/RelayAutoTuner.h"
+#include "Controller/Core0/Util/FopdtEstimator.h"
+#include "Controller/Core0/Util/BrewFeedForward.h"
+#include "Controller/Core0/Util/PidGainScheduler.h"
+#include "Controller/Core0/Util/TemperatureKalmanFilter.h"
 #include <queue>
 #include <types.h>
 #include <hardware/uart.h>
 #include <hardware/gpio.h>
-#include <utils/PicoQueue.h>
+#include <CommandChannel.h>
 #include <utils/MovingAverage.h>
-
-class SsrStateQueueItem {
-public:
-    SsrState state = BOTH_SSRS_OFF;
-};
+#include <utils/SeqlockMailbox.h>
 
 class SystemController {
 public:
     explicit SystemController(
             uart_inst_t * _uart,
-            PicoQueue<SystemControllerStatusMessage> *outgoingQueue,
-            PicoQueue<SystemControllerCommand> *incomingQueue
+            SeqlockMailbox<SystemControllerStatusMessage> *outgoingMailbox,
+            CommandChannel *incomingChannel,
+            SeqlockMailbox<SettingStruct> *settingsMailbox
             );
 
     void loop();
     void sendSafePacketNoWait();
 private:
+    // Lets the host tests in sim/tests run the stages of a cycle one at a time, see PipelineStage
+    friend class SystemControllerTestAccess;
+
     SystemControllerBailReason bail_reason = BAIL_REASON_NONE;
     SystemControllerInternalState internalState = NOT_STARTED_YET;
     SystemControllerRunState runState = RUN_STATE_UNDETEMINED;
 
     LccRawPacket safeLccRawPacket;
 
-    // Feed forward PID addition
-    // y = kx+m, 0 <= y <= 10
-    // x is time in milliseconds since start of brew
-    //
-    // Start at 5 and go to zero at 20000 milliseconds
-    float feedForwardK = -0.00025f;
-    float feedForwardM = 5.0f;
-
     nonstd::optional<absolute_time_t> core1RebootTimer{};
     nonstd::optional<absolute_time_t> unbailTimer{};
     nonstd::optional<absolute_time_t> heatupStage2Timer{};
     nonstd::optional<absolute_time_t> brewStartedAt{};
+    nonstd::optional<absolute_time_t> brewEndedAt{};
     nonstd::optional<absolute_time_t> plannedAutoSleepAt{};
+    nonstd::optional<absolute_time_t> lastEstimateAt{};
+    nonstd::optional<absolute_time_t> brewSetPointCorrectedAt{};
 
     uart_inst_t* uart;
-    PicoQueue<SystemControllerStatusMessage> *outgoingQueue;
-    PicoQueue<SystemControllerCommand> *incomingQueue;
+    SeqlockMailbox<SystemControllerStatusMessage> *outgoingMailbox;
+    CommandChannel *incomingChannel;
+    SeqlockMailbox<SettingStruct> *settingsMailbox;
+    uint32_t settingsVersion = 0;
     SystemSettings *settings;
 
     PidRuntimeParameters brewPidRuntimeParameters{};
     PidRuntimeParameters servicePidRuntimeParameters{};
 
-    MovingAverage<float> brewTempAverage = MovingAverage<float>(5);
-    MovingAverage<float> serviceTempAverage = MovingAverage<float>(5);
+    float brewSetPointCorrection = 0.f;
+
+    MovingAverage<Q16_16, 5> brewTempAverage;
+    TemperatureKalmanFilter brewTemperatureFilter{};
+    MovingAverage<Q16_16, 5> serviceTempAverage;
 
     LccParsedPacket currentLccParsedPacket;
-    ControlBoardParsedPacket currentControlBoardParsedPacket;
+    ControlBoardDecodedPacket currentControlBoardPacket;
     ControlBoardRawPacket currentControlBoardRawPacket;
 
     SystemControllerCoalescedState externalState();
@@ -83,28 +91,81 @@ private:
     inline bool onlySendSafePackages() { return isBailed() || internalState == NOT_STARTED_YET; }
     [[nodiscard]] inline bool shouldForceHysteresisForBrewBoiler() const { return runState == RUN_STATE_HEATUP_STAGE_1 || runState == RUN_STATE_HEATUP_STAGE_2; };
 
-    void setSleepMode(bool sleepMode);
-    void setAutoSleepMinutes(float minutes);
 
     [[nodiscard]] bool areTemperaturesAtSetPoint() const;
+    // What the brew boiler controller runs on, see TemperatureFilterSettings
+    [[nodiscard]] Q16_16 controlledBrewTemperature() const;
+    // The target brew temperature with Core 1's correction
+    [[nodiscard]] float brewSetPoint() const;
+    void setBrewSetPointCorrection(float correction);
 
     void initiateHeatup();
     void transitionToHeatupStage2();
     void finishHeatup();
 
-    LccParsedPacket handleControlBoardPacket(ControlBoardParsedPacket packet);
+    void startAutoTune(AutoTuneBoiler boiler);
+    void abortAutoTune(AutoTuneAbortReason reason);
+    void finishAutoTune();
+
+    // What the boiler controllers want this cycle, before power sharing
+    struct ControlDemand {
+        LccParsedPacket lcc{};
+        uint8_t brewSignal = 0;
+        uint8_t serviceSignal = 0;
+        bool brewing = false;
+        // The boiler being auto-tuned needs the full relay amplitude, so it can't be cut back by power sharing
+        bool brewBoilerPriority = false;
+        bool serviceBoilerPriority = false;
+    };
+
+    /*
+     * The stages of a running cycle, see PipelineStage. Each one only hands its result on to the next, so they can be
+     * timed separately.
+     */
+    bool ingest();
+    ControlBoardDecodedPacket decode(bool received);
+    void estimate(const ControlBoardDecodedPacket &latestPacket);
+    ControlDemand control(const ControlBoardDecodedPacket &latestPacket);
+    LccParsedPacket arbitrate(const ControlDemand &demand);
+    void emit(const ControlBoardDecodedPacket &decodedPacket);
 
     HybridController brewBoilerController;
-    HysteresisController serviceBoilerController;
+    HybridController serviceBoilerController;
+
+    // The Bianca brew boiler element is 1000 W
+    BrewFeedForward brewFeedForward = BrewFeedForward(1000.f);
+    PidGainScheduler brewGainScheduler{};
+
+    // Settles into a limit cycle of a few minutes per cycle, so give it plenty of time
+    RelayAutoTuner autoTuner = RelayAutoTuner(0.3f, 4, 45 * 60);
+
+    FopdtEstimator brewPlantEstimator = FopdtEstimator(100.f);
+    FopdtEstimator servicePlantEstimator = FopdtEstimator(100.f);
 
     FlowMode flowMode = PUMP_ON_SOLENOID_OPEN;
 
-    PicoQueue<SsrState> ssrStateQueue = PicoQueue<SsrState>(25);
+    SsrSlotPlanner ssrSlotPlanner = SsrSlotPlanner(25);
+    CycleScheduler cycleScheduler = CycleScheduler(100 * 1000);
+    absolute_time_t cycleStartedAt = nil_time;
+    int64_t cycleIdleUs = 0;
+
+    // Ingest is mostly the two packets going over the 9600 baud UART, which takes about 40 ms
+    static constexpr uint32_t stageBudgetsUs[PIPELINE_STAGE_COUNT] = {
+            60000, // Ingest
+            1000, // Decode
+            500, // Estimate
+            2000, // Control
+            500, // Arbitrate
+            1000, // Emit
+    };
+    StageTimer stageTimer = StageTimer(stageBudgetsUs);
 
     TimedLatch waterTankEmptyLatch = TimedLatch(1000, false);
     TimedLatch serviceBoilerLowLatch = TimedLatch(500, false);
 
     void handleCommands();
+    void handleCommand(const SystemControllerCommand &command);
+    void applySettings();
     void updateControllerSettings();
 
     void sendLccPacket();
@@ -113,6 +174,8 @@ private:
 
     void handleRunningStateAutomations();
 
+    [[nodiscard]] PidRegime brewPidRegime() const;
+
     void onBrewStarted();
     void onBrewEnded();
 
@@ -5,9 +5,7 @@
 #ifndef FIRMWARE_SYSTEMSETTINGS_H
 #define FIRMWARE_SYSTEMSETTINGS_H
 
-#include "utils/PicoQueue.h"
 #include "types.h"
-#include "MulticoreSupport.h"
 
 class SystemSettings {
 public:
@@ -20,16 +18,13 @@ public:
     inline float getTargetServiceTemp() const { return currentSettings.serviceTemperatureTarget; };
     inline PidSettings getBrewPidParameters() const { return currentSettings.brewPidParameters; };
     inline PidSettings getServicePidParameters() const { return currentSettings.servicePidParameters; };
+    inline BrewFeedForwardSettings getBrewFeedForward() const { return currentSettings.brewFeedForward; };
+    inline SmithPredictorSettings getBrewSmithPredictor() const { return currentSettings.brewSmithPredictor; };
+    inline PidScheduleSettings getBrewPidSchedule() const { return currentSettings.brewPidSchedule; };
+    inline TemperatureFilterSettings getBrewTemperatureFilter() const { return currentSettings.brewTemperatureFilter; };
 
-    inline void setBrewTemperatureOffset(float offset) { currentSettings.brewTemperatureOffset = offset; };
-    inline void setEcoMode(bool ecoMode) { currentSettings.ecoMode = ecoMode; };
-    inline void setSleepMode(bool sleepMode) { currentSettings.sleepMode = sleepMode; };
-    inline void setTargetBrewTemp(float targetBrewTemp) { currentSettings.brewTemperatureTarget = targetBrewTemp; };
-    inline void setAutoSleepMin(uint16_t minutes) { currentSettings.autoSleepMin = minutes; };
-    inline void setOffsetTargetBrewTemp(float offsetTargetBrewTemp) { setTargetBrewTemp(offsetTargetBrewTemp - currentSettings.brewTemperatureOffset); };
-    inline void setTargetServiceTemp(float targetServiceTemp) { currentSettings.serviceTemperatureTarget = targetServiceTemp; };
-    inline void setBrewPidParameters(PidSettings params) { currentSettings.brewPidParameters = params; };
-    inline void setServicePidParameters(PidSettings params) { currentSettings.servicePidParameters = params; };
+    // Settings only ever change as a whole, from a snapshot published by Core 1
+    inline void update(const SettingStruct &settings) { currentSettings = settings; };
 private:
     SettingStruct currentSettings;
 };
@@ -0,0 +1,64 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "BrewFeedForward.h"
+
+// Specific heat of water, J/gK
+#define WATER_HEAT_CAPACITY 4.186f
+#define PID_OUTPUT_MAX 10.f
+
+BrewFeedForward::BrewFeedForward(float heaterPowerW): heaterPowerW(heaterPowerW) {}
+
+void BrewFeedForward::updateSettings(const BrewFeedForwardSettings &newSettings) {
+    if (settings == newSettings) {
+        return;
+    }
+
+    settings = newSettings;
+
+    float outputPerGramC = settings.gain * PID_OUTPUT_MAX * WATER_HEAT_CAPACITY / heaterPowerW;
+    pumpOutputPerC = Q16_16(outputPerGramC * settings.pumpFlowGramsPerS);
+    lineOutputPerC = Q16_16(outputPerGramC * settings.lineFlowGramsPerS);
+    tankTemperatureC = Q16_16(settings.tankTemperatureC);
+    heatExchangerEffectiveness = Q16_16(settings.heatExchangerEffectiveness);
+    leadGain = Q16_16(settings.leadGain);
+    leadRate = settings.leadTimeS > 0.f ? Q16_16(1.f / settings.leadTimeS) : Q16_16();
+}
+
+Q16_16 BrewFeedForward::update(bool pumpOn, bool solenoidOpen, Q16_16 brewBoilerC, Q16_16 serviceBoilerC,
+                               absolute_time_t now) {
+    Q16_16 dtS = lastUpdateAt.has_value() ? Q16_16::fromRatio(absolute_time_diff_us(lastUpdateAt.value(), now), 1000000) : Q16_16();
+    lastUpdateAt = now;
+
+    Q16_16 outputPerC;
+    if (pumpOn && solenoidOpen) {
+        outputPerC = pumpOutputPerC;
+    } else if (solenoidOpen) {
+        outputPerC = lineOutputPerC;
+    }
+
+    Q16_16 inletC = tankTemperatureC + heatExchangerEffectiveness * (serviceBoilerC - tankTemperatureC);
+    Q16_16 base = outputPerC * (brewBoilerC - inletC);
+
+    if (base < Q16_16()) {
+        base = Q16_16();
+    }
+
+    Q16_16 lagStep = dtS * leadRate;
+    if (leadRate == Q16_16() || lagStep >= Q16_16(1)) {
+        laggedBase = base;
+    } else {
+        laggedBase += (base - laggedBase) * lagStep;
+    }
+
+    // Once the flow stops the lead goes negative, but the element's left over heat is better spent on recovering
+    Q16_16 feedForward = base + leadGain * (base - laggedBase);
+
+    return feedForward > Q16_16() ? feedForward : Q16_16();
+}
+
+void BrewFeedForward::reset() {
+    laggedBase = Q16_16();
+    lastUpdateAt.reset();
+}
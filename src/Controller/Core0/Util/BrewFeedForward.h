@@ -0,0 +1,56 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_BREWFEEDFORWARD_H
+#define SMART_LCC_BREWFEEDFORWARD_H
+
+#include <pico/time.h>
+#include "types.h"
+#include "optional.hpp"
+#include "utils/FixedPoint.h"
+
+/*
+ * Feed forward for the brew boiler PID, from the heat carried off by water flowing through it.
+ *
+ * Water comes in at the inlet temperature and leaves at the boiler temperature, so at a flow of F g/s it takes
+ * F·c·(boiler - inlet) W out of the boiler. That, as a share of the element's power, is what the PID would otherwise
+ * have to find out through the temperature dropping first. The flow follows from the pump and water line solenoid,
+ * i.e. the flow mode, and the inlet temperature from how much the water picks up passing through the service boiler.
+ *
+ * The element takes a while to heat up before any of its power reaches the water, so the output is boosted at the
+ * start of a flow by a lead term, which decays with leadTimeS. Output is in PIDController units, 0-10.
+ *
+ * It runs every control cycle, so it's in Q16.16. The settings only go through floats when they change.
+ */
+class BrewFeedForward {
+public:
+    explicit BrewFeedForward(float heaterPowerW);
+
+    // Cheap when nothing changed, so fine to call every cycle
+    void updateSettings(const BrewFeedForwardSettings &newSettings);
+
+    // Once per control cycle, with the outputs that are about to go out. Only while brewing, since filling the service
+    // boiler doesn't draw water through the brew boiler.
+    Q16_16 update(bool pumpOn, bool solenoidOpen, Q16_16 brewBoilerC, Q16_16 serviceBoilerC, absolute_time_t now);
+    void reset();
+private:
+    float heaterPowerW;
+    BrewFeedForwardSettings settings{};
+
+    // From the settings: output per °C the flow is heated by in the brew boiler, with the pump and with line pressure
+    Q16_16 pumpOutputPerC{};
+    Q16_16 lineOutputPerC{};
+    Q16_16 tankTemperatureC{};
+    Q16_16 heatExchangerEffectiveness{};
+    Q16_16 leadGain{};
+    // 1 / leadTimeS, 0 for no lead
+    Q16_16 leadRate{};
+
+    // The base feed forward through a first order lag, the lead is the difference to it
+    Q16_16 laggedBase{};
+    nonstd::optional<absolute_time_t> lastUpdateAt{};
+};
+
+
+#endif //SMART_LCC_BREWFEEDFORWARD_H
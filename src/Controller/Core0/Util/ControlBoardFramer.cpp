@@ -0,0 +1,71 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "ControlBoardFramer.h"
+#include <cstring>
+#include "utils/checksum.h"
+
+static_assert(sizeof(ControlBoardRawPacket) == 18, "Packet size weird");
+
+bool ControlBoardFramer::push(uint8_t byte) {
+    if (length == 0) {
+        if (byte != CONTROL_BOARD_FRAME_HEADER) {
+            drop(1);
+            return false;
+        }
+    } else if (byte & 0x80) {
+        // Only the header has the high bit set. Whatever we had is broken, see if this starts a new frame.
+        drop(length);
+        length = 0;
+        return push(byte);
+    }
+
+    buffer[length++] = byte;
+
+    if (length < sizeof(buffer)) {
+        return false;
+    }
+
+    if (calculate_checksum(buffer + 1, sizeof(buffer) - 2, 0x01) == buffer[sizeof(buffer) - 1]) {
+        memcpy(&frame, buffer, sizeof(buffer));
+        length = 0;
+        inSync = true;
+        return true;
+    }
+
+    memcpy(&rejectedFrame, buffer, sizeof(buffer));
+    checksumErrorCount++;
+
+    resync();
+    return false;
+}
+
+void ControlBoardFramer::reset() {
+    length = 0;
+}
+
+void ControlBoardFramer::drop(uint8_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    if (inSync) {
+        resyncCount++;
+        inSync = false;
+    }
+
+    droppedBytes += count;
+}
+
+void ControlBoardFramer::resync() {
+    // The header of the failed frame is definitely wrong, restart from the next header in the buffer, if any
+    uint8_t next = 1;
+    while (next < length && buffer[next] != CONTROL_BOARD_FRAME_HEADER) {
+        next++;
+    }
+
+    drop(next);
+    memmove(buffer, buffer + next, length - next);
+    length -= next;
+}
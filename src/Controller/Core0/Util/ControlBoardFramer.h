@@ -0,0 +1,57 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_CONTROLBOARDFRAMER_H
+#define SMART_LCC_CONTROLBOARDFRAMER_H
+
+#include <cstdint>
+#include "Controller/Core0/Protocol/control_board_protocol.h"
+
+#define CONTROL_BOARD_FRAME_HEADER 0x81
+
+/*
+ * Streaming framer for control board packets.
+ *
+ * Bytes are fed in one at a time. A frame starts at a 0x81 header byte and is complete after 18 bytes, provided the
+ * 7 bit checksum matches. The header is the only byte in a packet with the high bit set, so when something doesn't
+ * add up the framer drops bytes up to the next 0x81 it has already seen (or will see) and carries on from there.
+ * Nothing is ever thrown away wholesale and nothing waits, a shifted or interrupted stream simply locks back on to
+ * the next valid frame.
+ */
+class ControlBoardFramer {
+public:
+    // Returns true when this byte completed a valid frame, which is then available from getFrame()
+    bool push(uint8_t byte);
+
+    // Forget any partial frame. The counters are kept.
+    void reset();
+
+    [[nodiscard]] inline const ControlBoardRawPacket& getFrame() const { return frame; }
+
+    // The most recent complete frame whose checksum didn't match, as received. A bad checksum is a different fault
+    // from nothing arriving at all, so this is kept for whoever has to tell them apart.
+    [[nodiscard]] inline const ControlBoardRawPacket& getRejectedFrame() const { return rejectedFrame; }
+    [[nodiscard]] inline uint32_t getChecksumErrorCount() const { return checksumErrorCount; }
+
+    // Number of times the framer had to drop bytes to get back in sync
+    [[nodiscard]] inline uint32_t getResyncCount() const { return resyncCount; }
+    [[nodiscard]] inline uint32_t getDroppedBytes() const { return droppedBytes; }
+private:
+    uint8_t buffer[sizeof(ControlBoardRawPacket)]{};
+    uint8_t length = 0;
+    bool inSync = true;
+
+    ControlBoardRawPacket frame{};
+    ControlBoardRawPacket rejectedFrame{};
+
+    uint32_t checksumErrorCount = 0;
+    uint32_t resyncCount = 0;
+    uint32_t droppedBytes = 0;
+
+    void drop(uint8_t count);
+    void resync();
+};
+
+
+#endif //SMART_LCC_CONTROLBOARDFRAMER_H
@@ -0,0 +1,93 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "CycleScheduler.h"
+#include <hardware/timer.h>
+#include <hardware/sync.h>
+
+int CycleScheduler::alarmNum = -1;
+volatile bool CycleScheduler::alarmFired = false;
+
+static inline uint32_t clampedDiffUs(absolute_time_t from, absolute_time_t to) {
+    int64_t diff = absolute_time_diff_us(from, to);
+
+    if (diff < 0) {
+        return 0;
+    } else if (diff > UINT32_MAX) {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t)diff;
+}
+
+CycleScheduler::CycleScheduler(uint32_t periodUs): periodUs(periodUs) {
+    // The alarm interrupt is taken on the core that sets the callback, which is the one running the control loop
+    alarmNum = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarmNum, CycleScheduler::onAlarm);
+
+    restart();
+}
+
+void CycleScheduler::onAlarm(uint) {
+    alarmFired = true;
+
+    // Wake up waitForNextCycle()
+    __sev();
+}
+
+void CycleScheduler::restart() {
+    hardware_alarm_cancel(alarmNum);
+
+    deadline = get_absolute_time();
+    alarmFired = true;
+}
+
+void CycleScheduler::arm() {
+    // Returns true if the target has already passed, in which case the alarm won't fire
+    if (hardware_alarm_set_target(alarmNum, deadline)) {
+        alarmFired = true;
+    }
+}
+
+void CycleScheduler::waitForNextCycle() {
+    while (!alarmFired) {
+        __wfe();
+    }
+    alarmFired = false;
+
+    absolute_time_t now = get_absolute_time();
+
+    scheduledAt = deadline;
+    stats.cycles++;
+    stats.jitter.add(clampedDiffUs(scheduledAt, now));
+
+    deadline = delayed_by_us(scheduledAt, periodUs);
+    if (absolute_time_diff_us(now, deadline) <= 0) {
+        // We've lost at least a whole cycle, don't try to catch up
+        stats.skippedCycles++;
+        deadline = delayed_by_us(now, periodUs);
+    }
+
+    arm();
+}
+
+void CycleScheduler::markTxStarted() {
+    txStartedAt = get_absolute_time();
+    stats.lastTxDelayUs = clampedDiffUs(scheduledAt, txStartedAt);
+}
+
+void CycleScheduler::markRxCompleted(absolute_time_t at) {
+    rxCompletedAt = at;
+    stats.lastRxUs = clampedDiffUs(txStartedAt, rxCompletedAt);
+}
+
+void CycleScheduler::markControlDone() {
+    absolute_time_t now = get_absolute_time();
+    stats.lastControlUs = clampedDiffUs(rxCompletedAt, now);
+
+    if (absolute_time_diff_us(deadline, now) > 0) {
+        stats.overruns++;
+        stats.overrun.add(clampedDiffUs(deadline, now));
+    }
+}
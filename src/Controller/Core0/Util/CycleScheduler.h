@@ -0,0 +1,57 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_CYCLESCHEDULER_H
+#define SMART_LCC_CYCLESCHEDULER_H
+
+#include <pico/time.h>
+#include "types.h"
+
+/*
+ * Fixed period scheduler for the Core 0 control cycle.
+ *
+ * Cycles are scheduled on a fixed grid driven by a hardware alarm, so the time spent doing work in one cycle doesn't
+ * push the next one back the way sleeping for a fixed time after the work does. Core 0 sleeps (WFE) in
+ * waitForNextCycle() until the alarm fires.
+ *
+ * The controller marks when the LCC packet went out, when the control board reply arrived and when the control
+ * computation was done. From those the scheduler keeps histograms of how late each cycle started (jitter) and by
+ * how much cycles ran past the start of the next one (overruns). If a cycle overruns by more than a whole period,
+ * the missed cycles are skipped rather than run back to back.
+ */
+class CycleScheduler {
+public:
+    explicit CycleScheduler(uint32_t periodUs);
+
+    void waitForNextCycle();
+
+    // Start the grid over from now, e.g. after having run on a different schedule for a while
+    void restart();
+
+    void markTxStarted();
+    void markRxCompleted(absolute_time_t at);
+    void markControlDone();
+
+    // End of the current cycle, i.e. when the next one is due
+    [[nodiscard]] inline absolute_time_t getCycleDeadline() const { return deadline; }
+    [[nodiscard]] inline const CycleTimingStats &getStats() const { return stats; }
+private:
+    uint32_t periodUs;
+    absolute_time_t deadline = nil_time;
+
+    absolute_time_t scheduledAt = nil_time;
+    absolute_time_t txStartedAt = nil_time;
+    absolute_time_t rxCompletedAt = nil_time;
+
+    CycleTimingStats stats{};
+
+    void arm();
+
+    static void onAlarm(uint alarmNum);
+    static int alarmNum;
+    static volatile bool alarmFired;
+};
+
+
+#endif //SMART_LCC_CYCLESCHEDULER_H
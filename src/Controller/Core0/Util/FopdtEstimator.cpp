@@ -0,0 +1,55 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "FopdtEstimator.h"
+
+// PIDController outputs 0-10 for 0-100% heater duty
+#define PID_OUTPUT_MAX 10.f
+
+// Closed loop time constant, as a multiple of the dead time but never faster than a fraction of the time constant.
+// The fraction only comes into it when the fitted dead time is implausibly short for the boiler.
+#define CLOSED_LOOP_DEAD_TIMES 4.f
+#define CLOSED_LOOP_MIN_TIME_CONSTANTS 0.02f
+// Integral time cap, in closed loop time constants plus dead time
+#define SIMC_INTEGRAL_CLOSED_LOOPS 4.f
+
+// How much integral room to leave over what holding the set point takes, same as the relay auto-tune
+#define WINDUP_MARGIN 1.5f
+
+/*
+ * IMC PID for a first-order-plus-dead-time process (Rivera, Morari and Skogestad), with the dead time as a first
+ * order Padé approximation:
+ *
+ *     Kc = (τ + θ/2) / (K·(λ + θ/2)),  Ti = min(τ + θ/2, 4·(λ + θ)),  Td = τ·θ / (2τ + θ)
+ *
+ * The cap on Ti is Skogestad's SIMC one. The boilers are lag dominant, τ is tens of minutes against seconds of dead
+ * time, and with the plain IMC Ti the integral takes about τ to work off a load change. In the simulator that never
+ * settled within the hour.
+ */
+PidSettings pidSettingsForModel(const PlantModelEstimate &model) {
+    float processGain = model.gainC / PID_OUTPUT_MAX;
+    float tau = model.timeConstantS;
+    float theta = model.deadTimeS;
+
+    float closedLoop = fmaxf(CLOSED_LOOP_DEAD_TIMES * theta, CLOSED_LOOP_MIN_TIME_CONSTANTS * tau);
+
+    float Kc = (tau + theta / 2.f) / (processGain * (closedLoop + theta / 2.f));
+    float Ti = fminf(tau + theta / 2.f, SIMC_INTEGRAL_CLOSED_LOOPS * (closedLoop + theta));
+    float Td = tau * theta / (2.f * tau + theta);
+
+    float Ki = Kc / Ti;
+    float windup = WINDUP_MARGIN * model.holdingDuty * PID_OUTPUT_MAX / Ki;
+
+    return PidSettings{
+            .Kp = Kc,
+            .Ki = Ki,
+            .Kd = Kc * Td,
+            .windupLow = -windup,
+            .windupHigh = windup,
+    };
+}
+
+// Instantiate both here, so that the double precision reference doesn't bit rot
+template class BasicFopdtEstimator<Q16_16>;
+template class BasicFopdtEstimator<double>;
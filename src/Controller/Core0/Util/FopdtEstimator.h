@@ -0,0 +1,261 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_FOPDTESTIMATOR_H
+#define SMART_LCC_FOPDTESTIMATOR_H
+
+#include <cstdint>
+#include <cmath>
+#include "types.h"
+#include "utils/FixedPoint.h"
+#include "utils/ExponentialMovingAverage.h"
+
+// One sample per SSR window, so the heater input is a duty cycle rather than a single on/off slot
+#define FOPDT_SAMPLE_CYCLES 25
+#define FOPDT_SAMPLE_PERIOD_S 2.5f
+// Dead times of 0 to 7 samples are fitted side by side, the one that predicts best wins
+#define FOPDT_DELAY_CANDIDATES 8
+// About five minutes of undisturbed samples before the model is trusted
+#define FOPDT_MIN_SAMPLES 120
+// Samples to skip after a disturbance, while the sensor catches up with the water that came in
+#define FOPDT_DISTURBANCE_HOLDOFF 8
+
+/*
+ * PID settings for a first-order-plus-dead-time model, in PIDController units.
+ */
+PidSettings pidSettingsForModel(const PlantModelEstimate &model);
+
+/*
+ * Online first-order-plus-dead-time identification of a boiler, by recursive least squares.
+ *
+ * Every sample period the temperature change is fitted to
+ *
+ *     y[k] - y[k-1] = θ0·(y[k-1] - reference)/10 + θ1·u[k-d] + θ2
+ *
+ * where u is the heater duty over the period (0-1) and d the dead time in samples. θ0 is the loss towards ambient,
+ * θ1 the heating rate at full power and θ2 soaks up where ambient is. Taking the temperature relative to a fixed
+ * reference and in tens of °C keeps all regressors around one, which is what makes this workable in Q16.16.
+ *
+ * The forgetting factor lets the model follow slow drift like scale build-up or inlet water temperature. Sitting at
+ * set point doesn't excite much, so to keep the model from wandering off on sensor noise there, forgetting pauses
+ * once P is large and errors within a dead zone aren't fitted at all. Samples taken while water is flowing in
+ * (brewing, filling) aren't fitted either, as the model doesn't cover that.
+ *
+ * Only accumulation happens on every cycle. The fit and the conversion to gain, time constant and dead time run once
+ * per sample period, so the cost per cycle stays small.
+ */
+template <class Numeric> class BasicFopdtEstimator {
+public:
+    explicit BasicFopdtEstimator(float reference);
+
+    // Once per control cycle, with the filtered temperature and whether the SSR was on for this slot
+    void update(Numeric temperature, bool heaterOn, bool disturbed);
+    inline void updateSetPoint(float newSetPoint) { setPoint = newSetPoint; }
+
+    // Drops the sample in progress and the input history, for when cycles haven't been fed in for a while. The model
+    // itself is kept.
+    void restart();
+
+    [[nodiscard]] inline const PlantModelEstimate &getEstimate() const { return estimate; }
+private:
+    struct Candidate {
+        Numeric theta[3]{};
+        Numeric P[3][3]{};
+        // Of the prediction error in tenths of °C, which is what it takes to tell candidates apart in Q16.16
+        ExponentialMovingAverage<Numeric, 5> squaredError{};
+    };
+
+    const Numeric lambda = Numeric(0.995);
+    const Numeric inverseLambda = Numeric(1.0 / 0.995);
+    const Numeric initialCovariance = Numeric(10);
+    // Above this trace of P, stop forgetting
+    const Numeric maxCovarianceTrace = Numeric(1);
+    // Prediction errors within this are taken to be sensor noise, and not fitted, °C
+    const Numeric deadZone = Numeric(0.02);
+
+    Numeric reference;
+    float setPoint = 0;
+
+    Candidate candidates[FOPDT_DELAY_CANDIDATES]{};
+
+    // Most recent duty first
+    Numeric inputHistory[FOPDT_DELAY_CANDIDATES]{};
+    uint8_t historyLength = 0;
+
+    uint8_t cyclesInSample = 0;
+    uint8_t onCyclesInSample = 0;
+    bool sampleDisturbed = false;
+    uint8_t holdoff = 0;
+
+    bool hasPreviousTemperature = false;
+    Numeric previousTemperature{};
+
+    uint32_t samples = 0;
+    PlantModelEstimate estimate{};
+
+    void reset();
+    void sample(Numeric temperature);
+    void fit(Candidate &candidate, const Numeric (&phi)[3], Numeric target);
+    void updateEstimate();
+};
+
+template <class Numeric>
+BasicFopdtEstimator<Numeric>::BasicFopdtEstimator(float reference): reference(Numeric(reference)) {
+    reset();
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::reset() {
+    for (auto &candidate: candidates) {
+        candidate = Candidate{};
+
+        for (uint8_t i = 0; i < 3; i++) {
+            candidate.P[i][i] = initialCovariance;
+        }
+    }
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::restart() {
+    historyLength = 0;
+    cyclesInSample = 0;
+    onCyclesInSample = 0;
+    sampleDisturbed = false;
+    hasPreviousTemperature = false;
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::update(Numeric temperature, bool heaterOn, bool disturbed) {
+    cyclesInSample++;
+    onCyclesInSample += heaterOn ? 1 : 0;
+    sampleDisturbed = sampleDisturbed || disturbed;
+
+    if (cyclesInSample < FOPDT_SAMPLE_CYCLES) {
+        return;
+    }
+
+    sample(temperature);
+
+    cyclesInSample = 0;
+    onCyclesInSample = 0;
+    sampleDisturbed = false;
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::sample(Numeric temperature) {
+    for (uint8_t i = FOPDT_DELAY_CANDIDATES - 1; i > 0; i--) {
+        inputHistory[i] = inputHistory[i - 1];
+    }
+    inputHistory[0] = Numeric((int)onCyclesInSample) / Numeric(FOPDT_SAMPLE_CYCLES);
+
+    if (historyLength < FOPDT_DELAY_CANDIDATES) {
+        historyLength++;
+    }
+
+    if (sampleDisturbed) {
+        holdoff = FOPDT_DISTURBANCE_HOLDOFF;
+    } else if (holdoff > 0) {
+        holdoff--;
+    } else if (hasPreviousTemperature && historyLength == FOPDT_DELAY_CANDIDATES) {
+        Numeric scaledTemperature = (previousTemperature - reference) / Numeric(10);
+        Numeric change = temperature - previousTemperature;
+
+        for (uint8_t d = 0; d < FOPDT_DELAY_CANDIDATES; d++) {
+            const Numeric phi[3] = {scaledTemperature, inputHistory[d], Numeric(1)};
+            fit(candidates[d], phi, change);
+        }
+
+        samples++;
+        updateEstimate();
+    }
+
+    previousTemperature = temperature;
+    hasPreviousTemperature = true;
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::fit(Candidate &candidate, const Numeric (&phi)[3], Numeric target) {
+    Numeric Pphi[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        Pphi[i] = candidate.P[i][0] * phi[0] + candidate.P[i][1] * phi[1] + candidate.P[i][2] * phi[2];
+    }
+
+    Numeric prediction = candidate.theta[0] * phi[0] + candidate.theta[1] * phi[1] + candidate.theta[2] * phi[2];
+    Numeric error = target - prediction;
+    Numeric scaledError = error * Numeric(10);
+    candidate.squaredError.addValue(scaledError * scaledError);
+
+    if (error < deadZone && error > -deadZone) {
+        return;
+    }
+
+    Numeric trace = candidate.P[0][0] + candidate.P[1][1] + candidate.P[2][2];
+    bool forget = trace < maxCovarianceTrace;
+    Numeric forgetting = forget ? lambda : Numeric(1);
+    Numeric denominator = forgetting + phi[0] * Pphi[0] + phi[1] * Pphi[1] + phi[2] * Pphi[2];
+
+    Numeric gain[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        gain[i] = Pphi[i] / denominator;
+        candidate.theta[i] += gain[i] * error;
+    }
+
+    // P is symmetric, only work out one half of it
+    Numeric scale = forget ? inverseLambda : Numeric(1);
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = i; j < 3; j++) {
+            candidate.P[i][j] = (candidate.P[i][j] - gain[i] * Pphi[j]) * scale;
+            candidate.P[j][i] = candidate.P[i][j];
+        }
+    }
+}
+
+template <class Numeric>
+void BasicFopdtEstimator<Numeric>::updateEstimate() {
+    uint8_t best = 0;
+    for (uint8_t d = 1; d < FOPDT_DELAY_CANDIDATES; d++) {
+        if (candidates[d].squaredError.average() < candidates[best].squaredError.average()) {
+            best = d;
+        }
+    }
+
+    const Candidate &candidate = candidates[best];
+    auto loss = -(float)candidate.theta[0] / 10.f;
+    auto heating = (float)candidate.theta[1];
+    auto offset = (float)candidate.theta[2];
+
+    estimate.samples = samples;
+    estimate.predictionErrorC = sqrtf((float)candidate.squaredError.average()) / 10.f;
+
+    // A boiler that doesn't cool down or heats up when off isn't a model we can tune from
+    estimate.valid = samples >= FOPDT_MIN_SAMPLES && loss > 0 && loss < 1 && heating > 0;
+    if (!estimate.valid) {
+        return;
+    }
+
+    estimate.gainC = heating / loss;
+    estimate.timeConstantS = -FOPDT_SAMPLE_PERIOD_S / logf(1.f - loss);
+    // The duty is averaged over the sample period, which on its own looks like half a period of dead time
+    estimate.deadTimeS = ((float)best + 0.5f) * FOPDT_SAMPLE_PERIOD_S;
+
+    float duty = (loss * (setPoint - (float)reference) - offset) / heating;
+    estimate.holdingDuty = duty < 0.f ? 0.f : (duty > 1.f ? 1.f : duty);
+
+    // Nor is one that holds the set point without heating. The windup limits scale with the holding duty, and at zero
+    // they'd leave the PID without integral action.
+    if (estimate.holdingDuty <= 0.f) {
+        estimate.valid = false;
+        return;
+    }
+
+    estimate.suggestedPid = pidSettingsForModel(estimate);
+}
+
+// The boilers run on Q16.16, see PIDController
+typedef BasicFopdtEstimator<Q16_16> FopdtEstimator;
+
+// Reference implementation, to check the fixed point one against
+typedef BasicFopdtEstimator<double> DoubleFopdtEstimator;
+
+#endif //SMART_LCC_FOPDTESTIMATOR_H
@@ -5,9 +5,10 @@
 #include "HybridController.h"
 
 HybridController::HybridController(float setPoint, float hybridDelta, const PidSettings &pidParameters,
-                                   float hysteresisDelta):
+                                   float hysteresisDelta, float cyclePeriodS):
                                    pidController(pidParameters, setPoint),
                                    hysteresisController(setPoint, hysteresisDelta),
+                                   smithPredictor(cyclePeriodS),
                                    delta(hybridDelta),
                                    lowerPidBound(setPoint - hybridDelta),
                                    upperPidBound(setPoint + hybridDelta)
@@ -22,10 +23,23 @@ void HybridController::updateSetPoint(float setPoint) {
 }
 
 uint8_t HybridController::getControlSignal(float value, float pidFeedForward, bool forceHysteresis) {
+    bool usePid = !forceHysteresis && (value > lowerPidBound && value < upperPidBound);
+
+    // Take over from where the hysteresis controller left the output, rather than from whatever the integral was
+    if (usePid && lastModeWasHysteresis) {
+        pidController.requestBumplessTransfer();
+    }
+
+    // Only now, once any new PID settings that came with the hand over are in
+    if (handOverSlots.has_value()) {
+        pidController.presetIntegral((float)handOverSlots.value() / 2.5f);
+        handOverSlots.reset();
+    }
+
     uint8_t hysteresisValue = hysteresisController.getControlSignal(value);
-    uint8_t pidValue = pidController.getControlSignal(value, pidFeedForward);
+    uint8_t pidValue = pidController.getControlSignal(value + static_cast<float>(smithPredictor.getCorrection()), pidFeedForward);
 
-    if (!forceHysteresis && (value > lowerPidBound && value < upperPidBound)) {
+    if (usePid) {
         lastModeWasHysteresis = false;
         return pidValue;
     }
@@ -35,7 +49,23 @@ uint8_t HybridController::getControlSignal(float value, float pidFeedForward, bo
 }
 
 void HybridController::setPidParameters(PidSettings pidParameters) {
-    pidController.pidParameters = pidParameters;
+    pidController.setPidParameters(pidParameters);
+}
+
+void HybridController::setSmithPredictor(const SmithPredictorSettings &settings) {
+    smithPredictor.configure(settings);
+}
+
+void HybridController::recordHeaterOutput(bool heaterOn) {
+    smithPredictor.update(heaterOn);
+}
+
+void HybridController::trackAppliedSignal(uint8_t slots) {
+    pidController.trackOutput((float)slots / 2.5f);
+}
+
+void HybridController::handOver(uint8_t slots) {
+    handOverSlots = slots;
 }
 
 PidRuntimeParameters HybridController::getRuntimeParameters() const {
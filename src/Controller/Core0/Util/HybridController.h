@@ -8,22 +8,41 @@
 
 #include "HysteresisController.h"
 #include "PIDController.h"
+#include "SmithPredictor.h"
 #include "types.h"
 
 
 class HybridController {
 public:
-    explicit HybridController(float setPoint, float hybridDelta, const PidSettings &pidParameters, float hysteresisDelta);
+    explicit HybridController(float setPoint, float hybridDelta, const PidSettings &pidParameters, float hysteresisDelta,
+                              float cyclePeriodS);
 
     void updateSetPoint(float setPoint);
     uint8_t getControlSignal(float value, float pidFeedForward = 0.f, bool forceHysteresis = false);
     PidRuntimeParameters getRuntimeParameters() const;
 
     void setPidParameters(PidSettings pidParameters);
+    void setSmithPredictor(const SmithPredictorSettings &settings);
+
+    // What the heater actually did over the last cycle, after power sharing. Drives the Smith predictor's model, so
+    // call it once per cycle before getControlSignal().
+    void recordHeaterOutput(bool heaterOn);
+
+    // The slots (out of 25) this boiler actually got after power sharing, for the PID's anti-windup. Call it once per
+    // cycle after getControlSignal(), also while the hysteresis controller is in charge.
+    void trackAppliedSignal(uint8_t slots);
+
+    // Something else has been driving the heater, at `slots` on average, e.g. the auto-tuner's relay around the set
+    // point. From the next getControlSignal() the integral term holds that, and the rest of the PID works on top of it,
+    // rather than on whatever the integral made of the other controller's output.
+    void handOver(uint8_t slots);
 
     PIDController pidController;
 private:
     HysteresisController hysteresisController;
+    // Only the PID sees the predicted temperature, the hysteresis band and the switch between the two are on the
+    // measured one
+    SmithPredictor smithPredictor;
 
     float delta;
 
@@ -31,6 +50,8 @@ private:
     float upperPidBound;
 
     bool lastModeWasHysteresis = true;
+
+    nonstd::optional<uint8_t> handOverSlots{};
 };
 
 
@@ -21,73 +21,7 @@
  */
 
 #include "PIDController.h"
-#include <cmath>
 
-PIDController::PIDController(const PidSettings &pidParameters, float setPoint) : pidParameters(pidParameters),
-                                                                                   setPoint(setPoint) {}
-
-uint8_t PIDController::getControlSignal(float pv, float feedForward) {
-    auto now = get_absolute_time();
-
-    double diffS = (double)absolute_time_diff_us(lastPvAt, now)/1000000;
-
-    updatePidSignal(pv, diffS);
-    lastPvAt = now;
-
-    if (feedForward > 10.f) {
-        feedForward = 10.f;
-    }
-
-    if (feedForward < 0.f) {
-        feedForward = 0.f;
-    }
-
-    float unscaledSignal = pidSignal + feedForward;
-
-    if (unscaledSignal > 10.f) {
-        unscaledSignal = 10.f;
-    }
-
-    return round(unscaledSignal*2.5f);
-}
-
-void PIDController::updatePidSignal(float pv, double dT) {
-    // Calculate error
-    double error = setPoint - pv;
-
-    // Proportional term
-    Pout = pidParameters.Kp * error;
-
-    // Integral term
-    integral += error * dT;
-
-    // Prevent integral wind-up
-    if(integral > pidParameters.windupHigh )
-        integral = pidParameters.windupHigh;
-    else if(integral < pidParameters.windupLow )
-        integral = pidParameters.windupLow;
-
-    Iout = pidParameters.Ki * integral;
-
-    // Derivative term
-    double derivative = (error - _pre_error) / dT;
-    Dout = pidParameters.Kd * derivative;
-
-    // Calculate total output
-    double output = Pout + Iout + Dout;
-
-    // Restrict to max/min
-    if( output > _max )
-        output = _max;
-    else if( output < _min )
-        output = _min;
-
-    // Save error to previous error
-    _pre_error = error;
-
-    pidSignal = (float)round(output);
-}
-
-void PIDController::updateSetPoint(float newSetPoint) {
-    setPoint = newSetPoint;
-}
+// Instantiate both here, so that the double precision reference doesn't bit rot
+template class BasicPIDController<Q16_16, BackCalculationAntiWindup, FilteredDerivativeOnMeasurement>;
+template class BasicPIDController<double, ClampedIntegralAntiWindup, DerivativeOnError>;
@@ -1,14 +1,34 @@
-//
-// Created by Magnus Nordlander on 2021-06-27.
-//
+/**
+ * Copyright 2019 Bradley J. Snyder <snyder.bradleyj@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
 
 #ifndef LCC_RELAY_PIDCONTROLLER_H
 #define LCC_RELAY_PIDCONTROLLER_H
 
 #include <cstdint>
+#include <cmath>
 #include "pico/time.h"
 #include "types.h"
 #include "optional.hpp"
+#include "utils/FixedPoint.h"
 
 struct PidParameters {
     double Kp;
@@ -16,34 +36,366 @@ struct PidParameters {
     double Kd;
 };
 
-class PIDController {
+/*
+ * Conversions the controller needs that can't be expressed with plain arithmetic on the numeric type.
+ */
+template <class Numeric> struct PidNumeric;
+
+template <> struct PidNumeric<double> {
+    static inline double fromMicroseconds(int64_t us) { return (double)us / 1000000; }
+    static inline int32_t roundToInt(double value) { return (int32_t)round(value); }
+};
+
+template <> struct PidNumeric<Q16_16> {
+    static inline Q16_16 fromMicroseconds(int64_t us) { return Q16_16::fromRatio(us, 1000000); }
+    static inline int32_t roundToInt(Q16_16 value) { return value.roundToInt(); }
+};
+
+/*
+ * Anti-windup policies.
+ *
+ * integrate() returns the new integral, given the previous one, the current error, the time step and the tracking
+ * error, i.e. how far the output that actually went out last time was from what the controller would have liked
+ * (negative if it got less). limit() clamps an integral that was set some other way.
+ */
+template <class Numeric> class ClampedIntegralAntiWindup {
 public:
-    PIDController(const PidSettings &pidParameters, float setPoint);
+    inline void configure(const PidSettings &settings) {
+        low = Numeric(settings.windupLow);
+        high = Numeric(settings.windupHigh);
+    }
 
-    PidSettings pidParameters;
+    inline Numeric integrate(Numeric integral, Numeric error, Numeric dT, Numeric) const {
+        return limit(integral + error * dT);
+    }
+
+    inline Numeric limit(Numeric integral) const {
+        if (integral > high) {
+            return high;
+        } else if (integral < low) {
+            return low;
+        }
+
+        return integral;
+    }
+private:
+    Numeric low{};
+    Numeric high{};
+};
+
+/*
+ * Back-calculation: the difference between what went out and what was asked for is fed back into the integral with a
+ * time constant Tt, so the integral stops growing while the output is cut back by power sharing or overridden by
+ * another controller. Tt is twice the geometric mean of the integral and derivative times, or the integral time
+ * without derivative action.
+ *
+ * The controller's own output limits are left to the windup limits, which still apply as a hard bound. The derivative
+ * term pins the output at zero for a few cycles every time the temperature ticks up, and tracking that would keep
+ * pushing the integral up while at the set point.
+ */
+template <class Numeric> class BackCalculationAntiWindup {
+public:
+    inline void configure(const PidSettings &settings) {
+        clamp.configure(settings);
+
+        if (settings.Kp <= 0.f || settings.Ki <= 0.f) {
+            trackingGain = Numeric(0);
+            return;
+        }
+
+        float integralTimeS = settings.Kp / settings.Ki;
+        float derivativeTimeS = settings.Kd / settings.Kp;
+        float trackingTimeS = derivativeTimeS > 0.f ? 2.f * sqrtf(integralTimeS * derivativeTimeS) : integralTimeS;
+
+        trackingGain = Numeric(1.f / (settings.Ki * trackingTimeS));
+    }
+
+    inline Numeric integrate(Numeric integral, Numeric error, Numeric dT, Numeric trackingError) const {
+        return clamp.limit(integral + (error + trackingGain * trackingError) * dT);
+    }
+
+    inline Numeric limit(Numeric integral) const {
+        return clamp.limit(integral);
+    }
+private:
+    ClampedIntegralAntiWindup<Numeric> clamp{};
+    // In integral per unit of output
+    Numeric trackingGain{};
+};
+
+/*
+ * Derivative policies.
+ *
+ * derivative() returns the (unscaled) derivative term, given the current error, process value and time step.
+ * reset() starts over from the given error and process value, with no derivative.
+ */
+template <class Numeric> class DerivativeOnError {
+public:
+    inline void configure(const PidSettings &) {}
+
+    inline void reset(Numeric error, Numeric) {
+        previousError = error;
+    }
+
+    inline Numeric derivative(Numeric error, Numeric, Numeric dT) {
+        Numeric derivative = (error - previousError) / dT;
+        previousError = error;
+
+        return derivative;
+    }
+private:
+    Numeric previousError{};
+};
+
+/*
+ * The derivative of the process value rather than of the error, so a set point change doesn't kick the output, through
+ * a first order filter. Unfiltered, every step of the sensor's resolution comes out as a spike of Kd·step/dT.
+ */
+template <class Numeric> class FilteredDerivativeOnMeasurement {
+public:
+    inline void configure(const PidSettings &settings) {
+        filterTimeS = Numeric(settings.derivativeFilterS > 0.f ? settings.derivativeFilterS : 0.f);
+    }
+
+    inline void reset(Numeric, Numeric pv) {
+        previousPv = pv;
+        filtered = Numeric(0);
+    }
+
+    inline Numeric derivative(Numeric, Numeric pv, Numeric dT) {
+        Numeric derivative = (previousPv - pv) / dT;
+        previousPv = pv;
+
+        filtered += (derivative - filtered) * dT / (filterTimeS + dT);
+
+        return filtered;
+    }
+private:
+    Numeric filterTimeS{};
+    Numeric previousPv{};
+    Numeric filtered{};
+};
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+class BasicPIDController {
+public:
+    BasicPIDController(const PidSettings &pidParameters, float setPoint);
+
+    void setPidParameters(const PidSettings &pidParameters);
+    [[nodiscard]] inline PidSettings getPidParameters() const { return pidParameters; }
 
     void updateSetPoint(float setPoint);
     uint8_t getControlSignal(float value, float feedForward = 0.f);
 
-    double integral = 0;
+    // The output (0-10) that actually went out, when that's not what getControlSignal() asked for, e.g. because of
+    // power sharing or another controller being in charge. Feeds back into the integral on the next update.
+    void trackOutput(float output);
+
+    // On the next update, set the integral so the output carries on from the tracked one rather than jumping
+    void requestBumplessTransfer();
 
-    double Pout = 0;
-    double Iout = 0;
-    double Dout = 0;
+    // Set the integral so the integral term alone is `output` (0-10), e.g. what's known to hold the set point
+    void presetIntegral(float output);
+
+    Numeric integral{};
+
+    Numeric Pout{};
+    Numeric Iout{};
+    Numeric Dout{};
 private:
-    const double _max = 10;
-    const double _min = 0;
+    const Numeric _max = Numeric(10);
+    const Numeric _min = Numeric(0);
+
+    PidSettings pidParameters{};
+    bool hasPidParameters = false;
+
+    // pidParameters, converted once rather than on every update
+    Numeric Kp{};
+    Numeric Ki{};
+    Numeric Kd{};
+    Numeric setPointWeight{};
+    Numeric setPointRamp{};
+    Numeric integralTimeS{};
+
+    AntiWindupPolicy<Numeric> antiWindup{};
+    DerivativePolicy<Numeric> derivativePolicy{};
 
-    float pidSignal = 0;
+    Numeric pidSignal{};
 
-    double _pre_error = 0;
+    // What the last update asked for, after rounding to slots, and what actually went out instead
+    Numeric requestedOutput{};
+    Numeric trackedOutput{};
+    bool bumplessTransferPending = false;
 
-    float setPoint;
+    // Where updateSetPoint() wants to go, where the ramp has got to, and what the proportional term has caught up with
+    Numeric targetSetPoint;
+    Numeric setPoint;
+    Numeric settledSetPoint;
 
-    absolute_time_t lastPvAt;
+    nonstd::optional<absolute_time_t> lastPvAt{};
 
-    void updatePidSignal(float pv, double dT);
+    void rampSetPoint(Numeric dT);
+    void updatePidSignal(Numeric pv, Numeric dT, Numeric ff);
 };
 
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::BasicPIDController(const PidSettings &pidParameters, float setPoint):
+        targetSetPoint(Numeric(setPoint)), setPoint(Numeric(setPoint)), settledSetPoint(Numeric(setPoint)) {
+    setPidParameters(pidParameters);
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::setPidParameters(const PidSettings &newPidParameters) {
+    // This is called every cycle, so skip the float conversions unless something actually changed
+    if (hasPidParameters && pidParameters == newPidParameters) {
+        return;
+    }
+
+    pidParameters = newPidParameters;
+    hasPidParameters = true;
+
+    Kp = Numeric(pidParameters.Kp);
+    Ki = Numeric(pidParameters.Ki);
+    Kd = Numeric(pidParameters.Kd);
+    setPointWeight = Numeric(pidParameters.setPointWeight);
+    setPointRamp = Numeric(pidParameters.setPointRampCPerS > 0.f ? pidParameters.setPointRampCPerS : 0.f);
+    integralTimeS = Numeric(pidParameters.Ki > 0.f ? pidParameters.Kp / pidParameters.Ki : 0.f);
+
+    antiWindup.configure(pidParameters);
+    derivativePolicy.configure(pidParameters);
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+uint8_t BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::getControlSignal(float pv, float feedForward) {
+    auto now = get_absolute_time();
+
+    // The first sample has nothing to integrate or differentiate over, and starts right at the set point
+    Numeric dT{};
+    if (lastPvAt.has_value()) {
+        dT = PidNumeric<Numeric>::fromMicroseconds(absolute_time_diff_us(*lastPvAt, now));
+    } else {
+        setPoint = targetSetPoint;
+        settledSetPoint = targetSetPoint;
+    }
+
+    Numeric ff = Numeric(feedForward);
+
+    if (ff > _max) {
+        ff = _max;
+    }
+
+    if (ff < _min) {
+        ff = _min;
+    }
+
+    rampSetPoint(dT);
+    updatePidSignal(Numeric(pv), dT, ff);
+    lastPvAt = now;
+
+    Numeric unscaledSignal = pidSignal + ff;
+
+    if (unscaledSignal > _max) {
+        unscaledSignal = _max;
+    }
+
+    int32_t slots = PidNumeric<Numeric>::roundToInt(unscaledSignal * Numeric(2.5f));
+
+    // Unless told otherwise, assume the output went out as asked
+    requestedOutput = Numeric(slots) / Numeric(2.5f);
+    trackedOutput = requestedOutput;
+
+    return slots;
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::trackOutput(float output) {
+    trackedOutput = Numeric(output);
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::requestBumplessTransfer() {
+    bumplessTransferPending = true;
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::presetIntegral(float output) {
+    integral = Ki > Numeric(0) ? antiWindup.limit(Numeric(output) / Ki) : Numeric(0);
+    bumplessTransferPending = false;
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::rampSetPoint(Numeric dT) {
+    if (setPointRamp <= Numeric(0)) {
+        setPoint = targetSetPoint;
+    } else {
+        Numeric step = setPointRamp * dT;
+
+        if (targetSetPoint > setPoint + step) {
+            setPoint += step;
+        } else if (targetSetPoint < setPoint - step) {
+            setPoint -= step;
+        } else {
+            setPoint = targetSetPoint;
+        }
+    }
+
+    // The windup limits are far too tight for the integral to make up for a permanent offset, so rather than weighting
+    // the set point itself, the proportional term gets the rest of a change over the integral time
+    if (integralTimeS > Numeric(0)) {
+        settledSetPoint += (setPoint - settledSetPoint) * dT / (integralTimeS + dT);
+    } else {
+        settledSetPoint = setPoint;
+    }
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::updatePidSignal(Numeric pv, Numeric dT, Numeric ff) {
+    // Calculate error
+    Numeric error = setPoint - pv;
+
+    // Proportional term, on the weighted set point
+    Pout = Kp * (error - (Numeric(1) - setPointWeight) * (setPoint - settledSetPoint));
+
+    // Derivative term
+    if (dT > Numeric(0)) {
+        Dout = Kd * derivativePolicy.derivative(error, pv, dT);
+    } else {
+        derivativePolicy.reset(error, pv);
+        Dout = Numeric(0);
+    }
+
+    // Integral term, including wind-up prevention
+    if (bumplessTransferPending) {
+        integral = Ki > Numeric(0) ? antiWindup.limit((trackedOutput - ff - Pout - Dout) / Ki) : Numeric(0);
+        bumplessTransferPending = false;
+    } else {
+        integral = antiWindup.integrate(integral, error, dT, trackedOutput - requestedOutput);
+    }
+
+    Iout = Ki * integral;
+
+    // Calculate total output
+    Numeric output = Pout + Iout + Dout;
+
+    // Restrict to max/min
+    if( output > _max )
+        output = _max;
+    else if( output < _min )
+        output = _min;
+
+    pidSignal = Numeric(PidNumeric<Numeric>::roundToInt(output));
+}
+
+template <class Numeric, template <class> class AntiWindupPolicy, template <class> class DerivativePolicy>
+void BasicPIDController<Numeric, AntiWindupPolicy, DerivativePolicy>::updateSetPoint(float newSetPoint) {
+    targetSetPoint = Numeric(newSetPoint);
+}
+
+// The boilers run on Q16.16, the M0+ has no FPU and this is on the 100 ms control loop
+typedef BasicPIDController<Q16_16, BackCalculationAntiWindup, FilteredDerivativeOnMeasurement> PIDController;
+
+// Reference implementation, the original double precision controller. With the set point weight, derivative filter and
+// set point ramp left alone, it only differs in not taking the first sample's time step from boot.
+typedef BasicPIDController<double, ClampedIntegralAntiWindup, DerivativeOnError> DoublePIDController;
 
 #endif //LCC_RELAY_PIDCONTROLLER_H
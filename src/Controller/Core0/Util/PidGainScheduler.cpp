@@ -0,0 +1,87 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "PidGainScheduler.h"
+
+static float lerp(float from, float to, float t) {
+    return from + (to - from) * t;
+}
+
+static PidSettings interpolate(const PidSettings &from, const PidSettings &to, float t) {
+    return PidSettings{
+            .Kp = lerp(from.Kp, to.Kp, t),
+            .Ki = lerp(from.Ki, to.Ki, t),
+            .Kd = lerp(from.Kd, to.Kd, t),
+            .windupLow = lerp(from.windupLow, to.windupLow, t),
+            .windupHigh = lerp(from.windupHigh, to.windupHigh, t),
+            .setPointWeight = lerp(from.setPointWeight, to.setPointWeight, t),
+            .derivativeFilterS = lerp(from.derivativeFilterS, to.derivativeFilterS, t),
+            .setPointRampCPerS = lerp(from.setPointRampCPerS, to.setPointRampCPerS, t),
+    };
+}
+
+nonstd::optional<PidSettings> PidGainScheduler::update(PidRegime regime, absolute_time_t now) {
+    float dtS = lastUpdateAt.has_value() ? (float)absolute_time_diff_us(lastUpdateAt.value(), now) / 1e6f : 0.f;
+    bool first = !lastUpdateAt.has_value();
+    lastUpdateAt = now;
+
+    if (regime != currentRegime) {
+        currentRegime = regime;
+        blendFrom = current;
+        blend = first ? 1.f : 0.f;
+        changed = true;
+    }
+
+    if (blend < 1.f) {
+        blend = schedule.transitionS > 0.f ? blend + dtS / schedule.transitionS : 1.f;
+
+        if (blend > 1.f) {
+            blend = 1.f;
+        }
+
+        changed = true;
+    }
+
+    if (!changed) {
+        return nonstd::nullopt;
+    }
+
+    changed = false;
+    // Exactly the target once there
+    current = blend < 1.f ? interpolate(blendFrom, settingsFor(regime), blend) : settingsFor(regime);
+
+    return current;
+}
+
+PidSettings PidGainScheduler::settingsFor(PidRegime regime) const {
+    if (!schedule.enabled) {
+        return base;
+    }
+
+    const PidGains *gains;
+    switch (regime) {
+        case PID_REGIME_BREWING:
+            gains = &schedule.brewing;
+            break;
+        case PID_REGIME_RECOVERY:
+            gains = &schedule.recovery;
+            break;
+        case PID_REGIME_SLEEP:
+            gains = &schedule.sleep;
+            break;
+        case PID_REGIME_IDLE:
+        case PID_REGIME_COUNT:
+        default:
+            return base;
+    }
+
+    PidSettings settings = base;
+    settings.Kp = gains->Kp;
+    settings.Ki = gains->Ki;
+    settings.Kd = gains->Kd;
+    settings.windupLow = gains->windupLow;
+    settings.windupHigh = gains->windupHigh;
+
+    return settings;
+}
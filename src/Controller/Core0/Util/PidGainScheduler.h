@@ -0,0 +1,51 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_PIDGAINSCHEDULER_H
+#define SMART_LCC_PIDGAINSCHEDULER_H
+
+#include <pico/time.h>
+#include "types.h"
+#include "optional.hpp"
+
+/*
+ * Picks the PID settings for the operating regime the boiler is in. On a change of regime, it blends linearly from
+ * whatever it was using over transitionS, so a brew starting or ending doesn't step the gains under the integral.
+ *
+ * Disabled, it passes the base settings straight through.
+ */
+class PidGainScheduler {
+public:
+    inline void updateSettings(const PidSettings &newBase, const PidScheduleSettings &newSchedule) {
+        if (base == newBase && schedule == newSchedule) {
+            return;
+        }
+
+        base = newBase;
+        schedule = newSchedule;
+        changed = true;
+    }
+
+    // Once per control cycle, before running the PID. Only comes up with PID settings when they differ from the last
+    // ones, i.e. on a change of regime or settings and while blending.
+    nonstd::optional<PidSettings> update(PidRegime regime, absolute_time_t now);
+
+    [[nodiscard]] inline PidRegime getRegime() const { return currentRegime; }
+private:
+    PidSettings base{};
+    PidScheduleSettings schedule{};
+
+    PidRegime currentRegime = PID_REGIME_IDLE;
+    // Where the blend started, and how far along it is, 0-1
+    PidSettings blendFrom{};
+    float blend = 1.f;
+    PidSettings current{};
+    bool changed = true;
+    nonstd::optional<absolute_time_t> lastUpdateAt{};
+
+    [[nodiscard]] PidSettings settingsFor(PidRegime regime) const;
+};
+
+
+#endif //SMART_LCC_PIDGAINSCHEDULER_H
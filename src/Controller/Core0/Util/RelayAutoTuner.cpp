@@ -0,0 +1,142 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "RelayAutoTuner.h"
+#include <cmath>
+
+// The relay switches between 0 and the full PIDController output of 10, so it swings ±5 around the middle
+#define RELAY_AMPLITUDE 5.f
+#define PID_OUTPUT_MAX 10.f
+
+// How much integral room to leave over what holding the set point takes on average
+#define WINDUP_MARGIN 1.5f
+
+RelayAutoTuner::RelayAutoTuner(float hysteresis, uint8_t cyclesRequired, uint32_t timeoutS):
+        hysteresis(hysteresis), cyclesRequired(cyclesRequired), timeoutS(timeoutS) {}
+
+void RelayAutoTuner::start(AutoTuneBoiler boiler, float newSetPoint, absolute_time_t now) {
+    status = AutoTuneStatus{
+            .state = AUTOTUNE_STATE_APPROACHING,
+            .boiler = boiler,
+            .abortReason = AUTOTUNE_ABORT_NONE,
+            .cyclesCompleted = 0,
+            .cyclesRequired = cyclesRequired,
+            .runId = (uint16_t)(status.runId + 1),
+    };
+
+    setPoint = newSetPoint;
+    relayOn = true;
+    startedAt = now;
+
+    cycleStartedAt.reset();
+    switchedOffAt = nil_time;
+    firstCycleDiscarded = false;
+
+    amplitudeSum = 0;
+    periodSumUs = 0;
+    onTimeSumUs = 0;
+}
+
+void RelayAutoTuner::abort(AutoTuneAbortReason reason) {
+    // Also used to reject a start, so this doesn't require a run in progress
+    status.state = AUTOTUNE_STATE_ABORTED;
+    status.abortReason = reason;
+    relayOn = false;
+}
+
+bool RelayAutoTuner::update(float value, absolute_time_t now) {
+    if (!isRunning()) {
+        return false;
+    }
+
+    if (absolute_time_diff_us(startedAt, now) > (int64_t)timeoutS * 1000 * 1000) {
+        abort(AUTOTUNE_ABORT_TIMEOUT);
+        return false;
+    }
+
+    if (status.state == AUTOTUNE_STATE_APPROACHING) {
+        if (value >= setPoint + hysteresis) {
+            relayOn = false;
+            status.state = AUTOTUNE_STATE_OSCILLATING;
+        }
+
+        return relayOn;
+    }
+
+    if (cycleStartedAt.has_value()) {
+        cycleHigh = fmaxf(cycleHigh, value);
+        cycleLow = fminf(cycleLow, value);
+    }
+
+    if (relayOn && value >= setPoint + hysteresis) {
+        relayOn = false;
+        switchedOffAt = now;
+    } else if (!relayOn && value <= setPoint - hysteresis) {
+        relayOn = true;
+
+        if (cycleStartedAt.has_value()) {
+            completeCycle(now);
+        }
+
+        cycleStartedAt = now;
+        cycleHigh = value;
+        cycleLow = value;
+    }
+
+    return relayOn;
+}
+
+float RelayAutoTuner::getAverageDuty() const {
+    return periodSumUs > 0 ? (float)onTimeSumUs / (float)periodSumUs : 0.f;
+}
+
+void RelayAutoTuner::completeCycle(absolute_time_t now) {
+    if (!firstCycleDiscarded) {
+        firstCycleDiscarded = true;
+        return;
+    }
+
+    amplitudeSum += (cycleHigh - cycleLow) / 2.f;
+    periodSumUs += absolute_time_diff_us(cycleStartedAt.value(), now);
+    onTimeSumUs += absolute_time_diff_us(cycleStartedAt.value(), switchedOffAt);
+
+    status.cyclesCompleted++;
+
+    if (status.cyclesCompleted >= cyclesRequired) {
+        finish();
+    }
+}
+
+void RelayAutoTuner::finish() {
+    float amplitude = amplitudeSum / (float)status.cyclesCompleted;
+    float periodS = (float)periodSumUs / (float)status.cyclesCompleted / 1e6f;
+
+    // With the hysteresis close to the amplitude, Ku blows up on what is mostly sensor noise
+    if (amplitude < hysteresis * 1.1f) {
+        abort(AUTOTUNE_ABORT_NO_OSCILLATION);
+        return;
+    }
+
+    float ultimateGain = 4.f * RELAY_AMPLITUDE / ((float)M_PI * sqrtf(amplitude * amplitude - hysteresis * hysteresis));
+
+    // Tyreus–Luyben rather than Ziegler–Nichols, boilers are lag dominated and ZN overshoots badly on them
+    float Kp = ultimateGain / 2.2f;
+    float Ti = 2.2f * periodS;
+    float Td = periodS / 6.3f;
+    float Ki = Kp / Ti;
+
+    float windup = WINDUP_MARGIN * getAverageDuty() * PID_OUTPUT_MAX / Ki;
+
+    status.state = AUTOTUNE_STATE_DONE;
+    status.ultimateGain = ultimateGain;
+    status.ultimatePeriodS = periodS;
+    status.result = PidSettings{
+            .Kp = Kp,
+            .Ki = Ki,
+            .Kd = Kp * Td,
+            .windupLow = -windup,
+            .windupHigh = windup,
+    };
+    relayOn = false;
+}
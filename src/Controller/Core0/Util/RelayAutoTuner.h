@@ -0,0 +1,70 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_RELAYAUTOTUNER_H
+#define SMART_LCC_RELAYAUTOTUNER_H
+
+#include <pico/time.h>
+#include "types.h"
+#include "optional.hpp"
+
+/*
+ * Åström–Hägglund relay auto-tuner.
+ *
+ * Instead of a controller, the boiler is driven by a relay with hysteresis: full power until the temperature is
+ * hysteresis above the set point, off until it is hysteresis below it. That settles into a limit cycle at the
+ * ultimate period Tu of the boiler. From the amplitude a of that oscillation and the relay amplitude d, the ultimate
+ * gain is Ku = 4d / (π·√(a² - hysteresis²)).
+ *
+ * The first full cycle is thrown away since it still carries the heat up, the next cyclesRequired are averaged.
+ * PID settings then follow from Ku and Tu, in the units of PIDController, i.e. an output of 0-10 per °C and
+ * per second. The windup limits are set so the integral alone can hold the average relay duty with some margin.
+ */
+class RelayAutoTuner {
+public:
+    explicit RelayAutoTuner(float hysteresis, uint8_t cyclesRequired, uint32_t timeoutS);
+
+    void start(AutoTuneBoiler boiler, float setPoint, absolute_time_t now);
+    void abort(AutoTuneAbortReason reason);
+
+    // Feed the latest temperature once per control cycle. Returns whether the heater should be on.
+    bool update(float value, absolute_time_t now);
+
+    [[nodiscard]] inline bool isRunning() const {
+        return status.state == AUTOTUNE_STATE_APPROACHING || status.state == AUTOTUNE_STATE_OSCILLATING;
+    }
+    [[nodiscard]] inline const AutoTuneStatus &getStatus() const { return status; }
+
+    // Fraction of the time the relay was on over the measured cycles so far, i.e. roughly what holding the set point
+    // takes. 0 before the first one.
+    [[nodiscard]] float getAverageDuty() const;
+private:
+    float hysteresis;
+    uint8_t cyclesRequired;
+    uint32_t timeoutS;
+
+    AutoTuneStatus status{};
+
+    float setPoint = 0;
+    bool relayOn = false;
+    absolute_time_t startedAt = nil_time;
+
+    // The cycle in progress, which runs from one relay switch on to the next
+    nonstd::optional<absolute_time_t> cycleStartedAt{};
+    absolute_time_t switchedOffAt = nil_time;
+    float cycleHigh = 0;
+    float cycleLow = 0;
+    bool firstCycleDiscarded = false;
+
+    // Sums over the measured cycles
+    float amplitudeSum = 0;
+    int64_t periodSumUs = 0;
+    int64_t onTimeSumUs = 0;
+
+    void completeCycle(absolute_time_t now);
+    void finish();
+};
+
+
+#endif //SMART_LCC_RELAYAUTOTUNER_H
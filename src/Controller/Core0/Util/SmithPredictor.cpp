@@ -0,0 +1,52 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "SmithPredictor.h"
+#include <cmath>
+
+SmithPredictor::SmithPredictor(float cyclePeriodS): cyclePeriodS(cyclePeriodS) {}
+
+void SmithPredictor::configure(const SmithPredictorSettings &newSettings) {
+    if (settings == newSettings) {
+        return;
+    }
+
+    settings = newSettings;
+
+    gainC = Q16_16(settings.gainC);
+    float share = settings.timeConstantS > 0.f ? 1.f - expf(-cyclePeriodS / settings.timeConstantS) : 1.f;
+    scaledShare = Q16_16(share * SMITH_PREDICTOR_SHARE_SCALE);
+
+    // SettingsManager only lets through finite dead times in range, but a NaN would make the conversion undefined
+    float slots = roundf(settings.deadTimeS / cyclePeriodS);
+    if (!(slots >= 0.f)) {
+        slots = 0.f;
+    } else if (slots > SMITH_PREDICTOR_DELAY_SLOTS - 1) {
+        slots = SMITH_PREDICTOR_DELAY_SLOTS - 1;
+    }
+    delaySlots = (uint16_t)slots;
+
+    reset();
+}
+
+void SmithPredictor::update(bool heaterOn) {
+    if (!settings.enabled) {
+        return;
+    }
+
+    static constexpr Q16_16 unscale = Q16_16::fromRatio(1, SMITH_PREDICTOR_SHARE_SCALE);
+
+    // Scaled down first, as the share can be up to the whole scale
+    Q16_16 input = heaterOn ? gainC : Q16_16();
+    model += (input - model) * unscale * scaledShare;
+    delayLine.push(model);
+
+    correction = model - delayLine.ago(delaySlots);
+}
+
+void SmithPredictor::reset() {
+    model = Q16_16();
+    correction = Q16_16();
+    delayLine.fill(Q16_16());
+}
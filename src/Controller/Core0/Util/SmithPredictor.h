@@ -0,0 +1,66 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SMITHPREDICTOR_H
+#define SMART_LCC_SMITHPREDICTOR_H
+
+#include "types.h"
+#include "utils/DelayLine.h"
+#include "utils/FixedPoint.h"
+
+// One slot per control cycle, so at 100 ms this covers dead times up to 25.5 s
+#define SMITH_PREDICTOR_DELAY_SLOTS 256
+static_assert((SMITH_PREDICTOR_DELAY_SLOTS - 1) * 0.1f >= SMITH_PREDICTOR_MAX_DEAD_TIME_S,
+              "SettingsManager lets through dead times the delay line doesn't cover");
+// How far the model goes towards the heater input each cycle, 1 - e^(-cycle / τ), is a few ten thousandths at a
+// boiler's time constant. It's kept times this, so it resolves in Q16.16.
+#define SMITH_PREDICTOR_SHARE_SCALE 256
+
+/*
+ * Smith predictor for dead time compensation.
+ *
+ * An internal first-order model of the boiler is driven by what the heater actually did, and its output is kept both
+ * as is and through a delay line of the model's dead time. The difference between the two is how much the heat
+ * that's already on its way will still move the sensor. Adding it to the measured temperature gives the controller
+ * the temperature without the dead time, so it doesn't keep heating while the sensor catches up.
+ *
+ * The model only runs in deviation from where it started, so ambient doesn't come into it, and with a constant heater
+ * duty the correction settles to zero whatever the model gain. A wrong model mostly costs some of the benefit.
+ *
+ * Water flowing through isn't in the model, so while brewing it takes the feed forward's heat for heat still on its
+ * way to the sensor. That costs some extra drop during a shot, but it is also what keeps the boiler from overshooting
+ * once the flow stops.
+ *
+ * It runs every control cycle, so it's in Q16.16. The settings only go through floats when they change.
+ */
+class SmithPredictor {
+public:
+    explicit SmithPredictor(float cyclePeriodS);
+
+    // Cheap when nothing changed, so fine to call every cycle. A changed model starts over.
+    void configure(const SmithPredictorSettings &settings);
+
+    // Once per control cycle, with whether the heater was on over the last one
+    void update(bool heaterOn);
+    void reset();
+
+    [[nodiscard]] inline bool isEnabled() const { return settings.enabled; }
+    // What to add to the measured temperature, °C. Zero when disabled.
+    [[nodiscard]] inline Q16_16 getCorrection() const { return correction; }
+private:
+    float cyclePeriodS;
+    SmithPredictorSettings settings{};
+
+    Q16_16 gainC{};
+    // Per cycle, from the time constant, times SMITH_PREDICTOR_SHARE_SCALE
+    Q16_16 scaledShare{};
+    uint16_t delaySlots = 0;
+
+    Q16_16 model{};
+    Q16_16 correction{};
+    DelayLine<Q16_16, SMITH_PREDICTOR_DELAY_SLOTS> delayLine{};
+};
+
+
+#endif //SMART_LCC_SMITHPREDICTOR_H
@@ -0,0 +1,59 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "SsrSlotPlanner.h"
+
+SsrSlotPlanner::SsrSlotPlanner(uint8_t slotsPerWindow): slotsPerWindow(slotsPerWindow) {}
+
+SsrState SsrSlotPlanner::nextSlot(uint8_t brewSlots, uint8_t serviceSlots) {
+    if (brewSlots > slotsPerWindow) {
+        brewSlots = slotsPerWindow;
+    }
+
+    if (serviceSlots > slotsPerWindow - brewSlots) {
+        serviceSlots = slotsPerWindow - brewSlots;
+    }
+
+    // A boiler that no longer asks for power shouldn't get a stale slot from its accumulated error
+    if (brewSlots == 0) {
+        brewAccumulator = 0;
+    }
+
+    if (serviceSlots == 0) {
+        serviceAccumulator = 0;
+    }
+
+    brewAccumulator += brewSlots;
+    serviceAccumulator += serviceSlots;
+
+    // With brew + service <= slotsPerWindow both accumulators stay below two windows, this is just a safety net
+    if (brewAccumulator > 2 * slotsPerWindow) {
+        brewAccumulator = 2 * slotsPerWindow;
+    }
+
+    if (serviceAccumulator > 2 * slotsPerWindow) {
+        serviceAccumulator = 2 * slotsPerWindow;
+    }
+
+    bool brewDue = brewAccumulator >= slotsPerWindow;
+    bool serviceDue = serviceAccumulator >= slotsPerWindow;
+
+    // If both are due, the one that is furthest behind gets the slot, ties go to the brew boiler
+    if (brewDue && (!serviceDue || brewAccumulator >= serviceAccumulator)) {
+        brewAccumulator -= slotsPerWindow;
+        return BREW_BOILER_SSR_ON;
+    }
+
+    if (serviceDue) {
+        serviceAccumulator -= slotsPerWindow;
+        return SERVICE_BOILER_SSR_ON;
+    }
+
+    return BOTH_SSRS_OFF;
+}
+
+void SsrSlotPlanner::reset() {
+    brewAccumulator = 0;
+    serviceAccumulator = 0;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_SSRSLOTPLANNER_H
+#define SMART_LCC_SSRSLOTPLANNER_H
+
+#include <cstdint>
+#include "types.h"
+
+/*
+ * Receding-horizon SSR planner.
+ *
+ * Every control cycle (one 100 ms slot) the brew and service boiler requests are handed in again, expressed as
+ * on-slots out of a window of slotsPerWindow. Each boiler has a sigma-delta accumulator, so on-slots are spread
+ * evenly over the window instead of being committed as one contiguous block. Since nothing is committed ahead of
+ * time, a changed request takes effect on the very next slot.
+ *
+ * Only one SSR is ever switched on per slot. If both are due, the one furthest behind gets the slot and the other keeps
+ * its accumulated error for the next free slot. The caller is expected to have done power sharing, i.e. brew + service
+ * must not exceed slotsPerWindow.
+ */
+class SsrSlotPlanner {
+public:
+    explicit SsrSlotPlanner(uint8_t slotsPerWindow);
+
+    SsrState nextSlot(uint8_t brewSlots, uint8_t serviceSlots);
+    void reset();
+
+    [[nodiscard]] inline uint8_t getSlotsPerWindow() const { return slotsPerWindow; }
+private:
+    uint8_t slotsPerWindow;
+
+    uint16_t brewAccumulator = 0;
+    uint16_t serviceAccumulator = 0;
+};
+
+
+#endif //SMART_LCC_SSRSLOTPLANNER_H
@@ -0,0 +1,55 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_STAGETIMER_H
+#define SMART_LCC_STAGETIMER_H
+
+#include <hardware/timer.h>
+#include "types.h"
+
+/*
+ * Times the stages of the Core 0 control cycle against a fixed budget per stage.
+ *
+ * Uses the 1 MHz system timer rather than a CPU cycle counter, since the M0+ doesn't have one (SysTick is only
+ * 24 bits and wraps well within a control cycle). Only time_us_32() is needed, so a stubbed clock is enough to run
+ * the stages on a host.
+ */
+class StageTimer {
+public:
+    explicit StageTimer(const uint32_t (&budgetsUs)[PIPELINE_STAGE_COUNT]) {
+        for (uint8_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+            stats.stages[i].budgetUs = budgetsUs[i];
+        }
+    }
+
+    inline void begin(PipelineStage stage) {
+        currentStage = stage;
+        startedAt = time_us_32();
+    }
+
+    // Ends the stage started by the last call to begin()
+    inline void end() {
+        record(currentStage, time_us_32() - startedAt);
+    }
+
+    void record(PipelineStage stage, uint32_t elapsedUs) {
+        PipelineStageStats &stageStats = stats.stages[stage];
+
+        stageStats.lastUs = elapsedUs;
+        if (elapsedUs > stageStats.maxUs) {
+            stageStats.maxUs = elapsedUs;
+        }
+        if (elapsedUs > stageStats.budgetUs) {
+            stageStats.overruns++;
+        }
+    }
+
+    [[nodiscard]] inline const PipelineTimingStats &getStats() const { return stats; }
+private:
+    PipelineTimingStats stats{};
+    PipelineStage currentStage = PIPELINE_STAGE_INGEST;
+    uint32_t startedAt = 0;
+};
+
+#endif //SMART_LCC_STAGETIMER_H
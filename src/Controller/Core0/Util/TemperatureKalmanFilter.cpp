@@ -0,0 +1,9 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include "TemperatureKalmanFilter.h"
+
+// Instantiate both here, so that the double precision reference doesn't bit rot
+template class BasicTemperatureKalmanFilter<Q16_16>;
+template class BasicTemperatureKalmanFilter<double>;
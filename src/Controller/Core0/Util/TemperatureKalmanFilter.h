@@ -0,0 +1,163 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_TEMPERATUREKALMANFILTER_H
+#define SMART_LCC_TEMPERATUREKALMANFILTER_H
+
+#include "types.h"
+#include "utils/FixedPoint.h"
+
+// The rate is kept in hundredths of °C/s, which is what it takes for its variance to resolve in Q16.16
+#define KALMAN_RATE_SCALE 100
+// Model error on the temperature itself, °C² per second
+#define KALMAN_TEMPERATURE_NOISE 0.001f
+// Until the first few corrections have pulled it in, (°C/s)²
+#define KALMAN_INITIAL_RATE_VARIANCE 0.04f
+// The low gain channel's calibration offset to the estimate is followed this slowly, s
+#define KALMAN_LOW_GAIN_OFFSET_TIME_S 60.f
+
+/*
+ * Boiler temperature and its rate of change, from both of the control board's channels, by a two state Kalman filter.
+ *
+ * The states are the sensor temperature and the rate it changes at, apart from the heater. The heater comes in as a
+ * known input: the SSR through a first order lag (the element heats up before the water does), times the rate at full
+ * power. So switching the heater doesn't look like a disturbance, and what's left of the rate, losses and water flowing
+ * through, is modelled as a random walk.
+ *
+ * Each channel then corrects the prediction with its own measurement variance: the square of how many °C one ADC count
+ * is at the reading, over 12 for the quantization, plus the noise floor. Around brew temperatures the low gain channel
+ * is about a third as fine as the high gain one, so it only gets a small say. It's calibrated separately, so the offset
+ * between it and the estimate is followed slowly and taken off before it's used.
+ *
+ * Unlike the moving average this replaces, the estimate doesn't trail the sensor by a fixed number of samples, and the
+ * rate comes out smooth enough to use, where differencing the readings only gives steps of one ADC count per cycle.
+ */
+template <class Numeric> class BasicTemperatureKalmanFilter {
+public:
+    // Cheap when nothing changed, so fine to call every cycle
+    void configure(const TemperatureFilterSettings &settings);
+
+    // Once per control cycle, with both channels' readings and resolutions (°C per count), whether the SSR was on over
+    // the cycle, and how long that was. The first call starts the filter at the high gain reading.
+    void update(Numeric highGainC, Numeric highGainResolutionC, Numeric lowGainC, Numeric lowGainResolutionC,
+                bool heaterOn, Numeric dT);
+    void reset();
+
+    [[nodiscard]] inline Numeric getTemperature() const { return temperature; }
+    // °C/s, including the heater
+    [[nodiscard]] inline Numeric getRate() const { return heaterRate * heaterDrive + scaledRate / Numeric(KALMAN_RATE_SCALE); }
+private:
+    TemperatureFilterSettings settings{};
+    Numeric heaterRate{};
+    Numeric heaterLagS{};
+    // Per second, in the units of the states
+    Numeric temperatureNoise = Numeric(KALMAN_TEMPERATURE_NOISE);
+    Numeric rateNoise{};
+    Numeric measurementVariance{};
+
+    bool initialized = false;
+    Numeric temperature{};
+    Numeric scaledRate{};
+    // The SSR through the lag, 0-1
+    Numeric heaterDrive{};
+    Numeric lowGainOffset{};
+
+    // Covariance of temperature and scaled rate
+    Numeric p00{};
+    Numeric p01{};
+    Numeric p11{};
+
+    void predict(bool heaterOn, Numeric dT);
+    void correct(Numeric measurement, Numeric variance);
+    [[nodiscard]] Numeric varianceFor(Numeric resolution) const;
+};
+
+template <class Numeric>
+void BasicTemperatureKalmanFilter<Numeric>::configure(const TemperatureFilterSettings &newSettings) {
+    if (settings == newSettings) {
+        return;
+    }
+
+    settings = newSettings;
+    heaterRate = Numeric(settings.heaterRateCPerS);
+    heaterLagS = Numeric(settings.heaterLagS > 0.f ? settings.heaterLagS : 0.f);
+
+    float scaledRateNoise = settings.rateNoise * KALMAN_RATE_SCALE;
+    rateNoise = Numeric(scaledRateNoise * scaledRateNoise);
+    measurementVariance = Numeric(settings.measurementNoiseC * settings.measurementNoiseC);
+}
+
+template <class Numeric>
+void BasicTemperatureKalmanFilter<Numeric>::reset() {
+    initialized = false;
+}
+
+template <class Numeric>
+void BasicTemperatureKalmanFilter<Numeric>::update(Numeric highGainC, Numeric highGainResolutionC, Numeric lowGainC,
+                                                   Numeric lowGainResolutionC, bool heaterOn, Numeric dT) {
+    if (!initialized) {
+        temperature = highGainC;
+        scaledRate = Numeric(0);
+        heaterDrive = heaterOn ? Numeric(1) : Numeric(0);
+        lowGainOffset = lowGainC - highGainC;
+
+        p00 = varianceFor(highGainResolutionC);
+        p01 = Numeric(0);
+        p11 = Numeric(KALMAN_INITIAL_RATE_VARIANCE * KALMAN_RATE_SCALE * KALMAN_RATE_SCALE);
+
+        initialized = true;
+        return;
+    }
+
+    predict(heaterOn, dT);
+    correct(highGainC, varianceFor(highGainResolutionC));
+
+    lowGainOffset += (lowGainC - temperature - lowGainOffset) * dT / (Numeric(KALMAN_LOW_GAIN_OFFSET_TIME_S) + dT);
+    correct(lowGainC - lowGainOffset, varianceFor(lowGainResolutionC));
+}
+
+template <class Numeric>
+void BasicTemperatureKalmanFilter<Numeric>::predict(bool heaterOn, Numeric dT) {
+    Numeric input = heaterOn ? Numeric(1) : Numeric(0);
+    heaterDrive += (input - heaterDrive) * dT / (heaterLagS + dT);
+
+    // °C per unit of scaled rate over this step. Its square is too small to matter, so P11 doesn't feed into P00.
+    Numeric step = dT / Numeric(KALMAN_RATE_SCALE);
+
+    temperature += heaterRate * heaterDrive * dT + scaledRate * step;
+
+    p00 += (p01 + p01) * step + temperatureNoise * dT;
+    p01 += p11 * step;
+    p11 += rateNoise * dT;
+}
+
+template <class Numeric>
+void BasicTemperatureKalmanFilter<Numeric>::correct(Numeric measurement, Numeric variance) {
+    Numeric innovationVariance = p00 + variance;
+    Numeric k0 = p00 / innovationVariance;
+    Numeric k1 = p01 / innovationVariance;
+
+    Numeric innovation = measurement - temperature;
+    temperature += k0 * innovation;
+    scaledRate += k1 * innovation;
+
+    // (I - KH)·P, with the old P on the right
+    Numeric newP11 = p11 - k1 * p01;
+    p00 = p00 - k0 * p00;
+    p01 = p01 - k0 * p01;
+    p11 = newP11 > Numeric(0) ? newP11 : Numeric(0);
+}
+
+template <class Numeric>
+Numeric BasicTemperatureKalmanFilter<Numeric>::varianceFor(Numeric resolution) const {
+    return resolution * resolution / Numeric(12) + measurementVariance;
+}
+
+// The boilers run on Q16.16, see PIDController
+typedef BasicTemperatureKalmanFilter<Q16_16> TemperatureKalmanFilter;
+
+// Reference implementation, to check the fixed point one against
+typedef BasicTemperatureKalmanFilter<double> DoubleTemperatureKalmanFilter;
+
+#endif //SMART_LCC_TEMPERATUREKALMANFILTER_H
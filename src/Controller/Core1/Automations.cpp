@@ -7,6 +7,10 @@
 #include "utils/USBDebug.h"
 
 void Automations::loop(SystemControllerStatusMessage sm) {
+    if (entryCommandsPending) {
+        sendEntryCommands();
+    }
+
     if (!plannedAutoSleepAt.has_value()) {
         resetPlannedSleep();
     } else if (!settingsManager->getSleepMode() && time_reached(plannedAutoSleepAt.value())) {
@@ -54,7 +58,7 @@ void Automations::onBrewStarted() {
     resetPlannedSleep();
 }
 
-Automations::Automations(SettingsManager *settingsManager, PicoQueue<SystemControllerCommand> *commandQueue): settingsManager(settingsManager), commandQueue(commandQueue) {
+Automations::Automations(SettingsManager *settingsManager, CommandChannel *commandChannel): settingsManager(settingsManager), commandChannel(commandChannel) {
     previouslyAsleep = settingsManager->getSleepMode();
     previousAutosleepMinutes = settingsManager->getAutoSleepMin();
 
@@ -139,13 +143,9 @@ void Automations::moveToAutomationStep(uint16_t step) {
         step = 0;
     }
 
-    auto nextStep = currentRoutine.at(step);
-
-    for (auto entryCommand : nextStep.entryCommands) {
-        commandQueue->addBlocking(&entryCommand);
-    }
-
     currentAutomationStep = step;
+    sendEntryCommands();
+
     currentStepStartedAt = get_absolute_time();
 
     if (step == 0) {
@@ -179,4 +179,9 @@ void Automations::unloadRoutine() {
     currentStepStartedAt.reset();
 }
 
+void Automations::sendEntryCommands() {
+    auto &entryCommands = currentRoutine.at(currentAutomationStep).entryCommands;
 
+    // If Core 0 hasn't made room yet, try again on the next loop rather than stalling Core 1
+    entryCommandsPending = !commandChannel->tryPushBatch(entryCommands.data(), entryCommands.size());
+}
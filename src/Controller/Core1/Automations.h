@@ -9,11 +9,12 @@
 #include <pico/time.h>
 #include <vector>
 #include "SettingsManager.h"
+#include "CommandChannel.h"
 #include "Routine/RoutineStep.h"
 
 class Automations {
 public:
-    Automations(SettingsManager* settingsManager, PicoQueue<SystemControllerCommand> *commandQueue);
+    Automations(SettingsManager* settingsManager, CommandChannel *commandChannel);
 
     void loop(SystemControllerStatusMessage sm);
 
@@ -40,6 +41,7 @@ private:
 
     void handleCurrentAutomationStep(SystemControllerStatusMessage sm);
     void moveToAutomationStep(uint16_t step);
+    void sendEntryCommands();
 
     inline float currentBrewTime() {
         return brewStartedAt.has_value() ? (float)(absolute_time_diff_us(brewStartedAt.value(), get_absolute_time())) / 1000.f / 1000.f : 0.f;
@@ -53,13 +55,14 @@ private:
     nonstd::optional<absolute_time_t> brewStartedAt{};
 
     SettingsManager* settingsManager;
-    PicoQueue<SystemControllerCommand> *commandQueue;
+    CommandChannel *commandChannel;
 
     bool previouslyAsleep;
     bool previouslyBrewing = false;
     uint16_t previousAutosleepMinutes = 0;
 
     uint16_t currentAutomationStep = 0;
+    bool entryCommandsPending = false;
     nonstd::optional<absolute_time_t> currentStepStartedAt{};
 
     uint16_t currentlyLoadedRoutine = 0;
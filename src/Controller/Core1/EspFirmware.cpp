@@ -4,6 +4,7 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 #include "EspFirmware.h"
 #include "pico/time.h"
 #include "hardware/regs/rosc.h"
@@ -60,7 +61,7 @@ bool EspFirmware::readFromRingBufferBlockingWithTimeout(uint8_t *dst, size_t len
     return readLen == len;
 }
 
-EspFirmware::EspFirmware(uart_inst_t *uart, PicoQueue<SystemControllerCommand> *commandQueue, SystemStatus* status, SettingsManager* settingsManager, Automations* automations) : uart(uart), commandQueue(commandQueue), status(status), settingsManager(settingsManager), automations(automations) {}
+EspFirmware::EspFirmware(uart_inst_t *uart, CommandChannel *commandChannel, SystemStatus* status, SettingsManager* settingsManager, Automations* automations, GroupHeadController* groupHeadController) : uart(uart), commandChannel(commandChannel), status(status), settingsManager(settingsManager), automations(automations), groupHeadController(groupHeadController) {}
 
 uint32_t rnd(void){
     int k, random=0;
@@ -164,6 +165,8 @@ bool EspFirmware::sendStatus(
             break;
     }
 
+    const AutoTuneStatus &autoTune = systemControllerStatusMessage->autoTune;
+
     ESPSystemStatusMessage statusMessage{
             .internalState = getInternalState(systemControllerStatusMessage->internalState),
             .runState = getRunState(systemControllerStatusMessage->runState),
@@ -193,6 +196,24 @@ bool EspFirmware::sendStatus(
             .serviceBoilerOn = systemControllerStatusMessage->serviceSSRActive,
             .loadedRoutine = currentRoutine,
             .currentRoutineStep = currentRoutineStep,
+            .autoTuneState = getAutoTuneState(autoTune.state),
+            .autoTuneBoiler = autoTune.boiler == AUTOTUNE_BOILER_SERVICE ? ESP_AUTOTUNE_BOILER_SERVICE : ESP_AUTOTUNE_BOILER_BREW,
+            .autoTuneAbortReason = getAutoTuneAbortReason(autoTune.abortReason),
+            .autoTuneCyclesCompleted = autoTune.cyclesCompleted,
+            .autoTuneCyclesRequired = autoTune.cyclesRequired,
+            .autoTuneUltimateGain = autoTune.ultimateGain,
+            .autoTuneUltimatePeriodSeconds = autoTune.ultimatePeriodS,
+            .autoTuneKp = autoTune.result.Kp,
+            .autoTuneKi = autoTune.result.Ki,
+            .autoTuneKd = autoTune.result.Kd,
+            .autoTuneWindupLow = autoTune.result.windupLow,
+            .autoTuneWindupHigh = autoTune.result.windupHigh,
+            .brewBoilerTemperatureRate = systemControllerStatusMessage->brewTemperatureRate,
+            .groupHeadTemperature = groupHeadController->getObserver().getWaterTemperature(),
+            .groupHeadThermocoupleConnected = groupHeadController->getObserver().hasThermocouple(),
+            .groupHeadControl = groupHeadController->getObserverControl(),
+            .groupHeadControlMode = getGroupHeadControlMode(groupHeadController->getMode()),
+            .brewBoilerSetPointCorrection = systemControllerStatusMessage->brewSetPointCorrection,
     };
 
     ringbuffer.consumerClear();
@@ -203,6 +224,99 @@ bool EspFirmware::sendStatus(
     return waitForAck(statusHeader.id);
 }
 
+bool EspFirmware::sendCycleTiming(SystemControllerStatusMessage *systemControllerStatusMessage) {
+    static_assert(ESP_CYCLE_TIMING_HISTOGRAM_BUCKETS == CYCLE_TIMING_HISTOGRAM_BUCKETS, "Histogram size mismatch");
+    static_assert(ESP_PIPELINE_STAGES == PIPELINE_STAGE_COUNT, "Pipeline stage count mismatch");
+
+    ESPMessageHeader timingHeader{
+            .direction = ESP_DIRECTION_RP2040_TO_ESP32,
+            .id = rnd(),
+            .responseTo = 0,
+            .type = ESP_MESSAGE_CYCLE_TIMING,
+            .error = ESP_ERROR_NONE,
+            .version = ESP_RP2040_PROTOCOL_VERSION,
+            .length = sizeof(ESPCycleTimingMessage),
+    };
+
+    const CycleTimingStats &stats = systemControllerStatusMessage->cycleTiming;
+
+    ESPCycleTimingMessage timingMessage{
+            .cycles = stats.cycles,
+            .overruns = stats.overruns,
+            .skippedCycles = stats.skippedCycles,
+            .lastTxDelayUs = stats.lastTxDelayUs,
+            .lastRxUs = stats.lastRxUs,
+            .lastControlUs = stats.lastControlUs,
+            .lastBusyUs = systemControllerStatusMessage->cycleBusyUs,
+            .jitterHistogram = {},
+            .overrunHistogram = {},
+            .stageLastUs = {},
+            .stageMaxUs = {},
+            .stageBudgetUs = {},
+            .stageOverruns = {},
+    };
+
+    memcpy(timingMessage.jitterHistogram, stats.jitter.counts, sizeof(timingMessage.jitterHistogram));
+    memcpy(timingMessage.overrunHistogram, stats.overrun.counts, sizeof(timingMessage.overrunHistogram));
+
+    const PipelineTimingStats &pipeline = systemControllerStatusMessage->pipelineTiming;
+    for (uint8_t i = 0; i < ESP_PIPELINE_STAGES; i++) {
+        timingMessage.stageLastUs[i] = pipeline.stages[i].lastUs;
+        timingMessage.stageMaxUs[i] = pipeline.stages[i].maxUs;
+        timingMessage.stageBudgetUs[i] = pipeline.stages[i].budgetUs;
+        timingMessage.stageOverruns[i] = pipeline.stages[i].overruns;
+    }
+
+    ringbuffer.consumerClear();
+
+    uart_write_blocking(uart, reinterpret_cast<const uint8_t *>(&timingHeader), sizeof(timingHeader));
+    uart_write_blocking(uart, reinterpret_cast<const uint8_t *>(&timingMessage), sizeof(timingMessage));
+
+    return waitForAck(timingHeader.id);
+}
+
+ESPPlantModel EspFirmware::getPlantModel(const PlantModelEstimate &estimate) {
+    return ESPPlantModel{
+            .valid = estimate.valid,
+            .samples = estimate.samples,
+            .gain = estimate.gainC,
+            .timeConstantSeconds = estimate.timeConstantS,
+            .deadTimeSeconds = estimate.deadTimeS,
+            .holdingDuty = estimate.holdingDuty,
+            .predictionError = estimate.predictionErrorC,
+            .suggestedKp = estimate.suggestedPid.Kp,
+            .suggestedKi = estimate.suggestedPid.Ki,
+            .suggestedKd = estimate.suggestedPid.Kd,
+            .suggestedWindupLow = estimate.suggestedPid.windupLow,
+            .suggestedWindupHigh = estimate.suggestedPid.windupHigh,
+    };
+}
+
+bool EspFirmware::sendPlantModel(SystemControllerStatusMessage *systemControllerStatusMessage) {
+    ESPMessageHeader modelHeader{
+            .direction = ESP_DIRECTION_RP2040_TO_ESP32,
+            .id = rnd(),
+            .responseTo = 0,
+            .type = ESP_MESSAGE_PLANT_MODEL,
+            .error = ESP_ERROR_NONE,
+            .version = ESP_RP2040_PROTOCOL_VERSION,
+            .length = sizeof(ESPPlantModelMessage),
+    };
+
+    ESPPlantModelMessage modelMessage{
+            .brewBoiler = getPlantModel(systemControllerStatusMessage->brewPlantModel),
+            .serviceBoiler = getPlantModel(systemControllerStatusMessage->servicePlantModel),
+            .adaptivePid = settingsManager->getAdaptivePid(),
+    };
+
+    ringbuffer.consumerClear();
+
+    uart_write_blocking(uart, reinterpret_cast<const uint8_t *>(&modelHeader), sizeof(modelHeader));
+    uart_write_blocking(uart, reinterpret_cast<const uint8_t *>(&modelMessage), sizeof(modelMessage));
+
+    return waitForAck(modelHeader.id);
+}
+
 bool EspFirmware::waitForAck(uint32_t id) {
     ESPMessageHeader replyHeader{};
 
@@ -244,6 +358,8 @@ void EspFirmware::loop() {
                     case ESP_MESSAGE_ACK:
                     case ESP_MESSAGE_NACK:
                     case ESP_MESSAGE_SYSTEM_STATUS:
+                    case ESP_MESSAGE_CYCLE_TIMING:
+                    case ESP_MESSAGE_PLANT_MODEL:
                     default:
                         ringbuffer.consumerClear();
                         return;
@@ -286,6 +402,11 @@ void EspFirmware::handleCommand(ESPMessageHeader *header) {
             if (crc == message.checksum) {
                 USB_PRINTF("Command received, CRC correct, type: %u, i1: %u\n", message.payload.type, message.payload.int1);
 
+                // Commands that go straight to Core 0 may not fit if it has stopped draining the channel
+                bool enqueued = true;
+                // Settings out of range are refused by SettingsManager
+                bool accepted = true;
+
                 switch (message.payload.type) {
                     case ESP_SYSTEM_COMMAND_SET_SLEEP_MODE:
                         if (!message.payload.bool1) {
@@ -296,30 +417,32 @@ void EspFirmware::handleCommand(ESPMessageHeader *header) {
                     case ESP_SYSTEM_COMMAND_SET_BREW_SET_POINT:
                         settingsManager->setOffsetTargetBrewTemp(message.payload.float1);
                         break;
-                    case ESP_SYSTEM_COMMAND_SET_BREW_PID_PARAMETERS:
-                        settingsManager->setBrewPidParameters(PidSettings{
-                                .Kp = message.payload.float1,
-                                .Ki = message.payload.float2,
-                                .Kd = message.payload.float3,
-                                .windupLow = message.payload.float4,
-                                .windupHigh = message.payload.float5
-                        });
+                    case ESP_SYSTEM_COMMAND_SET_BREW_PID_PARAMETERS: {
+                        PidSettings pid = settingsManager->getBrewPidParameters();
+                        pid.Kp = message.payload.float1;
+                        pid.Ki = message.payload.float2;
+                        pid.Kd = message.payload.float3;
+                        pid.windupLow = message.payload.float4;
+                        pid.windupHigh = message.payload.float5;
+                        accepted = settingsManager->setBrewPidParameters(pid);
                         break;
+                    }
                     case ESP_SYSTEM_COMMAND_SET_BREW_OFFSET:
                         settingsManager->setBrewTemperatureOffset(message.payload.float1);
                         break;
                     case ESP_SYSTEM_COMMAND_SET_SERVICE_SET_POINT:
                         settingsManager->setTargetServiceTemp(message.payload.float1);
                         break;
-                    case ESP_SYSTEM_COMMAND_SET_SERVICE_PID_PARAMETERS:
-                        settingsManager->setServicePidParameters(PidSettings{
-                                .Kp = message.payload.float1,
-                                .Ki = message.payload.float2,
-                                .Kd = message.payload.float3,
-                                .windupLow = message.payload.float4,
-                                .windupHigh = message.payload.float5
-                        });
+                    case ESP_SYSTEM_COMMAND_SET_SERVICE_PID_PARAMETERS: {
+                        PidSettings pid = settingsManager->getServicePidParameters();
+                        pid.Kp = message.payload.float1;
+                        pid.Ki = message.payload.float2;
+                        pid.Kd = message.payload.float3;
+                        pid.windupLow = message.payload.float4;
+                        pid.windupHigh = message.payload.float5;
+                        accepted = settingsManager->setServicePidParameters(pid);
                         break;
+                    }
                     case ESP_SYSTEM_COMMAND_SET_ECO_MODE:
                         settingsManager->setEcoMode(message.payload.bool1);
                         break;
@@ -328,7 +451,7 @@ void EspFirmware::handleCommand(ESPMessageHeader *header) {
                         break;
                     case ESP_SYSTEM_COMMAND_FORCE_HARD_BAIL: {
                         auto command = SystemControllerCommand{.type = COMMAND_FORCE_HARD_BAIL};
-                        commandQueue->addBlocking(&command);
+                        enqueued = commandChannel->tryPush(command);
                         break;
                     }
                     case ESP_SYSTEM_COMMAND_SET_FLOW_MODE: {
@@ -351,7 +474,7 @@ void EspFirmware::handleCommand(ESPMessageHeader *header) {
                         }
 
                         auto command = SystemControllerCommand{.type = COMMAND_SET_FLOW_MODE, .int1 = arg};
-                        commandQueue->addBlocking(&command);
+                        enqueued = commandChannel->tryPush(command);
                         break;
                     }
                     case ESP_SYSTEM_COMMAND_ENQUEUE_ROUTINE:
@@ -359,9 +482,124 @@ void EspFirmware::handleCommand(ESPMessageHeader *header) {
                         break;
                     case ESP_SYSTEM_COMMAND_CLEAR_ROUTINE:
                         automations->cancelRoutine();
+                        break;
+                    case ESP_SYSTEM_COMMAND_START_AUTOTUNE: {
+                        uint32_t boiler = message.payload.int1 == ESP_AUTOTUNE_BOILER_SERVICE ? AUTOTUNE_BOILER_SERVICE : AUTOTUNE_BOILER_BREW;
+                        auto command = SystemControllerCommand{.type = COMMAND_START_AUTOTUNE, .int1 = boiler};
+                        enqueued = commandChannel->tryPush(command);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_CANCEL_AUTOTUNE: {
+                        auto command = SystemControllerCommand{.type = COMMAND_CANCEL_AUTOTUNE};
+                        enqueued = commandChannel->tryPush(command);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_ADAPTIVE_PID:
+                        settingsManager->setAdaptivePid(message.payload.bool1);
+                        break;
+                    case ESP_SYSTEM_COMMAND_SET_BREW_FEED_FORWARD: {
+                        BrewFeedForwardSettings feedForward = settingsManager->getBrewFeedForward();
+                        feedForward.gain = message.payload.float1;
+                        feedForward.pumpFlowGramsPerS = message.payload.float2;
+                        feedForward.lineFlowGramsPerS = message.payload.float3;
+                        feedForward.tankTemperatureC = message.payload.float4;
+                        feedForward.heatExchangerEffectiveness = message.payload.float5;
+                        accepted = settingsManager->setBrewFeedForward(feedForward);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_BREW_FEED_FORWARD_LEAD: {
+                        BrewFeedForwardSettings feedForward = settingsManager->getBrewFeedForward();
+                        feedForward.leadGain = message.payload.float1;
+                        feedForward.leadTimeS = message.payload.float2;
+                        accepted = settingsManager->setBrewFeedForward(feedForward);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_BREW_SMITH_PREDICTOR:
+                        accepted = settingsManager->setBrewSmithPredictor(SmithPredictorSettings{
+                                .enabled = message.payload.bool1,
+                                .gainC = message.payload.float1,
+                                .timeConstantS = message.payload.float2,
+                                .deadTimeS = message.payload.float3,
+                        });
+                        break;
+                    case ESP_SYSTEM_COMMAND_SET_BREW_PID_SHAPING: {
+                        PidSettings pid = settingsManager->getBrewPidParameters();
+                        pid.setPointWeight = message.payload.float1;
+                        pid.derivativeFilterS = message.payload.float2;
+                        pid.setPointRampCPerS = message.payload.float3;
+                        accepted = settingsManager->setBrewPidParameters(pid);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_SERVICE_PID_SHAPING: {
+                        PidSettings pid = settingsManager->getServicePidParameters();
+                        pid.setPointWeight = message.payload.float1;
+                        pid.derivativeFilterS = message.payload.float2;
+                        pid.setPointRampCPerS = message.payload.float3;
+                        accepted = settingsManager->setServicePidParameters(pid);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_BREW_PID_SCHEDULE: {
+                        PidScheduleSettings schedule = settingsManager->getBrewPidSchedule();
+                        schedule.enabled = message.payload.bool1;
+                        schedule.transitionS = message.payload.float1;
+                        schedule.recoveryS = message.payload.float2;
+                        settingsManager->setBrewPidSchedule(schedule);
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_BREW_PID_SCHEDULE_GAINS: {
+                        PidRegime regime;
+                        switch (message.payload.int1) {
+                            case ESP_PID_REGIME_BREWING:
+                                regime = PID_REGIME_BREWING;
+                                break;
+                            case ESP_PID_REGIME_RECOVERY:
+                                regime = PID_REGIME_RECOVERY;
+                                break;
+                            case ESP_PID_REGIME_SLEEP:
+                                regime = PID_REGIME_SLEEP;
+                                break;
+                            default:
+                                regime = PID_REGIME_IDLE;
+                        }
+
+                        accepted = settingsManager->setBrewPidScheduleGains(regime, PidGains{
+                                .Kp = message.payload.float1,
+                                .Ki = message.payload.float2,
+                                .Kd = message.payload.float3,
+                                .windupLow = message.payload.float4,
+                                .windupHigh = message.payload.float5
+                        });
+                        break;
+                    }
+                    case ESP_SYSTEM_COMMAND_SET_BREW_TEMPERATURE_FILTER:
+                        accepted = settingsManager->setBrewTemperatureFilter(TemperatureFilterSettings{
+                                .enabled = message.payload.bool1,
+                                .heaterRateCPerS = message.payload.float1,
+                                .heaterLagS = message.payload.float2,
+                                .rateNoise = message.payload.float3,
+                                .measurementNoiseC = message.payload.float4,
+                        });
+                        break;
+                    case ESP_SYSTEM_COMMAND_SET_GROUP_HEAD_CONTROL:
+                        groupHeadController->setObserverControl(message.payload.bool1);
+                        break;
+                    case ESP_SYSTEM_COMMAND_SET_GROUP_HEAD_CASCADE:
+                        settingsManager->setGroupHeadCascade(GroupHeadCascadeSettings{
+                                .enabled = message.payload.bool1,
+                                .targetC = message.payload.float1,
+                                .Kp = message.payload.float2,
+                                .Ki = message.payload.float3,
+                        });
+                        break;
                 }
 
-                sendAck(header->id);
+                if (!accepted) {
+                    sendNack(header->id, ESP_ERROR_INVALID_SETTING);
+                } else if (enqueued) {
+                    sendAck(header->id);
+                } else {
+                    sendNack(header->id, ESP_ERROR_COMMAND_QUEUE_FULL);
+                }
             } else {
                 sendNack(header->id, ESP_ERROR_INVALID_CHECKSUM);
             }
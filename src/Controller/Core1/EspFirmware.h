@@ -11,15 +11,16 @@
 #include "utils/ClearUartCruft.h"
 #include "utils/UartReadBlockingTimeout.h"
 #include "types.h"
-#include "utils/PicoQueue.h"
+#include "CommandChannel.h"
 #include "ringbuffer.hpp"
 #include "SystemStatus.h"
 #include "SettingsManager.h"
 #include "Automations.h"
+#include "GroupHeadController.h"
 
 class EspFirmware {
 public:
-    explicit EspFirmware(uart_inst_t *uart, PicoQueue<SystemControllerCommand> *commandQueue, SystemStatus* status, SettingsManager* settingsManager, Automations* automations);
+    explicit EspFirmware(uart_inst_t *uart, CommandChannel *commandChannel, SystemStatus* status, SettingsManager* settingsManager, Automations* automations, GroupHeadController* groupHeadController);
 
     void loop();
 
@@ -38,13 +39,16 @@ public:
                     uint16_t currentRoutine,
                     uint16_t currentRoutineStep
                             );
+    bool sendCycleTiming(SystemControllerStatusMessage *systemControllerStatusMessage);
+    bool sendPlantModel(SystemControllerStatusMessage *systemControllerStatusMessage);
 
 private:
     uart_inst_t *uart;
-    PicoQueue<SystemControllerCommand> *commandQueue;
+    CommandChannel *commandChannel;
     SystemStatus* status;
     SettingsManager* settingsManager;
     Automations* automations;
+    GroupHeadController* groupHeadController;
 
     bool waitForAck(uint32_t id);
     void handleESPStatus(ESPMessageHeader *header);
@@ -55,6 +59,8 @@ private:
 
     static bool readFromRingBufferBlockingWithTimeout(uint8_t *dst, size_t len, absolute_time_t timeout_time);
 
+    static ESPPlantModel getPlantModel(const PlantModelEstimate &estimate);
+
     static inline ESPSystemInternalState getInternalState(SystemControllerInternalState state) {
         switch(state) {
             case NOT_STARTED_YET:
@@ -77,6 +83,8 @@ private:
                 return ESP_SYSTEM_RUN_STATE_HEATUP_STAGE_2;
             case RUN_STATE_NORMAL:
                 return ESP_SYSTEM_RUN_STATE_NORMAL;
+            case RUN_STATE_AUTOTUNE:
+                return ESP_SYSTEM_RUN_STATE_AUTOTUNE;
             case RUN_STATE_UNDETEMINED:
             default:
                 return ESP_SYSTEM_RUN_STATE_UNDETEMINED;
@@ -97,11 +105,65 @@ private:
                 return ESP_SYSTEM_COALESCED_STATE_BAILED;
             case SYSTEM_CONTROLLER_COALESCED_STATE_FIRST_RUN:
                 return ESP_SYSTEM_COALESCED_STATE_FIRST_RUN;
+            case SYSTEM_CONTROLLER_COALESCED_STATE_AUTOTUNING:
+                return ESP_SYSTEM_COALESCED_STATE_AUTOTUNING;
             case SYSTEM_CONTROLLER_COALESCED_STATE_UNDETERMINED:
             default:
                 return ESP_SYSTEM_COALESCED_STATE_UNDETERMINED;
         }
     }
+
+    static inline ESPGroupHeadControlMode getGroupHeadControlMode(GroupHeadControlMode mode) {
+        switch (mode) {
+            case GROUP_HEAD_CONTROL_OBSERVER:
+                return ESP_GROUP_HEAD_CONTROL_OBSERVER;
+            case GROUP_HEAD_CONTROL_CASCADE:
+                return ESP_GROUP_HEAD_CONTROL_CASCADE;
+            case GROUP_HEAD_CONTROL_NONE:
+            default:
+                return ESP_GROUP_HEAD_CONTROL_NONE;
+        }
+    }
+
+    static inline ESPAutoTuneState getAutoTuneState(AutoTuneState state) {
+        switch (state) {
+            case AUTOTUNE_STATE_APPROACHING:
+                return ESP_AUTOTUNE_STATE_APPROACHING;
+            case AUTOTUNE_STATE_OSCILLATING:
+                return ESP_AUTOTUNE_STATE_OSCILLATING;
+            case AUTOTUNE_STATE_DONE:
+                return ESP_AUTOTUNE_STATE_DONE;
+            case AUTOTUNE_STATE_ABORTED:
+                return ESP_AUTOTUNE_STATE_ABORTED;
+            case AUTOTUNE_STATE_IDLE:
+            default:
+                return ESP_AUTOTUNE_STATE_IDLE;
+        }
+    }
+
+    static inline ESPAutoTuneAbortReason getAutoTuneAbortReason(AutoTuneAbortReason reason) {
+        switch (reason) {
+            case AUTOTUNE_ABORT_NOT_READY:
+                return ESP_AUTOTUNE_ABORT_NOT_READY;
+            case AUTOTUNE_ABORT_CANCELLED:
+                return ESP_AUTOTUNE_ABORT_CANCELLED;
+            case AUTOTUNE_ABORT_BAILED:
+                return ESP_AUTOTUNE_ABORT_BAILED;
+            case AUTOTUNE_ABORT_BREW_STARTED:
+                return ESP_AUTOTUNE_ABORT_BREW_STARTED;
+            case AUTOTUNE_ABORT_SLEEP_MODE:
+                return ESP_AUTOTUNE_ABORT_SLEEP_MODE;
+            case AUTOTUNE_ABORT_ECO_MODE:
+                return ESP_AUTOTUNE_ABORT_ECO_MODE;
+            case AUTOTUNE_ABORT_TIMEOUT:
+                return ESP_AUTOTUNE_ABORT_TIMEOUT;
+            case AUTOTUNE_ABORT_NO_OSCILLATION:
+                return ESP_AUTOTUNE_ABORT_NO_OSCILLATION;
+            case AUTOTUNE_ABORT_NONE:
+            default:
+                return ESP_AUTOTUNE_ABORT_NONE;
+        }
+    }
 };
 
 
@@ -0,0 +1,93 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include "GroupHeadController.h"
+
+static inline float clampCorrection(float correction) {
+    return std::fmin(std::fmax(correction, -BREW_SET_POINT_CORRECTION_LIMIT_C), BREW_SET_POINT_CORRECTION_LIMIT_C);
+}
+
+GroupHeadController::GroupHeadController(CommandChannel *commandChannel): commandChannel(commandChannel) {}
+
+void GroupHeadController::update(const SystemControllerStatusMessage &sm, nonstd::optional<float> thermocoupleC,
+                                 const GroupHeadCascadeSettings &cascade) {
+    observer.update(sm, thermocoupleC);
+
+    float dT = lastUpdateAt.has_value() ? (float)absolute_time_diff_us(lastUpdateAt.value(), sm.timestamp) / 1e6f : 0.f;
+    if (dT < 0.f) {
+        dT = 0.f;
+    }
+    lastUpdateAt = sm.timestamp;
+
+    GroupHeadControlMode newMode = GROUP_HEAD_CONTROL_NONE;
+    if (observer.hasThermocouple()) {
+        if (cascade.enabled) {
+            newMode = GROUP_HEAD_CONTROL_CASCADE;
+        } else if (observerControl) {
+            newMode = GROUP_HEAD_CONTROL_OBSERVER;
+        }
+    }
+
+    // Each mode starts from what's applied now, rather than from where it last left off. Except for the cascade
+    // getting its thermocouple back: the group needs about as much as it did before, and the rate limit keeps the
+    // correction from jumping there.
+    if (newMode != mode) {
+        bool thermocoupleLost = mode == GROUP_HEAD_CONTROL_CASCADE && !observer.hasThermocouple() && cascade.enabled;
+        if (thermocoupleLost) {
+            heldIntegralC = integralC;
+        } else if (newMode != GROUP_HEAD_CONTROL_CASCADE) {
+            heldIntegralC.reset();
+        }
+
+        integralC = correctionC;
+        if (newMode == GROUP_HEAD_CONTROL_CASCADE) {
+            integralC = heldIntegralC.has_value()
+                    ? heldIntegralC.value()
+                    : clampCorrection(correctionC - cascade.Kp * (cascade.targetC - thermocoupleC.value()));
+            heldIntegralC.reset();
+        }
+
+        mode = newMode;
+    }
+
+    if (mode == GROUP_HEAD_CONTROL_NONE) {
+        // Plain boiler control, whether asked for or because the thermocouple went away
+        correctionC = 0.f;
+        integralC = 0.f;
+    } else if (!sm.currentlyBrewing && !sm.sleepMode && sm.runState == RUN_STATE_NORMAL) {
+        float targetC = mode == GROUP_HEAD_CONTROL_CASCADE
+                ? cascadeCorrection(cascade, thermocoupleC.value(), dT)
+                : observer.getSetPointCorrection();
+
+        float maxStepC = GROUP_HEAD_CORRECTION_RATE_C_PER_S * dT;
+        correctionC += std::fmin(std::fmax(targetC - correctionC, -maxStepC), maxStepC);
+    }
+
+    bool due = !correctionSentAt.has_value() || absolute_time_diff_us(correctionSentAt.value(), get_absolute_time()) >= GROUP_HEAD_CORRECTION_INTERVAL_MS * 1000ll;
+    if ((due && (correctionC != 0.f || sentCorrectionC != 0.f)) || (correctionC == 0.f && sentCorrectionC != 0.f)) {
+        sendCorrection();
+    }
+}
+
+float GroupHeadController::cascadeCorrection(const GroupHeadCascadeSettings &cascade, float thermocoupleC, float dT) {
+    float errorC = cascade.targetC - thermocoupleC;
+
+    // The integral alone can't go past the limit, so it doesn't wind up while the group can't keep up
+    integralC = clampCorrection(integralC + cascade.Ki * errorC * dT);
+
+    return clampCorrection(cascade.Kp * errorC + integralC);
+}
+
+void GroupHeadController::setObserverControl(bool newObserverControl) {
+    observerControl = newObserverControl;
+}
+
+void GroupHeadController::sendCorrection() {
+    // If Core 0 hasn't made room, the next update tries again
+    if (commandChannel->tryPush(SystemControllerCommand{.type = COMMAND_SET_BREW_SET_POINT_CORRECTION, .float1 = correctionC})) {
+        correctionSentAt = get_absolute_time();
+        sentCorrectionC = correctionC;
+    }
+}
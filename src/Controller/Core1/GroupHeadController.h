@@ -0,0 +1,75 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_GROUPHEADCONTROLLER_H
+#define SMART_LCC_GROUPHEADCONTROLLER_H
+
+#include <optional.hpp>
+#include <pico/time.h>
+#include "types.h"
+#include "CommandChannel.h"
+#include "GroupHeadObserver.h"
+
+// How fast the brew set point correction may move, °C/s
+#define GROUP_HEAD_CORRECTION_RATE_C_PER_S 0.02f
+// Sent this often while there is a correction, well within BREW_SET_POINT_CORRECTION_TIMEOUT_MS
+#define GROUP_HEAD_CORRECTION_INTERVAL_MS 1000
+
+typedef enum {
+    GROUP_HEAD_CONTROL_NONE,
+    // The observer's correction, to get the water at the group to the offset set point
+    GROUP_HEAD_CONTROL_OBSERVER,
+    // The cascade, to get the thermocouple to its target
+    GROUP_HEAD_CONTROL_CASCADE,
+} GroupHeadControlMode;
+
+/*
+ * Moves the brew set point by the group head, through Core 0's brew set point correction. The brew boiler controller
+ * itself doesn't change, it just gets a different set point.
+ *
+ * With the cascade enabled, a PI loop around the brew boiler's moves the set point until the group thermocouple reads
+ * the cascade target. Otherwise, if observer control is on (not saved), the set point follows the observer. Either way
+ * the correction:
+ *  - stays within BREW_SET_POINT_CORRECTION_LIMIT_C of the user's set point,
+ *  - moves no faster than GROUP_HEAD_CORRECTION_RATE_C_PER_S,
+ *  - holds through brews, sleep and heat-up, where the group is off on its own,
+ *  - and drops straight back to plain boiler control when the thermocouple goes away.
+ */
+class GroupHeadController {
+public:
+    explicit GroupHeadController(CommandChannel *commandChannel);
+
+    // With every new status from Core 0, the latest group thermocouple reading if there is a thermocouple, and the
+    // current cascade settings
+    void update(const SystemControllerStatusMessage &sm, nonstd::optional<float> thermocoupleC,
+                const GroupHeadCascadeSettings &cascade);
+
+    void setObserverControl(bool observerControl);
+
+    [[nodiscard]] inline bool getObserverControl() const { return observerControl; }
+    [[nodiscard]] inline GroupHeadControlMode getMode() const { return mode; }
+    [[nodiscard]] inline const GroupHeadObserver &getObserver() const { return observer; }
+    [[nodiscard]] inline float getSetPointCorrection() const { return correctionC; }
+private:
+    CommandChannel *commandChannel;
+    GroupHeadObserver observer{};
+
+    nonstd::optional<absolute_time_t> lastUpdateAt{};
+    nonstd::optional<absolute_time_t> correctionSentAt{};
+
+    bool observerControl = false;
+    GroupHeadControlMode mode = GROUP_HEAD_CONTROL_NONE;
+
+    float integralC = 0.f;
+    // The cascade's integral from before the thermocouple went away
+    nonstd::optional<float> heldIntegralC{};
+    float correctionC = 0.f;
+    float sentCorrectionC = 0.f;
+
+    [[nodiscard]] float cascadeCorrection(const GroupHeadCascadeSettings &cascade, float thermocoupleC, float dT);
+    void sendCorrection();
+};
+
+
+#endif //SMART_LCC_GROUPHEADCONTROLLER_H
@@ -0,0 +1,68 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#include <cmath>
+#include "GroupHeadObserver.h"
+
+void GroupHeadObserver::update(const SystemControllerStatusMessage &sm, nonstd::optional<float> thermocoupleC) {
+    thermocoupleConnected = thermocoupleC.has_value()
+            && thermocoupleC.value() >= GROUP_HEAD_THERMOCOUPLE_MIN_C
+            && thermocoupleC.value() <= GROUP_HEAD_THERMOCOUPLE_MAX_C;
+
+    float boilerC = sm.brewTemperature;
+
+    if (!lastUpdateAt.has_value()) {
+        if (thermocoupleConnected) {
+            groupC = thermocoupleC.value();
+        } else {
+            // Where the model settles with the boiler where it is now
+            float idle = 1.f / GROUP_HEAD_IDLE_TIME_CONSTANT_S;
+            float loss = 1.f / GROUP_HEAD_LOSS_TIME_CONSTANT_S;
+            groupC = (boilerC * idle + GROUP_HEAD_AMBIENT_C * loss) / (idle + loss);
+        }
+    } else {
+        float dT = (float)absolute_time_diff_us(lastUpdateAt.value(), sm.timestamp) / 1e6f;
+        if (dT < 0.f) {
+            dT = 0.f;
+        }
+
+        float coupling = 1.f / GROUP_HEAD_IDLE_TIME_CONSTANT_S;
+        if (sm.currentlyBrewing) {
+            coupling += 1.f / GROUP_HEAD_FLOW_TIME_CONSTANT_S;
+        }
+
+        float change = coupling * (boilerC - groupC) - (groupC - GROUP_HEAD_AMBIENT_C) / GROUP_HEAD_LOSS_TIME_CONSTANT_S;
+        if (thermocoupleConnected) {
+            change += (thermocoupleC.value() - groupC) / GROUP_HEAD_OBSERVER_TIME_CONSTANT_S;
+        }
+
+        groupC += change * dT;
+
+        updateCorrection(sm, dT);
+    }
+
+    lastUpdateAt = sm.timestamp;
+
+    float leftBoilerC = boilerC - sm.brewTemperatureRate * GROUP_HEAD_TRANSPORT_DELAY_S;
+    waterC = leftBoilerC - GROUP_HEAD_EFFECTIVENESS * (leftBoilerC - groupC);
+}
+
+void GroupHeadObserver::updateCorrection(const SystemControllerStatusMessage &sm, float dT) {
+    if (!thermocoupleConnected) {
+        correctionC = 0.f;
+        return;
+    }
+
+    // The water would lose as much in the group after a shot, or before reaching the set point
+    if (sm.currentlyBrewing || sm.sleepMode || sm.runState != RUN_STATE_NORMAL) {
+        return;
+    }
+
+    // At steady state, so without the rate
+    float observedOffsetC = -GROUP_HEAD_EFFECTIVENESS * (sm.brewTemperature - groupC);
+    float targetC = sm.brewTemperatureOffset - observedOffsetC;
+
+    correctionC += (targetC - correctionC) * dT / (GROUP_HEAD_CORRECTION_TIME_CONSTANT_S + dT);
+    correctionC = std::fmin(std::fmax(correctionC, -BREW_SET_POINT_CORRECTION_LIMIT_C), BREW_SET_POINT_CORRECTION_LIMIT_C);
+}
@@ -0,0 +1,70 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_GROUPHEADOBSERVER_H
+#define SMART_LCC_GROUPHEADOBSERVER_H
+
+#include <optional.hpp>
+#include <pico/time.h>
+#include "types.h"
+
+// How fast the group follows the boiler with no water flowing, through the brass and the thermosiphon, s
+#define GROUP_HEAD_IDLE_TIME_CONSTANT_S 300.f
+// And additionally while water flows through it, s
+#define GROUP_HEAD_FLOW_TIME_CONSTANT_S 90.f
+// Losses to the room, s
+#define GROUP_HEAD_LOSS_TIME_CONSTANT_S 1700.f
+#define GROUP_HEAD_AMBIENT_C 25.f
+// How much of the difference between boiler and group the water loses on its way through the group, 0-1
+#define GROUP_HEAD_EFFECTIVENESS 0.8f
+// From the boiler to the group, s
+#define GROUP_HEAD_TRANSPORT_DELAY_S 3.f
+// How hard the thermocouple pulls the model in, s
+#define GROUP_HEAD_OBSERVER_TIME_CONSTANT_S 20.f
+// Readings outside this are taken as no thermocouple, °C
+#define GROUP_HEAD_THERMOCOUPLE_MIN_C 5.f
+#define GROUP_HEAD_THERMOCOUPLE_MAX_C 150.f
+
+// The set point correction follows the observed offset this slowly, s
+#define GROUP_HEAD_CORRECTION_TIME_CONSTANT_S 60.f
+
+/*
+ * Estimates the temperature of the water coming out of the group, rather than assuming a fixed offset from the brew
+ * boiler (brewTemperatureOffset).
+ *
+ * The state is the temperature of the group itself. It follows the boiler slowly, quicker while water flows through
+ * it, and loses heat to the room. The water leaving the boiler loses GROUP_HEAD_EFFECTIVENESS of its difference to the
+ * group on the way through, and left the boiler GROUP_HEAD_TRANSPORT_DELAY_S ago. The heater comes in through the rate
+ * of the brew boiler temperature, which the filter on Core 0 drives with the SSR.
+ *
+ * A thermocouple on the group pulls the group temperature towards what it reads. Without one, the model runs on its
+ * own, which is about as good as the fixed offset: the defaults give about the same offset at 105 °C.
+ *
+ * The difference between the fixed offset and the observed one is the brew set point correction that would get the
+ * water at the group to the offset set point, see GroupHeadController. It only moves outside of brews in normal
+ * operation, and is zero without a thermocouple.
+ */
+class GroupHeadObserver {
+public:
+    // With every new status from Core 0 and the latest group thermocouple reading, if there is a thermocouple
+    void update(const SystemControllerStatusMessage &sm, nonstd::optional<float> thermocoupleC);
+
+    [[nodiscard]] inline bool hasThermocouple() const { return thermocoupleConnected; }
+    // Water at the group, °C. Comparable to the offset brew temperature.
+    [[nodiscard]] inline float getWaterTemperature() const { return waterC; }
+    [[nodiscard]] inline float getSetPointCorrection() const { return correctionC; }
+private:
+    nonstd::optional<absolute_time_t> lastUpdateAt{};
+
+    bool thermocoupleConnected = false;
+
+    float groupC = 0.f;
+    float waterC = 0.f;
+    float correctionC = 0.f;
+
+    void updateCorrection(const SystemControllerStatusMessage &sm, float dT);
+};
+
+
+#endif //SMART_LCC_GROUPHEADOBSERVER_H
@@ -20,6 +20,9 @@ float MCP9600::readTemperature(unsigned char status_mode) {
     }
 
     int16_t raw = readDoubleRegister(MCP9600_REGISTER_HOT_JUNC_TEMP);
+    if (!isPresent) {
+        return lastReadHotJunctionTemperature;
+    }
 
     uint8_t status = readRegisterByte(MCP9600_REGISTER_SENSOR_STATUS);
     status &= 0xBF;
@@ -38,11 +41,13 @@ bool MCP9600::writeRegisterByte(MCP9600Register mcp9600Register, uint8_t data) {
 }
 
 uint8_t MCP9600::readRegisterByte(MCP9600Register reg) {
-    i2c_write_blocking(i2c_, addr_, reinterpret_cast<const uint8_t *>(&reg), sizeof(reg), false);
+    uint8_t byte = 0;
 
-    uint8_t byte;
-
-    i2c_read_blocking(i2c_, addr_, &byte, sizeof(byte), false);
+    if (i2c_write_blocking(i2c_, addr_, reinterpret_cast<const uint8_t *>(&reg), sizeof(reg), false) != sizeof(reg)
+        || i2c_read_blocking(i2c_, addr_, &byte, sizeof(byte), false) != sizeof(byte)) {
+        markLost();
+        return 0;
+    }
 
     return byte;
 }
@@ -67,25 +72,43 @@ bool MCP9600::isConnected() {
         uint8_t rxdata;
         auto ret = i2c_read_blocking(i2c_, addr_, &rxdata, 1, false);
         isPresent = ret > 0;
+
+        // It may have been power cycled while it was gone
+        if (isPresent && wasLost) {
+            wasLost = false;
+            initialize();
+        }
     }
 
     return isPresent;
 }
 
+void MCP9600::markLost() {
+    if (isPresent) {
+        USB_PRINTF("MCP9600 0x%02x lost\n", addr_);
+    }
+
+    isPresent = false;
+    wasLost = true;
+}
+
 uint16_t MCP9600::readDoubleRegister(MCP9600Register reg) {
     //Attempt to read the register until we exit with no error code
     //This attempts to fix the bug where clock stretching sometimes failes, as
     //described in the MCP9600 eratta
     for (uint8_t attempts = 0; attempts <= 3; attempts++)
     {
-        i2c_write_blocking(i2c_, addr_, reinterpret_cast<const uint8_t *>(&reg), sizeof(reg), false);
-
         uint8_t bytes[2];
-        i2c_read_blocking(i2c_, addr_, bytes, 2, false);
+        if (i2c_write_blocking(i2c_, addr_, reinterpret_cast<const uint8_t *>(&reg), sizeof(reg), false) != sizeof(reg)
+            || i2c_read_blocking(i2c_, addr_, bytes, 2, false) != 2) {
+            continue;
+        }
 
         uint16_t data = bytes[0] << 8;
         data |= bytes[1];
         return data;
     }
+
+    markLost();
     return (0);
 }
@@ -56,6 +56,7 @@ public:
 
 private:
     bool statusCheck(uint8_t status);
+    void markLost();
 
     bool writeRegisterByte(MCP9600Register reg, uint8_t data);
     uint8_t readRegisterByte(MCP9600Register reg);
@@ -67,6 +68,8 @@ private:
     MCP9600ProbeType probeType_;
 
     bool isPresent = false;
+    // A read failed, so it has to be found and set up again
+    bool wasLost = false;
 
     float lastReadHotJunctionTemperature = 0.f;
 };
@@ -3,12 +3,13 @@
 //
 
 #include <cstring>
+#include <cmath>
 #include "SettingsManager.h"
 #include "utils/crc32.h"
 #include "hardware/watchdog.h"
 #include "utils/USBDebug.h"
 
-#define SETTINGS_CURRENT_VERSION 0x01
+#define SETTINGS_CURRENT_VERSION 0x02
 #define SETTINGS_ADDR 0x00000000
 
 struct SettingsHeader{
@@ -17,59 +18,77 @@ struct SettingsHeader{
     size_t len;
 };
 
-const SettingStruct defaultSettings{
-        .brewTemperatureOffset = -10,
-        .sleepMode = false,
-        .ecoMode = false,
-        .brewTemperatureTarget = 105,
-        .serviceTemperatureTarget = 120,
-        .autoSleepMin = 0,
-        .brewPidParameters = PidSettings{.Kp = 0.8, .Ki = 0.12, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f},
-        .servicePidParameters = PidSettings{.Kp = 0.6, .Ki = 0.1, .Kd = 1.0, .windupLow = -10.f, .windupHigh = 10.f},
+// What the baseline firmware wrote, before the PID and brew boiler settings that came after it. Read and migrated, so an
+// update doesn't throw away the user's temperatures and PID settings.
+#define SETTINGS_V1_VERSION 0x01
+
+struct PidSettingsV1 {
+    float Kp;
+    float Ki;
+    float Kd;
+    float windupLow;
+    float windupHigh;
+};
+
+struct SettingStructV1 {
+    float brewTemperatureOffset;
+    bool sleepMode;
+    bool ecoMode;
+    float brewTemperatureTarget;
+    float serviceTemperatureTarget;
+    uint16_t autoSleepMin;
+    PidSettingsV1 brewPidParameters;
+    PidSettingsV1 servicePidParameters;
 };
 
-SettingsManager::SettingsManager(PicoQueue<SystemControllerCommand> *commandQueue, SettingsFlash* settingsFlash): commandQueue(commandQueue), settingsFlash(settingsFlash) {
+static_assert(sizeof(SettingsHeader) + sizeof(SettingStructV1) <= SETTINGS_FLASH_PAGE_SIZE);
+
+// Longest blend between brew PID regimes, and longest recovery regime after a brew, s
+#define PID_SCHEDULE_MAX_TRANSITION_S 600.f
+#define PID_SCHEDULE_MAX_RECOVERY_S 3600.f
+
+// Well past anything a boiler does, and small enough that TemperatureKalmanFilter's covariances, which take the
+// noises squared and the rate noise in hundredths, stay within Q16.16
+#define TEMPERATURE_FILTER_MAX_HEATER_RATE_C_PER_S 5.f
+#define TEMPERATURE_FILTER_MAX_HEATER_LAG_S 600.f
+#define TEMPERATURE_FILTER_MAX_RATE_NOISE 0.5f
+#define TEMPERATURE_FILTER_MAX_MEASUREMENT_NOISE_C 5.f
+
+// How far the suggested Kp or Ki has to be from the current one before it's taken over, relative
+#define ADAPTIVE_PID_DRIFT 0.25f
+// Every change ends up in flash, so don't follow the model more often than this
+#define ADAPTIVE_PID_INTERVAL_MS (30 * 60 * 1000)
+
+SettingsManager::SettingsManager(SeqlockMailbox<SettingStruct> *settingsMailbox, SettingsFlash* settingsFlash): settingsMailbox(settingsMailbox), settingsFlash(settingsFlash) {
 
 }
 
-void SettingsManager::sendMessage(SystemControllerCommand command) {
-    commandQueue->tryAdd(&command);
+void SettingsManager::publishSettings() {
+    settingsMailbox->publish(currentSettings);
 }
 
 void SettingsManager::setBrewTemperatureOffset(float offset)
 {
     currentSettings.brewTemperatureOffset = offset;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_BREW_OFFSET,
-            .float1 = offset,
-    });
+    publishSettings();
 }
 
 void SettingsManager::setEcoMode(bool ecoMode)
 {
     currentSettings.ecoMode = ecoMode;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_ECO_MODE,
-            .bool1 = ecoMode,
-    });
+    publishSettings();
 }
 
 void SettingsManager::setTargetBrewTemp(float targetBrewTemp)
 {
     currentSettings.brewTemperatureTarget = targetBrewTemp;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_BREW_SET_POINT,
-            .float1 = targetBrewTemp,
-    });
+    publishSettings();
 }
 
 void SettingsManager::setAutoSleepMin(uint16_t minutes)
 {
     currentSettings.autoSleepMin = minutes;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_AUTO_SLEEP_MINUTES,
-            .float1 = static_cast<float>(minutes),
-    });
+    publishSettings();
 }
 
 void SettingsManager::setOffsetTargetBrewTemp(float offsetTargetBrewTemp) {
@@ -79,45 +98,238 @@ void SettingsManager::setOffsetTargetBrewTemp(float offsetTargetBrewTemp) {
 void SettingsManager::setTargetServiceTemp(float targetServiceTemp)
 {
     currentSettings.serviceTemperatureTarget = targetServiceTemp;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_SERVICE_SET_POINT,
-            .float1 = targetServiceTemp,
-    });
+    publishSettings();
+}
+
+// fmaxf and fminf take the other argument over a NaN, so this always comes up with something in 0-max
+static float clampSeconds(float seconds, float max) {
+    return fminf(fmaxf(seconds, 0.f), max);
+}
+
+static bool isWithin(float value, float min, float max) {
+    return std::isfinite(value) && value >= min && value <= max;
+}
+
+static bool areValidGains(float Kp, float Ki, float Kd, float windupLow, float windupHigh) {
+    return isWithin(Kp, 0.f, INFINITY) && isWithin(Ki, 0.f, INFINITY) && isWithin(Kd, 0.f, INFINITY) &&
+           std::isfinite(windupLow) && std::isfinite(windupHigh) && windupLow <= windupHigh;
 }
 
-void SettingsManager::setBrewPidParameters(PidSettings params)
+static bool isValid(const PidGains &gains) {
+    return areValidGains(gains.Kp, gains.Ki, gains.Kd, gains.windupLow, gains.windupHigh);
+}
+
+static bool isValid(const PidSettings &params) {
+    return areValidGains(params.Kp, params.Ki, params.Kd, params.windupLow, params.windupHigh) &&
+           isWithin(params.setPointWeight, 0.f, 1.f) &&
+           isWithin(params.derivativeFilterS, 0.f, INFINITY) &&
+           isWithin(params.setPointRampCPerS, 0.f, INFINITY);
+}
+
+static bool isValid(const BrewFeedForwardSettings &feedForward) {
+    return isWithin(feedForward.gain, 0.f, INFINITY) &&
+           isWithin(feedForward.pumpFlowGramsPerS, 0.f, INFINITY) &&
+           isWithin(feedForward.lineFlowGramsPerS, 0.f, INFINITY) &&
+           isWithin(feedForward.tankTemperatureC, 0.f, 100.f) &&
+           isWithin(feedForward.heatExchangerEffectiveness, 0.f, 1.f) &&
+           isWithin(feedForward.leadGain, 0.f, INFINITY) &&
+           isWithin(feedForward.leadTimeS, 0.f, INFINITY);
+}
+
+static bool isValid(const SmithPredictorSettings &smithPredictor) {
+    return isWithin(smithPredictor.gainC, 0.f, INFINITY) &&
+           isWithin(smithPredictor.timeConstantS, 0.f, INFINITY) &&
+           isWithin(smithPredictor.deadTimeS, 0.f, SMITH_PREDICTOR_MAX_DEAD_TIME_S);
+}
+
+static bool isValid(const TemperatureFilterSettings &filter) {
+    return isWithin(filter.heaterRateCPerS, 0.f, TEMPERATURE_FILTER_MAX_HEATER_RATE_C_PER_S) &&
+           isWithin(filter.heaterLagS, 0.f, TEMPERATURE_FILTER_MAX_HEATER_LAG_S) &&
+           isWithin(filter.rateNoise, 0.f, TEMPERATURE_FILTER_MAX_RATE_NOISE) &&
+           isWithin(filter.measurementNoiseC, 0.f, TEMPERATURE_FILTER_MAX_MEASUREMENT_NOISE_C);
+}
+
+bool SettingsManager::setBrewPidParameters(PidSettings params)
 {
+    if (!isValid(params)) {
+        return false;
+    }
+
     currentSettings.brewPidParameters = params;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_BREW_PID_PARAMETERS,
-            .float1 = params.Kp,
-            .float2 = params.Ki,
-            .float3 = params.Kd,
-            .float4 = params.windupLow,
-            .float5 = params.windupHigh,
-    });
+    publishSettings();
+    return true;
 }
 
-void SettingsManager::setServicePidParameters(PidSettings params)
+bool SettingsManager::setServicePidParameters(PidSettings params)
 {
+    if (!isValid(params)) {
+        return false;
+    }
+
     currentSettings.servicePidParameters = params;
-    sendMessage(SystemControllerCommand{
-            .type = COMMAND_SET_SERVICE_PID_PARAMETERS,
-            .float1 = params.Kp,
-            .float2 = params.Ki,
-            .float3 = params.Kd,
-            .float4 = params.windupLow,
-            .float5 = params.windupHigh,
-    });
+    publishSettings();
+    return true;
+}
+
+void SettingsManager::setAdaptivePid(bool adaptivePid)
+{
+    currentSettings.adaptivePid = adaptivePid;
+    publishSettings();
+}
+
+bool SettingsManager::setBrewFeedForward(BrewFeedForwardSettings brewFeedForward)
+{
+    if (!isValid(brewFeedForward)) {
+        return false;
+    }
+
+    currentSettings.brewFeedForward = brewFeedForward;
+    publishSettings();
+    return true;
+}
+
+bool SettingsManager::setBrewSmithPredictor(SmithPredictorSettings brewSmithPredictor)
+{
+    if (!isValid(brewSmithPredictor)) {
+        return false;
+    }
+
+    currentSettings.brewSmithPredictor = brewSmithPredictor;
+    publishSettings();
+    return true;
+}
+
+void SettingsManager::setBrewPidSchedule(PidScheduleSettings brewPidSchedule)
+{
+    brewPidSchedule.transitionS = clampSeconds(brewPidSchedule.transitionS, PID_SCHEDULE_MAX_TRANSITION_S);
+    brewPidSchedule.recoveryS = clampSeconds(brewPidSchedule.recoveryS, PID_SCHEDULE_MAX_RECOVERY_S);
+
+    currentSettings.brewPidSchedule = brewPidSchedule;
+    publishSettings();
+}
+
+bool SettingsManager::setBrewTemperatureFilter(TemperatureFilterSettings brewTemperatureFilter)
+{
+    if (!isValid(brewTemperatureFilter)) {
+        return false;
+    }
+
+    currentSettings.brewTemperatureFilter = brewTemperatureFilter;
+    publishSettings();
+    return true;
+}
+
+void SettingsManager::setGroupHeadCascade(GroupHeadCascadeSettings groupHeadCascade)
+{
+    currentSettings.groupHeadCascade = groupHeadCascade;
+    publishSettings();
+}
+
+bool SettingsManager::setBrewPidScheduleGains(PidRegime regime, PidGains gains)
+{
+    if (!isValid(gains)) {
+        return false;
+    }
+
+    switch (regime) {
+        case PID_REGIME_IDLE:
+            currentSettings.brewPidParameters.Kp = gains.Kp;
+            currentSettings.brewPidParameters.Ki = gains.Ki;
+            currentSettings.brewPidParameters.Kd = gains.Kd;
+            currentSettings.brewPidParameters.windupLow = gains.windupLow;
+            currentSettings.brewPidParameters.windupHigh = gains.windupHigh;
+            break;
+        case PID_REGIME_BREWING:
+            currentSettings.brewPidSchedule.brewing = gains;
+            break;
+        case PID_REGIME_RECOVERY:
+            currentSettings.brewPidSchedule.recovery = gains;
+            break;
+        case PID_REGIME_SLEEP:
+            currentSettings.brewPidSchedule.sleep = gains;
+            break;
+        case PID_REGIME_COUNT:
+            return false;
+    }
+
+    publishSettings();
+    return true;
 }
 
 void SettingsManager::setSleepMode(bool sleepMode)
 {
     currentSettings.sleepMode = sleepMode;
-    sendMessage(SystemControllerCommand{
-        .type = COMMAND_SET_SLEEP_MODE,
-        .bool1 = sleepMode
-    });
+    publishSettings();
+}
+
+// Auto-tune and the plant models only come up with gains and windup limits, the rest is the user's
+static PidSettings withGainsOf(PidSettings settings, const PidSettings &gains) {
+    settings.Kp = gains.Kp;
+    settings.Ki = gains.Ki;
+    settings.Kd = gains.Kd;
+    settings.windupLow = gains.windupLow;
+    settings.windupHigh = gains.windupHigh;
+
+    return settings;
+}
+
+void SettingsManager::applyAutoTuneResult(const AutoTuneStatus &autoTune) {
+    if (autoTune.state != AUTOTUNE_STATE_DONE || autoTune.runId == appliedAutoTuneRunId) {
+        return;
+    }
+
+    appliedAutoTuneRunId = autoTune.runId;
+
+    USB_PRINTF("Applying auto-tune result for boiler %u: Kp %.3f Ki %.4f Kd %.2f windup %.1f\n",
+               autoTune.boiler, autoTune.result.Kp, autoTune.result.Ki, autoTune.result.Kd, autoTune.result.windupHigh);
+
+    switch (autoTune.boiler) {
+        case AUTOTUNE_BOILER_BREW:
+            setBrewPidParameters(withGainsOf(currentSettings.brewPidParameters, autoTune.result));
+            break;
+        case AUTOTUNE_BOILER_SERVICE:
+            setServicePidParameters(withGainsOf(currentSettings.servicePidParameters, autoTune.result));
+            break;
+    }
+}
+
+static bool hasDrifted(float current, float suggested) {
+    if (current <= 0.f) {
+        return true;
+    }
+
+    return fabsf(suggested - current) / current > ADAPTIVE_PID_DRIFT;
+}
+
+static bool shouldAdapt(const PidSettings &current, const PlantModelEstimate &model) {
+    return model.valid && (hasDrifted(current.Kp, model.suggestedPid.Kp) || hasDrifted(current.Ki, model.suggestedPid.Ki));
+}
+
+void SettingsManager::adaptPidParameters(const SystemControllerStatusMessage &status) {
+    // Heat up and auto-tune don't run the PID settings, and the latter brings its own
+    if (!currentSettings.adaptivePid || status.runState != RUN_STATE_NORMAL || !time_reached(nextPidAdaptationAt)) {
+        return;
+    }
+
+    bool adapted = false;
+
+    if (shouldAdapt(currentSettings.brewPidParameters, status.brewPlantModel)) {
+        USB_PRINTF("Brew boiler model drifted, K %.1f tau %.0f dead time %.1f\n",
+                   status.brewPlantModel.gainC, status.brewPlantModel.timeConstantS, status.brewPlantModel.deadTimeS);
+        setBrewPidParameters(withGainsOf(currentSettings.brewPidParameters, status.brewPlantModel.suggestedPid));
+        adapted = true;
+    }
+
+    if (shouldAdapt(currentSettings.servicePidParameters, status.servicePlantModel)) {
+        USB_PRINTF("Service boiler model drifted, K %.1f tau %.0f dead time %.1f\n",
+                   status.servicePlantModel.gainC, status.servicePlantModel.timeConstantS, status.servicePlantModel.deadTimeS);
+        setServicePidParameters(withGainsOf(currentSettings.servicePidParameters, status.servicePlantModel.suggestedPid));
+        adapted = true;
+    }
+
+    if (adapted) {
+        nextPidAdaptationAt = make_timeout_time_ms(ADAPTIVE_PID_INTERVAL_MS);
+    }
 }
 
 void SettingsManager::initialize() {
@@ -128,17 +340,49 @@ void SettingsManager::initialize() {
         currentSettings.sleepMode = false;
     }
 
-    sendAllSettings();
+    publishSettings();
+}
+
+static bool hasValidCrc(const SettingsHeader &header, const uint8_t *payload) {
+    crc32_t crc;
+    crc32(payload, header.len, &crc);
+
+    return crc == header.crc;
+}
+
+static PidSettings migratePidSettings(const PidSettingsV1 &v1, PidSettings settings) {
+    settings.Kp = v1.Kp;
+    settings.Ki = v1.Ki;
+    settings.Kd = v1.Kd;
+    settings.windupLow = v1.windupLow;
+    settings.windupHigh = v1.windupHigh;
+
+    return settings;
+}
+
+// Everything that came after version 1 starts out at its default
+static SettingStruct migrateSettings(const SettingStructV1 &v1) {
+    SettingStruct settings{};
+    settings.brewTemperatureOffset = v1.brewTemperatureOffset;
+    settings.sleepMode = v1.sleepMode;
+    settings.ecoMode = v1.ecoMode;
+    settings.brewTemperatureTarget = v1.brewTemperatureTarget;
+    settings.serviceTemperatureTarget = v1.serviceTemperatureTarget;
+    settings.autoSleepMin = v1.autoSleepMin;
+    settings.brewPidParameters = migratePidSettings(v1.brewPidParameters, settings.brewPidParameters);
+    settings.servicePidParameters = migratePidSettings(v1.servicePidParameters, settings.servicePidParameters);
+
+    return settings;
 }
 
 void SettingsManager::readSettings() {
     static_assert(sizeof(SettingsHeader) + sizeof(SettingStruct) <= SETTINGS_FLASH_PAGE_SIZE);
 
+    // The defaults are SettingStruct's own, see types.h
     currentSettings = SettingStruct{};
 
     if (!settingsFlash->is_present()) {
         USB_PRINTF("Settings flash is not present\n");
-        memcpy(&currentSettings, &defaultSettings, sizeof(SettingStruct));
         return;
     } else {
         uint16_t dev = settingsFlash->get_device_id();
@@ -159,29 +403,32 @@ void SettingsManager::readSettings() {
     USB_PRINTF("\n");
 
     SettingsHeader header{};
-    SettingStruct read{};
     memcpy(&header, page, sizeof(SettingsHeader));
-    memcpy(&read, page + sizeof(SettingsHeader), sizeof(SettingStruct));
+    const uint8_t *payload = page + sizeof(SettingsHeader);
 
-    if (header.version == SETTINGS_CURRENT_VERSION && header.len == sizeof(SettingStruct)) {
-        crc32_t readCrc;
-        crc32(&read, sizeof(SettingStruct), &readCrc);
+    if (header.version == SETTINGS_CURRENT_VERSION && header.len == sizeof(SettingStruct) && hasValidCrc(header, payload)) {
+        USB_PRINTF("Using read settings\n");
 
-        if (readCrc == header.crc) {
-            USB_PRINTF("Using read settings\n");
+        memcpy(&lastReadSettings, payload, sizeof(SettingStruct));
+        memcpy(&currentSettings, payload, sizeof(SettingStruct));
+        return;
+    }
+
+    if (header.version == SETTINGS_V1_VERSION && header.len == sizeof(SettingStructV1) && hasValidCrc(header, payload)) {
+        USB_PRINTF("Migrating version 1 settings\n");
 
-            memcpy(&lastReadSettings, &read, sizeof(SettingStruct));
-            memcpy(&currentSettings, &read, sizeof(SettingStruct));
-            return;
-        }
+        SettingStructV1 read{};
+        memcpy(&read, payload, sizeof(SettingStructV1));
+        // Differs from lastReadSettings, so the next writeSettingsIfChanged() writes it in the current version
+        currentSettings = migrateSettings(read);
+        return;
     }
 
     USB_PRINTF("Using default settings\n");
-    memcpy(&currentSettings, &defaultSettings, sizeof(SettingStruct));
 }
 
 void SettingsManager::writeSettingsIfChanged() {
-    if (memcmp(&currentSettings, &lastReadSettings, sizeof(SettingStruct)) != 0) {
+    if (!(currentSettings == lastReadSettings)) {
         writeToFlash();
     }
 }
@@ -210,14 +457,3 @@ void SettingsManager::writeToFlash() {
 
     readSettings();
 }
-
-void SettingsManager::sendAllSettings() {
-    setBrewTemperatureOffset(currentSettings.brewTemperatureOffset);
-    setEcoMode(currentSettings.ecoMode);
-    setTargetBrewTemp(currentSettings.brewTemperatureTarget);
-    setAutoSleepMin(currentSettings.autoSleepMin);
-    setTargetServiceTemp(currentSettings.serviceTemperatureTarget);
-    setBrewPidParameters(currentSettings.brewPidParameters);
-    setServicePidParameters(currentSettings.servicePidParameters);
-    setSleepMode(currentSettings.sleepMode);
-}
@@ -6,12 +6,12 @@
 #define SMART_LCC_SETTINGSMANAGER_H
 
 #include "types.h"
-#include "utils/PicoQueue.h"
+#include "utils/SeqlockMailbox.h"
 #include "SettingsFlash.h"
 
 class SettingsManager {
 public:
-    explicit SettingsManager(PicoQueue<SystemControllerCommand> *commandQueue, SettingsFlash* settingsFlash);
+    explicit SettingsManager(SeqlockMailbox<SettingStruct> *settingsMailbox, SettingsFlash* settingsFlash);
 
     void initialize();
 
@@ -21,9 +21,25 @@ public:
     void setAutoSleepMin(uint16_t minutes);
     void setOffsetTargetBrewTemp(float offsetTargetBrewTemp);
     void setTargetServiceTemp(float targetServiceTemp);
-    void setBrewPidParameters(PidSettings params);
-    void setServicePidParameters(PidSettings params);
+    // These refuse settings the controllers can't work with, and return whether they took them
+    bool setBrewPidParameters(PidSettings params);
+    bool setServicePidParameters(PidSettings params);
     void setSleepMode(bool sleepMode);
+    void setAdaptivePid(bool adaptivePid);
+    bool setBrewFeedForward(BrewFeedForwardSettings brewFeedForward);
+    bool setBrewSmithPredictor(SmithPredictorSettings brewSmithPredictor);
+    void setBrewPidSchedule(PidScheduleSettings brewPidSchedule);
+    // Idle is the brew PID parameters themselves
+    bool setBrewPidScheduleGains(PidRegime regime, PidGains gains);
+    bool setBrewTemperatureFilter(TemperatureFilterSettings brewTemperatureFilter);
+    void setGroupHeadCascade(GroupHeadCascadeSettings groupHeadCascade);
+
+    // Takes over the PID settings from a finished auto-tune run, once per run
+    void applyAutoTuneResult(const AutoTuneStatus &autoTune);
+
+    // If enabled, takes over the PID settings suggested by a plant model once it has drifted far enough from the
+    // current ones
+    void adaptPidParameters(const SystemControllerStatusMessage &status);
 
     inline float getBrewTemperatureOffset() const { return currentSettings.brewTemperatureOffset; };
     inline bool getEcoMode() const { return currentSettings.ecoMode; };
@@ -34,10 +50,16 @@ public:
     inline float getTargetServiceTemp() const { return currentSettings.serviceTemperatureTarget; };
     inline PidSettings getBrewPidParameters() const { return currentSettings.brewPidParameters; };
     inline PidSettings getServicePidParameters() const { return currentSettings.servicePidParameters; };
+    inline bool getAdaptivePid() const { return currentSettings.adaptivePid; };
+    inline BrewFeedForwardSettings getBrewFeedForward() const { return currentSettings.brewFeedForward; };
+    inline SmithPredictorSettings getBrewSmithPredictor() const { return currentSettings.brewSmithPredictor; };
+    inline PidScheduleSettings getBrewPidSchedule() const { return currentSettings.brewPidSchedule; };
+    inline TemperatureFilterSettings getBrewTemperatureFilter() const { return currentSettings.brewTemperatureFilter; };
+    inline GroupHeadCascadeSettings getGroupHeadCascade() const { return currentSettings.groupHeadCascade; };
 
     void writeSettingsIfChanged();
 private:
-    PicoQueue<SystemControllerCommand> *commandQueue;
+    SeqlockMailbox<SettingStruct> *settingsMailbox;
     SettingsFlash* settingsFlash;
 
     SettingStruct lastReadSettings{
@@ -45,11 +67,14 @@ private:
     };
     SettingStruct currentSettings;
 
+    uint16_t appliedAutoTuneRunId = 0;
+    absolute_time_t nextPidAdaptationAt = nil_time;
+
     void readSettings();
     void writeToFlash();
-    void sendAllSettings();
 
-    inline void sendMessage(SystemControllerCommand command);
+    // Hands Core 0 a complete copy of the current settings. It picks up the latest one at the start of its next cycle.
+    void publishSettings();
 };
 
 #endif //SMART_LCC_SETTINGSMANAGER_H
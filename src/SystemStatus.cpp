@@ -8,7 +8,9 @@ SystemStatus::SystemStatus() {
 
 }
 
-void SystemStatus::updateStatusMessage(SystemControllerStatusMessage message) {
+void SystemStatus::updateStatusMessage(SystemControllerStatusMessage message, uint32_t missed) {
+    missedStatusMessages += missed;
+
     if (!latestStatusMessage.currentlyBrewing && message.currentlyBrewing) {
         lastBrewStartedAt = get_absolute_time();
         lastBrewEndedAt.reset();
@@ -62,7 +62,10 @@ public:
 
     bool mqttConnected = false;
 
-    void updateStatusMessage(SystemControllerStatusMessage message);
+    // Status messages Core 0 published that were overwritten before Core 1 got to them
+    uint32_t missedStatusMessages = 0;
+
+    void updateStatusMessage(SystemControllerStatusMessage message, uint32_t missed = 0);
     inline void updateEspStatusMessage(ESPESPStatusMessage message) { espStatusMessage = message; };
 private:
     SystemControllerStatusMessage latestStatusMessage;
@@ -7,7 +7,7 @@
 
 #include <cstdint>
 
-#define ESP_RP2040_PROTOCOL_VERSION 0x0005
+#define ESP_RP2040_PROTOCOL_VERSION 0x0010
 
 enum ESPMessageType: uint32_t {
     ESP_MESSAGE_PING = 0x00000001, // ESP -> RP2040
@@ -20,6 +20,8 @@ enum ESPMessageType: uint32_t {
     ESP_MESSAGE_POLL_STATUS, // ESP -> RP2040
     ESP_MESSAGE_ADD_COMMAND_TO_ROUTINE_STEP, // ESP -> RP2040
     ESP_MESSAGE_ADD_EXIT_CONDITION_TO_ROUTINE_STEP, // ESP -> RP2040
+    ESP_MESSAGE_CYCLE_TIMING, // RP2040 -> ESP
+    ESP_MESSAGE_PLANT_MODEL, // RP2040 -> ESP
 };
 
 enum ESPDirection: uint32_t {
@@ -37,6 +39,8 @@ enum ESPError: uint32_t {
     ESP_ERROR_UNEXPECTED_MESSAGE_LENGTH,
     ESP_ERROR_PING_WRONG_VERSION = 0x05,
     ESP_ERROR_VALVE_CLOSED,
+    ESP_ERROR_COMMAND_QUEUE_FULL,
+    ESP_ERROR_INVALID_SETTING,
     ESP_WARNING_BAILED_CB_UNRESPONSIVE = 0x100,
 };
 
@@ -78,6 +82,7 @@ enum ESPSystemRunState: uint8_t {
     ESP_SYSTEM_RUN_STATE_HEATUP_STAGE_1,
     ESP_SYSTEM_RUN_STATE_HEATUP_STAGE_2,
     ESP_SYSTEM_RUN_STATE_FIRST_RUN,
+    ESP_SYSTEM_RUN_STATE_AUTOTUNE,
 };
 
 enum ESPSystemCoalescedState: uint8_t {
@@ -87,7 +92,46 @@ enum ESPSystemCoalescedState: uint8_t {
     ESP_SYSTEM_COALESCED_STATE_WARM,
     ESP_SYSTEM_COALESCED_STATE_SLEEPING,
     ESP_SYSTEM_COALESCED_STATE_BAILED,
-    ESP_SYSTEM_COALESCED_STATE_FIRST_RUN
+    ESP_SYSTEM_COALESCED_STATE_FIRST_RUN,
+    ESP_SYSTEM_COALESCED_STATE_AUTOTUNING,
+};
+
+enum ESPAutoTuneBoiler: uint8_t {
+    ESP_AUTOTUNE_BOILER_BREW = 0,
+    ESP_AUTOTUNE_BOILER_SERVICE,
+};
+
+enum ESPPidRegime: uint8_t {
+    ESP_PID_REGIME_IDLE = 0,
+    ESP_PID_REGIME_BREWING,
+    ESP_PID_REGIME_RECOVERY,
+    ESP_PID_REGIME_SLEEP,
+};
+
+enum ESPGroupHeadControlMode: uint8_t {
+    ESP_GROUP_HEAD_CONTROL_NONE = 0,
+    ESP_GROUP_HEAD_CONTROL_OBSERVER,
+    ESP_GROUP_HEAD_CONTROL_CASCADE,
+};
+
+enum ESPAutoTuneState: uint8_t {
+    ESP_AUTOTUNE_STATE_IDLE = 0,
+    ESP_AUTOTUNE_STATE_APPROACHING,
+    ESP_AUTOTUNE_STATE_OSCILLATING,
+    ESP_AUTOTUNE_STATE_DONE,
+    ESP_AUTOTUNE_STATE_ABORTED,
+};
+
+enum ESPAutoTuneAbortReason: uint8_t {
+    ESP_AUTOTUNE_ABORT_NONE = 0,
+    ESP_AUTOTUNE_ABORT_NOT_READY,
+    ESP_AUTOTUNE_ABORT_CANCELLED,
+    ESP_AUTOTUNE_ABORT_BAILED,
+    ESP_AUTOTUNE_ABORT_BREW_STARTED,
+    ESP_AUTOTUNE_ABORT_SLEEP_MODE,
+    ESP_AUTOTUNE_ABORT_ECO_MODE,
+    ESP_AUTOTUNE_ABORT_TIMEOUT,
+    ESP_AUTOTUNE_ABORT_NO_OSCILLATION,
 };
 
 struct __attribute__((packed)) ESPSystemStatusMessage {
@@ -119,12 +163,86 @@ struct __attribute__((packed)) ESPSystemStatusMessage {
     bool serviceBoilerOn;
     uint16_t loadedRoutine;
     uint16_t currentRoutineStep;
+    // Progress of the latest relay auto-tune run. The resulting PID settings have already been saved when it's done.
+    ESPAutoTuneState autoTuneState;
+    ESPAutoTuneBoiler autoTuneBoiler;
+    ESPAutoTuneAbortReason autoTuneAbortReason;
+    uint8_t autoTuneCyclesCompleted;
+    uint8_t autoTuneCyclesRequired;
+    float autoTuneUltimateGain;
+    float autoTuneUltimatePeriodSeconds;
+    float autoTuneKp;
+    float autoTuneKi;
+    float autoTuneKd;
+    float autoTuneWindupLow;
+    float autoTuneWindupHigh;
+    // °C/s, from the brew temperature filter whether or not the controller uses its temperature
+    float brewBoilerTemperatureRate;
+    // Water at the group from the group head observer, comparable to brewBoilerTemperature
+    float groupHeadTemperature;
+    bool groupHeadThermocoupleConnected;
+    // Whether observer control is on, not whether it's what moves the set point, see groupHeadControlMode
+    bool groupHeadControl;
+    ESPGroupHeadControlMode groupHeadControlMode;
+    // Already in brewBoilerSetPoint
+    float brewBoilerSetPointCorrection;
     /*
      * To add:
      * Pid settings and pid parameters
      */
 };
 
+#define ESP_CYCLE_TIMING_HISTOGRAM_BUCKETS 16
+#define ESP_PIPELINE_STAGES 6
+
+/*
+ * Control cycle timing. Histogram bucket 0 counts 0 µs, bucket n counts [2^(n-1), 2^n) µs and the last bucket
+ * everything above that.
+ *
+ * Pipeline stages are ingest, decode, estimate, control, arbitrate and emit, in that order.
+ */
+struct __attribute__((packed)) ESPCycleTimingMessage {
+    uint32_t cycles;
+    uint32_t overruns;
+    uint32_t skippedCycles;
+    uint32_t lastTxDelayUs;
+    uint32_t lastRxUs;
+    uint32_t lastControlUs;
+    uint32_t lastBusyUs;
+    uint32_t jitterHistogram[ESP_CYCLE_TIMING_HISTOGRAM_BUCKETS];
+    uint32_t overrunHistogram[ESP_CYCLE_TIMING_HISTOGRAM_BUCKETS];
+    uint32_t stageLastUs[ESP_PIPELINE_STAGES];
+    uint32_t stageMaxUs[ESP_PIPELINE_STAGES];
+    uint32_t stageBudgetUs[ESP_PIPELINE_STAGES];
+    uint32_t stageOverruns[ESP_PIPELINE_STAGES];
+};
+
+/*
+ * First-order-plus-dead-time model of a boiler as identified online, and the PID settings that would go with it.
+ * Gain is how far above ambient the boiler would end up at full power.
+ */
+struct __attribute__((packed)) ESPPlantModel {
+    bool valid;
+    uint32_t samples;
+    float gain;
+    float timeConstantSeconds;
+    float deadTimeSeconds;
+    float holdingDuty;
+    float predictionError;
+    float suggestedKp;
+    float suggestedKi;
+    float suggestedKd;
+    float suggestedWindupLow;
+    float suggestedWindupHigh;
+};
+
+struct __attribute__((packed)) ESPPlantModelMessage {
+    ESPPlantModel brewBoiler;
+    ESPPlantModel serviceBoiler;
+    // Whether the suggested PID settings are taken over when they drift from the current ones
+    bool adaptivePid;
+};
+
 enum ESPSystemCommandType: uint32_t {
     ESP_SYSTEM_COMMAND_SET_BREW_SET_POINT,
     ESP_SYSTEM_COMMAND_SET_BREW_PID_PARAMETERS,
@@ -139,6 +257,31 @@ enum ESPSystemCommandType: uint32_t {
     ESP_SYSTEM_COMMAND_CANCEL_ROUTINE,
     ESP_SYSTEM_COMMAND_FORCE_HARD_BAIL,
     ESP_SYSTEM_COMMAND_CLEAR_ROUTINE,
+    ESP_SYSTEM_COMMAND_START_AUTOTUNE, // int1 is the ESPAutoTuneBoiler
+    ESP_SYSTEM_COMMAND_CANCEL_AUTOTUNE,
+    ESP_SYSTEM_COMMAND_SET_ADAPTIVE_PID,
+    // float1 gain, float2 pump flow (g/s), float3 line pressure flow (g/s), float4 tank temperature, float5 heat
+    // exchanger effectiveness (0-1)
+    ESP_SYSTEM_COMMAND_SET_BREW_FEED_FORWARD,
+    // float1 lead gain, float2 lead time (s)
+    ESP_SYSTEM_COMMAND_SET_BREW_FEED_FORWARD_LEAD,
+    // bool1 enabled, float1 model gain (°C), float2 time constant (s), float3 dead time (s)
+    ESP_SYSTEM_COMMAND_SET_BREW_SMITH_PREDICTOR,
+    // float1 set point weight (0-1), float2 derivative filter time constant (s), float3 set point ramp (°C/s, 0 for
+    // none). The PID parameter commands leave these alone.
+    ESP_SYSTEM_COMMAND_SET_BREW_PID_SHAPING,
+    ESP_SYSTEM_COMMAND_SET_SERVICE_PID_SHAPING,
+    // bool1 enabled, float1 transition time (s), float2 recovery time after a brew (s)
+    ESP_SYSTEM_COMMAND_SET_BREW_PID_SCHEDULE,
+    // int1 is the ESPPidRegime, float1-5 as for the PID parameters. Idle sets the brew PID parameters.
+    ESP_SYSTEM_COMMAND_SET_BREW_PID_SCHEDULE_GAINS,
+    // bool1 enabled, float1 heater rate at full power (°C/s), float2 heater lag (s), float3 rate noise (°C/s per
+    // √s), float4 measurement noise (°C)
+    ESP_SYSTEM_COMMAND_SET_BREW_TEMPERATURE_FILTER,
+    // bool1 whether to correct the brew set point so the water at the group ends up at it. Not saved.
+    ESP_SYSTEM_COMMAND_SET_GROUP_HEAD_CONTROL,
+    // bool1 enabled, float1 group thermocouple target (°C), float2 Kp, float3 Ki. Takes over from observer control.
+    ESP_SYSTEM_COMMAND_SET_GROUP_HEAD_CASCADE,
 };
 
 struct __attribute__((packed)) ESPSystemCommandPayload {
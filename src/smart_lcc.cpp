@@ -4,7 +4,8 @@
 #include "hardware/i2c.h"
 #include <cstring>
 #include "Controller/Core0/SystemController.h"
-#include "utils/PicoQueue.h"
+#include "CommandChannel.h"
+#include "utils/SeqlockMailbox.h"
 #include "pico/multicore.h"
 #include "hardware/watchdog.h"
 #include "MulticoreSupport.h"
@@ -18,20 +19,23 @@
 #include "utils/USBDebug.h"
 #include "pins.h"
 #include "Controller/Core1/Automations.h"
+#include "Controller/Core1/GroupHeadController.h"
 
 repeating_timer_t safePacketBootupTimer;
 SystemController* systemController;
 SystemStatus* status;
 SettingsFlash* settingsFlash;
 SettingsManager* settingsManager;
-PicoQueue<SystemControllerStatusMessage>* statusQueue;
-PicoQueue<SystemControllerCommand>* commandQueue;
+SeqlockMailbox<SystemControllerStatusMessage>* statusMailbox;
+SeqlockMailbox<SettingStruct>* settingsMailbox;
+CommandChannel* commandChannel;
 MulticoreSupport support;
 EspFirmware *espFirmware;
 MCP9600* mcp9600_0x60;
 MCP9600* mcp9600_0x67;
 MCP9600* mcp9600_0x63;
 Automations* automations;
+GroupHeadController* groupHeadController;
 
 /* SDIO Interface */
 static sd_sdio_if_t sdio_if = {
@@ -201,29 +205,68 @@ int i2c_bus_scan(i2c_inst_t* i2c) {
 
         systemController->loop();
 
-        if (statusQueue->isFull())  {
+        // Core 1 acknowledges every status message it picks up. If it has fallen 100 messages (10 seconds) behind,
+        // it's stuck.
+        if (statusMailbox->getReaderLag() >= 100)  {
             if (!core1RebootTimer.has_value()) {
                 core1RebootTimer = make_timeout_time_ms(2000);
             }
+        } else if (statusMailbox->getReaderLag() < 10) {
+            core1RebootTimer.reset();
         }
     }
 }
 
+void printCycleTiming(const SystemControllerStatusMessage &sm) {
+    [[maybe_unused]] const CycleTimingStats &stats = sm.cycleTiming;
+
+    USB_PRINTF("Cycles: %lu, overruns: %lu, skipped: %lu. Last cycle: TX delay %lu us, RX %lu us, control %lu us, busy %lu us\n",
+               stats.cycles, stats.overruns, stats.skippedCycles,
+               stats.lastTxDelayUs, stats.lastRxUs, stats.lastControlUs, sm.cycleBusyUs);
+
+    USB_PRINTF("    >= us     jitter    overrun\n");
+    for (uint8_t i = 0; i < CYCLE_TIMING_HISTOGRAM_BUCKETS; i++) {
+        USB_PRINTF("%9lu %10lu %10lu\n",
+                   Log2Histogram<CYCLE_TIMING_HISTOGRAM_BUCKETS>::bucketFloor(i),
+                   stats.jitter.counts[i], stats.overrun.counts[i]);
+    }
+
+    [[maybe_unused]] static const char *stageNames[PIPELINE_STAGE_COUNT] = {"ingest", "decode", "estimate", "control", "arbitrate", "emit"};
+
+    USB_PRINTF("    stage    last us     max us  budget us   overruns\n");
+    for (uint8_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+        [[maybe_unused]] const PipelineStageStats &stage = sm.pipelineTiming.stages[i];
+        USB_PRINTF("%9s %10lu %10lu %10lu %10lu\n", stageNames[i], stage.lastUs, stage.maxUs, stage.budgetUs, stage.overruns);
+    }
+}
+
+void printPlantModel([[maybe_unused]] const char *boiler, [[maybe_unused]] const PlantModelEstimate &model) {
+    USB_PRINTF("%s boiler model: %s after %lu samples, K %.1f C, tau %.0f s, dead time %.1f s, duty %.3f, error %.3f C. "
+               "Suggested Kp %.3f Ki %.5f Kd %.2f\n",
+               boiler, model.valid ? "valid" : "not valid", model.samples, model.gainC, model.timeConstantS,
+               model.deadTimeS, model.holdingDuty, model.predictionErrorC,
+               model.suggestedPid.Kp, model.suggestedPid.Ki, model.suggestedPid.Kd);
+}
+
 [[noreturn]] void main1() {
     // Core 1 - ESP32 communication, saving things to SD-card, settings flash etc
 
     support.registerCore();
-    SystemControllerStatusMessage sm;
+    SystemControllerStatusMessage sm{};
+    uint32_t statusSequence = 0;
 
     SystemControllerCommand beginCommand;
     beginCommand.type = COMMAND_BEGIN;
-    commandQueue->tryAdd(&beginCommand);
+    commandChannel->tryPush(beginCommand);
 
     absolute_time_t nextSend = make_timeout_time_ms(2500);
+    absolute_time_t nextTimingSend = make_timeout_time_ms(5000);
+
+    automations = new Automations(settingsManager, commandChannel);
 
-    automations = new Automations(settingsManager, commandQueue);
+    groupHeadController = new GroupHeadController(commandChannel);
 
-    espFirmware = new EspFirmware(ESP_UART, commandQueue, status, settingsManager, automations);
+    espFirmware = new EspFirmware(ESP_UART, commandChannel, status, settingsManager, automations, groupHeadController);
     EspFirmware::initInterrupts(ESP_UART);
 
     i2c_bus_scan(i2c0);
@@ -277,6 +320,8 @@ int i2c_bus_scan(i2c_inst_t* i2c) {
     float externalTemp1 = 0.f;
     float externalTemp2 = 0.f;
     float externalTemp3 = 0.f;
+    // The thermocouple at 0x60 is the one on the group
+    nonstd::optional<float> groupThermocoupleC{};
 
     if (mcp9600_0x60->isConnected()) {
         printf("MCP9600 0x60 Connected\n");
@@ -297,11 +342,16 @@ int i2c_bus_scan(i2c_inst_t* i2c) {
     }
 
     while (true) {
-        while (!statusQueue->isEmpty()) {
-            statusQueue->removeBlocking(&sm);
+        uint32_t latestSequence;
+        if (statusMailbox->tryRead(&sm, &latestSequence) && latestSequence != statusSequence) {
+            status->updateStatusMessage(sm, statusSequence > 0 ? latestSequence - statusSequence - 1 : 0);
+            // Ends up in flash with the next writeSettingsIfChanged()
+            settingsManager->applyAutoTuneResult(sm.autoTune);
+            settingsManager->adaptPidParameters(sm);
+            groupHeadController->update(sm, groupThermocoupleC, settingsManager->getGroupHeadCascade());
+            statusMailbox->acknowledge(latestSequence);
+            statusSequence = latestSequence;
         }
-
-        status->updateStatusMessage(sm);
         espFirmware->loop();
         automations->loop(sm);
 
@@ -310,6 +360,9 @@ int i2c_bus_scan(i2c_inst_t* i2c) {
                 externalTemp1 = mcp9600_0x60->readTemperature(0x40);
             }
 
+            // Checked again, since the read finds out if it's gone
+            groupThermocoupleC = mcp9600_0x60->isConnected() ? nonstd::optional<float>(externalTemp1) : nonstd::nullopt;
+
             if (mcp9600_0x63->isConnected()) {
                 externalTemp2 = mcp9600_0x63->readTemperature(0x40);
             }
@@ -334,6 +387,17 @@ int i2c_bus_scan(i2c_inst_t* i2c) {
 
             settingsManager->writeSettingsIfChanged();
         }
+
+        if (time_reached(nextTimingSend)) {
+            espFirmware->sendCycleTiming(&sm);
+            printCycleTiming(sm);
+
+            espFirmware->sendPlantModel(&sm);
+            printPlantModel("brew", sm.brewPlantModel);
+            printPlantModel("service", sm.servicePlantModel);
+
+            nextTimingSend = make_timeout_time_ms(5000);
+        }
     }
 
 }
@@ -352,15 +416,16 @@ int main() {
 
     support.begin(2);
 
-    statusQueue = new PicoQueue<SystemControllerStatusMessage>(100);
-    commandQueue = new PicoQueue<SystemControllerCommand>(100);
+    statusMailbox = new SeqlockMailbox<SystemControllerStatusMessage>();
+    commandChannel = new CommandChannel();
+    settingsMailbox = new SeqlockMailbox<SettingStruct>();
 
     settingsFlash = new SettingsFlash(spi1, SETTINGS_FLASH_CS);
 
-    settingsManager = new SettingsManager(commandQueue, settingsFlash);
+    settingsManager = new SettingsManager(settingsMailbox, settingsFlash);
     settingsManager->initialize();
 
-    systemController = new SystemController(CB_UART, statusQueue, commandQueue);
+    systemController = new SystemController(CB_UART, statusMailbox, commandChannel, settingsMailbox);
     add_repeating_timer_ms(1000, repeating_timer_callback, nullptr, &safePacketBootupTimer);
 
     status = new SystemStatus();
@@ -6,6 +6,7 @@
 #define FIRMWARE_TYPES_H
 
 #include <pico/time.h>
+#include "utils/Log2Histogram.h"
 
 typedef enum {
     SYSTEM_MODE_UNDETERMINED,
@@ -30,6 +31,105 @@ struct PidSettings {
     float Kd{};
     float windupLow{};
     float windupHigh{};
+    // How much of a set point change the proportional term sees straight away, 0-1. The rest phases in over the
+    // integral time.
+    float setPointWeight = 1.f;
+    // Time constant of the filter on the derivative term, 0 for none
+    float derivativeFilterS{};
+    // How fast the set point the PID works towards may move, °C/s, 0 to step straight to it
+    float setPointRampCPerS{};
+};
+
+/*
+ * Brew boiler feed forward, see BrewFeedForward. Flows are of water drawn through the brew boiler.
+ */
+struct BrewFeedForwardSettings {
+    // 0 turns the feed forward off, 1 is the model as is
+    float gain{};
+    float pumpFlowGramsPerS{};
+    // With the pump off and the solenoid open, e.g. line pressure pre-infusion when plumbed in
+    float lineFlowGramsPerS{};
+    float tankTemperatureC{};
+    // Inlet water is pre-heated in the service boiler, this far from the tank temperature to the service boiler's, 0-1
+    float heatExchangerEffectiveness{};
+    // Extra at the start of a flow, relative, decaying over leadTimeS. The element has to heat up before the water does.
+    float leadGain{};
+    float leadTimeS{};
+};
+
+/*
+ * First-order-plus-dead-time model of a boiler for a Smith predictor, see SmithPredictor.
+ */
+struct SmithPredictorSettings {
+    bool enabled{};
+    // Where the temperature would end up above ambient at full heater power, °C
+    float gainC{};
+    float timeConstantS{};
+    // Up to SMITH_PREDICTOR_MAX_DEAD_TIME_S
+    float deadTimeS{};
+};
+
+// As far back as SmithPredictor's delay line reaches at the 100 ms control cycle
+#define SMITH_PREDICTOR_MAX_DEAD_TIME_S 25.5f
+
+// The part of PidSettings that changes with the operating regime, see PidScheduleSettings
+struct PidGains {
+    float Kp{};
+    float Ki{};
+    float Kd{};
+    float windupLow{};
+    float windupHigh{};
+};
+
+typedef enum {
+    PID_REGIME_IDLE = 0, // Holding the set point
+    PID_REGIME_BREWING,
+    PID_REGIME_RECOVERY, // For a while after a brew
+    PID_REGIME_SLEEP,
+    PID_REGIME_COUNT,
+} PidRegime;
+
+/*
+ * Brew boiler gain schedule, see PidGainScheduler. Idle runs on the brew PID settings as they are, so the PID commands,
+ * auto-tune and the adaptive PID keep working on those. The other regimes only swap out the gains and windup limits,
+ * which also keeps the table small enough for the settings flash page.
+ */
+struct PidScheduleSettings {
+    bool enabled{};
+    // How long it takes to blend from one regime's gains to the next
+    float transitionS{};
+    // How long after a brew ends the recovery regime lasts
+    float recoveryS{};
+    PidGains brewing{};
+    PidGains recovery{};
+    PidGains sleep{};
+};
+
+/*
+ * Boiler temperature filter, see TemperatureKalmanFilter. The heater model is a rate at full power through a first
+ * order lag, for the element heating up before the water does.
+ */
+struct TemperatureFilterSettings {
+    // Whether the controller runs on the filter rather than the moving average. The filter always runs.
+    bool enabled{};
+    float heaterRateCPerS{};
+    float heaterLagS{};
+    // How fast what's left of the rate (losses, water flowing through) can wander off, °C/s per √s
+    float rateNoise{};
+    // Sensor noise on top of the ADC resolution, °C
+    float measurementNoiseC{};
+};
+
+// Outer loop on Core 1 that moves the brew set point until the group thermocouple reads the target, see
+// GroupHeadController
+struct GroupHeadCascadeSettings {
+    bool enabled{};
+    // What the thermocouple should read, °C
+    float targetC{};
+    // °C of set point per °C of error
+    float Kp{};
+    // °C of set point per °C of error and second
+    float Ki{};
 };
 
 struct PidRuntimeParameters {
@@ -52,6 +152,7 @@ typedef enum {
     RUN_STATE_HEATUP_STAGE_1, // Bring the Brew boiler up to 130, don't run the service boiler
     RUN_STATE_HEATUP_STAGE_2, // Keep the Brew boiler at 130 for 4 minutes, run service boiler as normal
     RUN_STATE_NORMAL,
+    RUN_STATE_AUTOTUNE, // Relay auto-tune of one of the boilers, everything else runs as normal
 } SystemControllerRunState;
 
 typedef enum {
@@ -74,7 +175,8 @@ typedef enum {
     SYSTEM_CONTROLLER_COALESCED_STATE_WARM,
     SYSTEM_CONTROLLER_COALESCED_STATE_SLEEPING,
     SYSTEM_CONTROLLER_COALESCED_STATE_BAILED,
-    SYSTEM_CONTROLLER_COALESCED_STATE_FIRST_RUN
+    SYSTEM_CONTROLLER_COALESCED_STATE_FIRST_RUN,
+    SYSTEM_CONTROLLER_COALESCED_STATE_AUTOTUNING,
 } SystemControllerCoalescedState;
 
 struct SettingStruct {
@@ -84,17 +186,212 @@ struct SettingStruct {
     float brewTemperatureTarget = 105;
     float serviceTemperatureTarget = 120;
     uint16_t autoSleepMin = 0;
-    PidSettings brewPidParameters = PidSettings{.Kp = 0.8, .Ki = 0.12, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f};
-    PidSettings servicePidParameters = PidSettings{.Kp = 0.6, .Ki = 0.1, .Kd = 1.0, .windupLow = -10.f, .windupHigh = 10.f};
+    // The PID used to run once per 25 slot (2.5 s) block, and Kd is tuned for that. A 2 s derivative filter keeps a
+    // step of the sensor's resolution kicking it about as hard as it did then, rather than 25 times harder.
+    PidSettings brewPidParameters = PidSettings{.Kp = 0.8, .Ki = 0.12, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f,
+            .derivativeFilterS = 2.f};
+    PidSettings servicePidParameters = PidSettings{.Kp = 0.6, .Ki = 0.1, .Kd = 1.0, .windupLow = -10.f, .windupHigh = 10.f,
+            .derivativeFilterS = 2.f};
+    // Let the PID settings follow the identified plant models, see SettingsManager::adaptPidParameters
+    bool adaptivePid = false;
+    BrewFeedForwardSettings brewFeedForward = BrewFeedForwardSettings{
+            .gain = 1.f,
+            .pumpFlowGramsPerS = 2.f,
+            .lineFlowGramsPerS = 0.f,
+            .tankTemperatureC = 20.f,
+            .heatExchangerEffectiveness = 0.4f,
+            .leadGain = 1.f,
+            .leadTimeS = 5.f,
+    };
+    // Roughly what FopdtEstimator finds for a Bianca brew boiler
+    SmithPredictorSettings brewSmithPredictor = SmithPredictorSettings{
+            .enabled = false,
+            .gainC = 150.f,
+            .timeConstantS = 800.f,
+            .deadTimeS = 12.f,
+    };
+    PidScheduleSettings brewPidSchedule = PidScheduleSettings{
+            .enabled = false,
+            .transitionS = 5.f,
+            .recoveryS = 60.f,
+            .brewing = PidGains{.Kp = 0.8, .Ki = 0.12, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f},
+            // Half the integral action, so the boiler doesn't overshoot once the flow stops
+            .recovery = PidGains{.Kp = 0.8, .Ki = 0.06, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f},
+            .sleep = PidGains{.Kp = 0.8, .Ki = 0.12, .Kd = 12.0, .windupLow = -7.f, .windupHigh = 7.f},
+    };
+    // 1000 W into about 0.8 l of water and 1.5 kg of brass
+    TemperatureFilterSettings brewTemperatureFilter = TemperatureFilterSettings{
+            .enabled = false,
+            .heaterRateCPerS = 0.25f,
+            .heaterLagS = 12.f,
+            .rateNoise = 0.02f,
+            .measurementNoiseC = 0.03f,
+    };
+    // A loop around the brew boiler's, so a lot slower than it. Settling is down to the group itself, not the gains,
+    // so Kp is left at 1 and Kp / Ki at about the group's 310 s time constant, see the group-cascade sim scenario
+    GroupHeadCascadeSettings groupHeadCascade = GroupHeadCascadeSettings{
+            .enabled = false,
+            .targetC = 93.f,
+            .Kp = 1.f,
+            .Ki = 0.003f,
+    };
+};
+
+/*
+ * Settings compare field by field. The ones with a bool in them have padding, which memcmp would compare too, and
+ * that isn't necessarily the same for equal settings.
+ */
+inline bool operator==(const PidSettings &a, const PidSettings &b) {
+    return a.Kp == b.Kp && a.Ki == b.Ki && a.Kd == b.Kd && a.windupLow == b.windupLow && a.windupHigh == b.windupHigh &&
+           a.setPointWeight == b.setPointWeight && a.derivativeFilterS == b.derivativeFilterS &&
+           a.setPointRampCPerS == b.setPointRampCPerS;
+}
+
+inline bool operator==(const BrewFeedForwardSettings &a, const BrewFeedForwardSettings &b) {
+    return a.gain == b.gain && a.pumpFlowGramsPerS == b.pumpFlowGramsPerS && a.lineFlowGramsPerS == b.lineFlowGramsPerS &&
+           a.tankTemperatureC == b.tankTemperatureC && a.heatExchangerEffectiveness == b.heatExchangerEffectiveness &&
+           a.leadGain == b.leadGain && a.leadTimeS == b.leadTimeS;
+}
+
+inline bool operator==(const SmithPredictorSettings &a, const SmithPredictorSettings &b) {
+    return a.enabled == b.enabled && a.gainC == b.gainC && a.timeConstantS == b.timeConstantS && a.deadTimeS == b.deadTimeS;
+}
+
+inline bool operator==(const PidGains &a, const PidGains &b) {
+    return a.Kp == b.Kp && a.Ki == b.Ki && a.Kd == b.Kd && a.windupLow == b.windupLow && a.windupHigh == b.windupHigh;
+}
+
+inline bool operator==(const PidScheduleSettings &a, const PidScheduleSettings &b) {
+    return a.enabled == b.enabled && a.transitionS == b.transitionS && a.recoveryS == b.recoveryS &&
+           a.brewing == b.brewing && a.recovery == b.recovery && a.sleep == b.sleep;
+}
+
+inline bool operator==(const TemperatureFilterSettings &a, const TemperatureFilterSettings &b) {
+    return a.enabled == b.enabled && a.heaterRateCPerS == b.heaterRateCPerS && a.heaterLagS == b.heaterLagS &&
+           a.rateNoise == b.rateNoise && a.measurementNoiseC == b.measurementNoiseC;
+}
+
+inline bool operator==(const GroupHeadCascadeSettings &a, const GroupHeadCascadeSettings &b) {
+    return a.enabled == b.enabled && a.targetC == b.targetC && a.Kp == b.Kp && a.Ki == b.Ki;
+}
+
+inline bool operator==(const SettingStruct &a, const SettingStruct &b) {
+    return a.brewTemperatureOffset == b.brewTemperatureOffset && a.sleepMode == b.sleepMode && a.ecoMode == b.ecoMode &&
+           a.brewTemperatureTarget == b.brewTemperatureTarget && a.serviceTemperatureTarget == b.serviceTemperatureTarget &&
+           a.autoSleepMin == b.autoSleepMin && a.brewPidParameters == b.brewPidParameters &&
+           a.servicePidParameters == b.servicePidParameters && a.adaptivePid == b.adaptivePid &&
+           a.brewFeedForward == b.brewFeedForward && a.brewSmithPredictor == b.brewSmithPredictor &&
+           a.brewPidSchedule == b.brewPidSchedule && a.brewTemperatureFilter == b.brewTemperatureFilter &&
+           a.groupHeadCascade == b.groupHeadCascade;
+}
+
+typedef enum {
+    AUTOTUNE_BOILER_BREW = 0,
+    AUTOTUNE_BOILER_SERVICE = 1,
+} AutoTuneBoiler;
+
+typedef enum {
+    AUTOTUNE_STATE_IDLE = 0,
+    AUTOTUNE_STATE_APPROACHING, // Heating up to the set point, before the first relay switch
+    AUTOTUNE_STATE_OSCILLATING,
+    AUTOTUNE_STATE_DONE,
+    AUTOTUNE_STATE_ABORTED,
+} AutoTuneState;
+
+typedef enum {
+    AUTOTUNE_ABORT_NONE = 0,
+    AUTOTUNE_ABORT_NOT_READY, // Only starts from normal operation, awake, not brewing, and not on a disabled boiler
+    AUTOTUNE_ABORT_CANCELLED,
+    AUTOTUNE_ABORT_BAILED,
+    AUTOTUNE_ABORT_BREW_STARTED,
+    AUTOTUNE_ABORT_SLEEP_MODE,
+    AUTOTUNE_ABORT_ECO_MODE,
+    AUTOTUNE_ABORT_TIMEOUT,
+    AUTOTUNE_ABORT_NO_OSCILLATION, // The oscillation was too small to tell apart from the relay hysteresis
+} AutoTuneAbortReason;
+
+struct AutoTuneStatus {
+    AutoTuneState state{};
+    AutoTuneBoiler boiler{};
+    AutoTuneAbortReason abortReason{};
+    uint8_t cyclesCompleted{};
+    uint8_t cyclesRequired{};
+    // Bumped on every start, so Core 1 applies each result exactly once
+    uint16_t runId{};
+    float ultimateGain{};
+    float ultimatePeriodS{};
+    // Only valid once done
+    PidSettings result{};
+};
+
+// First-order-plus-dead-time model of a boiler, as identified online by FopdtEstimator
+struct PlantModelEstimate {
+    // Enough undisturbed samples, and a model that makes physical sense and takes some heat to hold the set point
+    bool valid{};
+    uint32_t samples{};
+    // Where the temperature would end up above ambient at full heater power, °C
+    float gainC{};
+    float timeConstantS{};
+    float deadTimeS{};
+    // Heater duty (0-1) it takes to hold the set point
+    float holdingDuty{};
+    // RMS one sample ahead prediction error, °C
+    float predictionErrorC{};
+    // Only valid if the model is
+    PidSettings suggestedPid{};
+};
+
+#define CYCLE_TIMING_HISTOGRAM_BUCKETS 16
+
+struct CycleTimingStats {
+    uint32_t cycles{};
+    uint32_t overruns{};
+    uint32_t skippedCycles{};
+    // Phases of the most recent cycle: scheduled start to LCC packet sent, sent to reply received, received to control done
+    uint32_t lastTxDelayUs{};
+    uint32_t lastRxUs{};
+    uint32_t lastControlUs{};
+    // How late cycles started, in µs
+    Log2Histogram<CYCLE_TIMING_HISTOGRAM_BUCKETS> jitter{};
+    // How far past the start of the next cycle the control computation finished, in µs
+    Log2Histogram<CYCLE_TIMING_HISTOGRAM_BUCKETS> overrun{};
+};
+
+// The Core 0 control cycle, in the order the stages run
+typedef enum {
+    PIPELINE_STAGE_INGEST = 0, // Commands and settings in, LCC packet out, control board reply in
+    PIPELINE_STAGE_DECODE, // Validate the reply, bail supervision, run state automations
+    PIPELINE_STAGE_ESTIMATE, // Filter temperatures and level switches
+    PIPELINE_STAGE_CONTROL, // Boiler controllers and brew/fill decisions
+    PIPELINE_STAGE_ARBITRATE, // Power sharing and SSR slot planning
+    PIPELINE_STAGE_EMIT, // Status message to Core 1
+    PIPELINE_STAGE_COUNT,
+} PipelineStage;
+
+struct PipelineStageStats {
+    uint32_t lastUs{};
+    uint32_t maxUs{};
+    uint32_t budgetUs{};
+    // Number of cycles where the stage took longer than its budget
+    uint32_t overruns{};
+};
+
+struct PipelineTimingStats {
+    PipelineStageStats stages[PIPELINE_STAGE_COUNT]{};
 };
 
 struct SystemControllerStatusMessage{
     absolute_time_t timestamp{};
+    // What the brew boiler controller runs on, the moving average or the filter
     float brewTemperature{};
     float offsetBrewTemperature{};
+    // From the filter, °C/s
+    float brewTemperatureRate{};
     float brewTemperatureOffset{};
     float brewSetPoint{};
     float offsetBrewSetPoint{};
+    // Already in brewSetPoint and offsetBrewSetPoint, see COMMAND_SET_BREW_SET_POINT_CORRECTION
+    float brewSetPointCorrection{};
     PidSettings brewPidSettings{};
     PidRuntimeParameters brewPidParameters{};
     float serviceTemperature{};
@@ -119,23 +416,34 @@ struct SystemControllerStatusMessage{
     uint16_t sbRawHi{};
     uint16_t sbRawLo{};
     FlowMode flowMode{};
+    // Time Core 0 spent working this cycle, i.e. excluding waiting for the control board and the end of cycle sleep
+    uint32_t cycleBusyUs{};
+    // Number of times the control board receiver had to drop bytes to find the next valid packet
+    uint32_t cbResyncCount{};
+    CycleTimingStats cycleTiming{};
+    // The emit stage is reported one cycle late, since it's still running when the message is built
+    PipelineTimingStats pipelineTiming{};
+    AutoTuneStatus autoTune{};
+    PlantModelEstimate brewPlantModel{};
+    PlantModelEstimate servicePlantModel{};
 };
 
+// Whatever Core 1 asks for, the brew set point correction stays within this
+#define BREW_SET_POINT_CORRECTION_LIMIT_C 5.f
+// And it has to keep asking, so it doesn't outlive a stuck Core 1
+#define BREW_SET_POINT_CORRECTION_TIMEOUT_MS 10000
+
+// Settings don't go through commands, Core 0 picks them up as a whole from the settings mailbox
 typedef enum {
-    COMMAND_SET_BREW_SET_POINT,
-    COMMAND_SET_OFFSET_BREW_SET_POINT,
-    COMMAND_SET_BREW_OFFSET,
-    COMMAND_SET_BREW_PID_PARAMETERS,
-    COMMAND_SET_SERVICE_SET_POINT,
-    COMMAND_SET_SERVICE_PID_PARAMETERS,
-    COMMAND_SET_ECO_MODE,
-    COMMAND_SET_SLEEP_MODE,
-    COMMAND_SET_AUTO_SLEEP_MINUTES,
     COMMAND_UNBAIL,
     COMMAND_TRIGGER_FIRST_RUN,
     COMMAND_BEGIN,
     COMMAND_FORCE_HARD_BAIL,
     COMMAND_SET_FLOW_MODE,
+    COMMAND_START_AUTOTUNE, // int1 is the AutoTuneBoiler
+    COMMAND_CANCEL_AUTOTUNE,
+    // float1 is added to the brew set point in normal operation. Not saved, and it lapses unless it's sent again.
+    COMMAND_SET_BREW_SET_POINT_CORRECTION,
 } SystemControllerCommandType;
 
 struct SystemControllerCommand {
@@ -0,0 +1,48 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef FIRMWARE_DELAYLINE_H
+#define FIRMWARE_DELAYLINE_H
+
+#include <cstdint>
+
+/*
+ * The last N samples in a ring, for looking back a fixed number of samples. Storage is inline, so push() and ago() are
+ * O(1) and nothing is allocated.
+ *
+ * Until N samples have been pushed, looking back further than that gives the value the line was last filled with.
+ */
+template <class T, uint16_t N> class DelayLine {
+    static_assert(N > 0, "DelayLine needs room for at least one sample");
+public:
+    void push(T value) {
+        if (++_head >= N) {
+            _head = 0;
+        }
+
+        _array[_head] = value;
+    }
+
+    // The sample pushed this many pushes ago, 0 being the latest. Anything past the end of the line is clamped to it.
+    T ago(uint16_t samples) const {
+        if (samples >= N) {
+            samples = N - 1;
+        }
+
+        return _array[_head >= samples ? _head - samples : _head + N - samples];
+    }
+
+    void fill(T value) {
+        for (auto &sample: _array) {
+            sample = value;
+        }
+    }
+
+    static constexpr uint16_t capacity() { return N; }
+private:
+    T _array[N] = {};
+    uint16_t _head = 0;
+};
+
+#endif //FIRMWARE_DELAYLINE_H
@@ -0,0 +1,57 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef FIRMWARE_EXPONENTIALMOVINGAVERAGE_H
+#define FIRMWARE_EXPONENTIALMOVINGAVERAGE_H
+
+#include <cstdint>
+#include <type_traits>
+#include "FixedPoint.h"
+
+/*
+ * Exponential moving average with a smoothing factor of 1/2^Shift, i.e. y += (x - y) / 2^Shift. Keeping the factor
+ * a power of two means the fixed point and integer versions are a subtraction and a shift, no multiply or divide.
+ *
+ * The first sample seeds the average, so there is no slow climb up from zero after a reset.
+ */
+template <class T, uint8_t Shift> class ExponentialMovingAverage {
+    static_assert(Shift < 16, "ExponentialMovingAverage smoothing factor is too small to be useful");
+public:
+    void addValue(T value) {
+        if (!_seeded) {
+            _value = value;
+            _seeded = true;
+            return;
+        }
+
+        _value = step(_value, value);
+    }
+
+    T average() const { return _value; }
+
+    void reset() {
+        _value = T();
+        _seeded = false;
+    }
+private:
+    T _value = T();
+    bool _seeded = false;
+
+    template <class U = T>
+    static typename std::enable_if<std::is_floating_point<U>::value, U>::type step(U current, U value) {
+        return current + (value - current) / (U)(1u << Shift);
+    }
+
+    template <class U = T>
+    static typename std::enable_if<std::is_integral<U>::value, U>::type step(U current, U value) {
+        return (U)(current + (((int64_t)value - current) >> Shift));
+    }
+
+    template <class U = T>
+    static typename std::enable_if<std::is_same<U, Q16_16>::value, U>::type step(U current, U value) {
+        return Q16_16::fromRaw((int32_t)(current.getRaw() + (((int64_t)value.getRaw() - current.getRaw()) >> Shift)));
+    }
+};
+
+#endif //FIRMWARE_EXPONENTIALMOVINGAVERAGE_H
@@ -0,0 +1,86 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_FIXEDPOINT_H
+#define SMART_LCC_FIXEDPOINT_H
+
+#include <cstdint>
+
+/*
+ * Signed Q16.16 fixed point number.
+ *
+ * The M0+ has no FPU, so anything on the Core0 hot path that would otherwise be float or double math goes through
+ * this instead. Products and quotients are computed in 64 bits and saturate rather than wrap. Products round to
+ * nearest, flooring them would bias anything that accumulates them, like the integral term or an RLS fit.
+ */
+class Q16_16 {
+public:
+    static constexpr int fractionalBits = 16;
+    static constexpr int32_t one = 1 << fractionalBits;
+
+    constexpr Q16_16(): raw(0) {}
+    constexpr explicit Q16_16(int value): raw(saturate((int64_t)value * one)) {}
+    constexpr explicit Q16_16(float value): raw(saturate((int64_t)(value * (float)one + (value < 0 ? -0.5f : 0.5f)))) {}
+    constexpr explicit Q16_16(double value): raw(saturate((int64_t)(value * (double)one + (value < 0 ? -0.5 : 0.5)))) {}
+
+    static constexpr Q16_16 fromRaw(int32_t raw) {
+        Q16_16 q;
+        q.raw = raw;
+        return q;
+    }
+
+    // numerator / denominator, without going through a float. Useful for time deltas in microseconds.
+    static constexpr Q16_16 fromRatio(int64_t numerator, int64_t denominator) {
+        return fromRaw(saturate((numerator * one) / denominator));
+    }
+
+    [[nodiscard]] constexpr int32_t getRaw() const { return raw; }
+
+    constexpr explicit operator float() const { return (float)raw / (float)one; }
+    constexpr explicit operator double() const { return (double)raw / (double)one; }
+
+    // Rounds half away from zero, like std::round
+    [[nodiscard]] constexpr int32_t roundToInt() const {
+        return raw >= 0 ? (raw + one / 2) >> fractionalBits : -((-raw + one / 2) >> fractionalBits);
+    }
+
+    constexpr Q16_16 operator-() const { return fromRaw(saturate(-(int64_t)raw)); }
+
+    constexpr Q16_16 operator+(Q16_16 other) const { return fromRaw(saturate((int64_t)raw + other.raw)); }
+    constexpr Q16_16 operator-(Q16_16 other) const { return fromRaw(saturate((int64_t)raw - other.raw)); }
+    constexpr Q16_16 operator*(Q16_16 other) const { return fromRaw(saturate(((int64_t)raw * other.raw + one / 2) >> fractionalBits)); }
+    constexpr Q16_16 operator/(Q16_16 other) const {
+        if (other.raw == 0) {
+            return fromRaw(raw >= 0 ? INT32_MAX : INT32_MIN);
+        }
+
+        return fromRaw(saturate(((int64_t)raw * one) / other.raw));
+    }
+
+    constexpr Q16_16& operator+=(Q16_16 other) { return *this = *this + other; }
+    constexpr Q16_16& operator-=(Q16_16 other) { return *this = *this - other; }
+    constexpr Q16_16& operator*=(Q16_16 other) { return *this = *this * other; }
+    constexpr Q16_16& operator/=(Q16_16 other) { return *this = *this / other; }
+
+    constexpr bool operator<(Q16_16 other) const { return raw < other.raw; }
+    constexpr bool operator>(Q16_16 other) const { return raw > other.raw; }
+    constexpr bool operator<=(Q16_16 other) const { return raw <= other.raw; }
+    constexpr bool operator>=(Q16_16 other) const { return raw >= other.raw; }
+    constexpr bool operator==(Q16_16 other) const { return raw == other.raw; }
+    constexpr bool operator!=(Q16_16 other) const { return raw != other.raw; }
+private:
+    int32_t raw;
+
+    static constexpr int32_t saturate(int64_t value) {
+        if (value > INT32_MAX) {
+            return INT32_MAX;
+        } else if (value < INT32_MIN) {
+            return INT32_MIN;
+        }
+
+        return (int32_t)value;
+    }
+};
+
+#endif //SMART_LCC_FIXEDPOINT_H
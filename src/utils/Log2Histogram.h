@@ -0,0 +1,40 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef FIRMWARE_LOG2HISTOGRAM_H
+#define FIRMWARE_LOG2HISTOGRAM_H
+
+#include <cstdint>
+
+/*
+ * Histogram with power of two bucket widths. Bucket 0 counts zeros, bucket n counts values in [2^(n-1), 2^n), and
+ * the last bucket also takes everything larger. With microsecond values and 16 buckets that covers everything from
+ * 1 µs to 16 ms individually, which is the interesting range for a 100 ms control cycle.
+ *
+ * Plain data, so it can be copied between cores as part of a status message.
+ */
+template <uint8_t Buckets> struct Log2Histogram {
+    static_assert(Buckets > 1 && Buckets <= 33, "Log2Histogram needs between 2 and 33 buckets");
+
+    uint32_t counts[Buckets];
+
+    static uint8_t bucketFor(uint32_t value) {
+        uint8_t bucket = value == 0 ? 0 : 32 - __builtin_clz(value);
+        return bucket < Buckets ? bucket : Buckets - 1;
+    }
+
+    void add(uint32_t value) {
+        uint8_t bucket = bucketFor(value);
+
+        // Saturate rather than wrap, a histogram that's been running for a year shouldn't suddenly look empty
+        if (counts[bucket] != UINT32_MAX) {
+            counts[bucket]++;
+        }
+    }
+
+    // Inclusive lower bound of a bucket
+    static uint32_t bucketFloor(uint8_t bucket) { return bucket == 0 ? 0 : 1u << (bucket - 1); }
+};
+
+#endif //FIRMWARE_LOG2HISTOGRAM_H
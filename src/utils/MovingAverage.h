@@ -5,60 +5,86 @@
 #ifndef FIRMWARE_MOVINGAVERAGE_H
 #define FIRMWARE_MOVINGAVERAGE_H
 
-#include <cstdlib>
+#include <cstdint>
+#include <type_traits>
+#include "FixedPoint.h"
 
-template <class T> class MovingAverage {
-public:
-    explicit MovingAverage(uint16_t num);
-    ~MovingAverage();
+/*
+ * How a MovingAverage sums and divides its samples. Integers and fixed point numbers are summed exactly in 64 bits,
+ * so the running sum never drifts no matter how many samples pass through it. Floats are summed in double, which
+ * is exact for any realistic window of similarly sized temperatures.
+ */
+template <class T, class Enable = void> struct AverageTraits;
 
-    void addValue(T);
-    double average();
-private:
-    uint16_t _limit;
-    uint16_t _head = 0;
-    T* _array;
-    bool _wrapped = false;
+template <class T> struct AverageTraits<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    typedef int64_t Accumulator;
+    typedef double Result;
+
+    static constexpr Accumulator toAccumulator(T value) { return value; }
+    static constexpr Result divide(Accumulator sum, uint16_t count) { return (double)sum / count; }
 };
 
-template<class T>
-MovingAverage<T>::MovingAverage(uint16_t num): _limit(num) {
-    _array = (T*)calloc(num, sizeof(T));
-}
+template <class T> struct AverageTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    typedef double Accumulator;
+    typedef double Result;
 
-template<class T>
-MovingAverage<T>::~MovingAverage() {
-    free(_array);
-}
+    static constexpr Accumulator toAccumulator(T value) { return value; }
+    static constexpr Result divide(Accumulator sum, uint16_t count) { return sum / count; }
+};
 
-template<class T>
-void MovingAverage<T>::addValue(T val) {
-    _array[_head++] = val;
-    if (_head >= _limit) {
-        _head = 0;
-        _wrapped = true;
-    }
-}
+template <> struct AverageTraits<Q16_16> {
+    typedef int64_t Accumulator;
+    typedef Q16_16 Result;
 
-template<class T>
-double MovingAverage<T>::average() {
-    double sum = 0.f;
+    static constexpr Accumulator toAccumulator(Q16_16 value) { return value.getRaw(); }
+    static constexpr Result divide(Accumulator sum, uint16_t count) { return Q16_16::fromRaw((int32_t)(sum / count)); }
+};
 
-    uint16_t limit = _limit;
-    if (!_wrapped) {
-        limit = _head;
-    }
+/*
+ * Simple moving average over the last N samples. Storage is inline and the sum is maintained as samples come and go,
+ * so both addValue() and average() are O(1) and nothing is allocated.
+ */
+template <class T, uint16_t N> class MovingAverage {
+    static_assert(N > 0, "MovingAverage needs room for at least one sample");
+public:
+    typedef AverageTraits<T> Traits;
+
+    void addValue(T value) {
+        if (_count == N) {
+            _sum -= Traits::toAccumulator(_array[_head]);
+        } else {
+            _count++;
+        }
+
+        _array[_head] = value;
+        _sum += Traits::toAccumulator(value);
 
-    if (limit == 0) {
-        return 0.f;
+        if (++_head >= N) {
+            _head = 0;
+        }
     }
 
-    for (uint16_t i = 0; i < limit; ++i) {
-        sum += (double)_array[i];
+    typename Traits::Result average() const {
+        if (_count == 0) {
+            return typename Traits::Result();
+        }
+
+        return Traits::divide(_sum, _count);
     }
 
-    return sum / limit;
-}
+    void reset() {
+        _head = 0;
+        _count = 0;
+        _sum = typename Traits::Accumulator();
+    }
 
+    [[nodiscard]] uint16_t count() const { return _count; }
+    static constexpr uint16_t capacity() { return N; }
+private:
+    T _array[N] = {};
+    typename Traits::Accumulator _sum = typename Traits::Accumulator();
+    uint16_t _head = 0;
+    uint16_t _count = 0;
+};
 
 #endif //FIRMWARE_MOVINGAVERAGE_H
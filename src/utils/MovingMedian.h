@@ -0,0 +1,73 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef FIRMWARE_MOVINGMEDIAN_H
+#define FIRMWARE_MOVINGMEDIAN_H
+
+#include <cstdint>
+
+/*
+ * Median of the last N samples, for rejecting single sample spikes that a mean would smear out. Alongside the ring
+ * of samples in arrival order it keeps a sorted copy, updated by removing the outgoing sample and inserting the new
+ * one. That is O(N) per sample with N compares and moves, which is nothing for the small windows this is meant for.
+ *
+ * With an even number of samples the lower of the two middle values is returned, so T needs nothing but operator<.
+ */
+template <class T, uint16_t N> class MovingMedian {
+    static_assert(N > 0, "MovingMedian needs room for at least one sample");
+public:
+    void addValue(T value) {
+        uint16_t end = _count;
+
+        if (_count == N) {
+            // Remove the sample that falls out of the window from the sorted copy
+            T outgoing = _ring[_head];
+            uint16_t i = 0;
+            while (_sorted[i] < outgoing || outgoing < _sorted[i]) {
+                i++;
+            }
+            for (; i + 1 < N; i++) {
+                _sorted[i] = _sorted[i + 1];
+            }
+            end = N - 1;
+        } else {
+            _count++;
+        }
+
+        // Insertion sort step
+        uint16_t i = end;
+        while (i > 0 && value < _sorted[i - 1]) {
+            _sorted[i] = _sorted[i - 1];
+            i--;
+        }
+        _sorted[i] = value;
+
+        _ring[_head] = value;
+        if (++_head >= N) {
+            _head = 0;
+        }
+    }
+
+    T median() const {
+        if (_count == 0) {
+            return T();
+        }
+
+        return _sorted[(_count - 1) / 2];
+    }
+
+    void reset() {
+        _head = 0;
+        _count = 0;
+    }
+
+    [[nodiscard]] uint16_t count() const { return _count; }
+private:
+    T _ring[N] = {};
+    T _sorted[N] = {};
+    uint16_t _head = 0;
+    uint16_t _count = 0;
+};
+
+#endif //FIRMWARE_MOVINGMEDIAN_H
@@ -0,0 +1,101 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef FIRMWARE_SEQLOCKMAILBOX_H
+#define FIRMWARE_SEQLOCKMAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Single writer, single reader "latest value" mailbox built on a sequence lock.
+ *
+ * The writer never waits: it bumps the sequence to an odd number, stores the value and bumps it to even again. The
+ * reader copies the value out and checks that the sequence was even and unchanged across the copy, retrying a bounded
+ * number of times if the writer got in the way. With the writer publishing every 100 ms and a copy taking a few
+ * microseconds, a retry is rare and a second one practically never happens.
+ *
+ * The value is stored as relaxed atomic words so that the overlapping copy during a collision is well defined; the
+ * sequence check is what throws those copies away. Nothing here is a read-modify-write, so it works on the M0+, which
+ * has no exclusive load/store instructions.
+ *
+ * getSequence() counts publications. The reader can use the difference between two sequences to find out how many
+ * values it never saw, and acknowledge() tells the writer side how far it has read, so that a stalled reader can be
+ * detected.
+ */
+template <class T> class SeqlockMailbox {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqlockMailbox can only carry trivially copyable types");
+public:
+    // Writer side
+    void publish(const T &value) {
+        uint32_t words[wordCount] = {};
+        memcpy(words, &value, sizeof(T));
+
+        // Rounded up to even, in case a publish never finished: main0 resets Core 1 when it lags, which can land in
+        // the middle of one, and an odd sequence at rest would have the reader turn down every value after it
+        uint32_t sequence = (_sequence.load(std::memory_order_relaxed) + 1) & ~1u;
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < wordCount; i++) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Reader side. Returns false if nothing has been published yet, or if the writer kept interfering with the copy.
+    bool tryRead(T *value, uint32_t *publication = nullptr) const {
+        uint32_t words[wordCount];
+
+        for (uint8_t attempt = 0; attempt < maxReadAttempts; attempt++) {
+            uint32_t before = _sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+
+            if (before & 1) {
+                continue;
+            }
+
+            for (size_t i = 0; i < wordCount; i++) {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == before) {
+                memcpy(value, words, sizeof(T));
+
+                if (publication != nullptr) {
+                    *publication = before / 2;
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void acknowledge(uint32_t publication) {
+        _acknowledged.store(publication, std::memory_order_relaxed);
+    }
+
+    // Number of values published so far
+    [[nodiscard]] uint32_t getSequence() const { return _sequence.load(std::memory_order_relaxed) / 2; }
+
+    // Number of publications the reader has not yet acknowledged
+    [[nodiscard]] uint32_t getReaderLag() const { return getSequence() - _acknowledged.load(std::memory_order_relaxed); }
+private:
+    static constexpr size_t wordCount = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    static constexpr uint8_t maxReadAttempts = 4;
+
+    std::atomic<uint32_t> _sequence{0};
+    std::atomic<uint32_t> _acknowledged{0};
+    std::atomic<uint32_t> _words[wordCount] = {};
+};
+
+#endif //FIRMWARE_SEQLOCKMAILBOX_H
@@ -0,0 +1,70 @@
+//
+// Created by Magnus Nordlander on 2026-10-17.
+//
+
+#ifndef SMART_LCC_CONSTEXPR_MATH_H
+#define SMART_LCC_CONSTEXPR_MATH_H
+
+/*
+ * Just enough of <cmath> to build lookup tables at compile time. These are not meant to be called at runtime.
+ */
+namespace constexpr_math {
+    constexpr double ln2 = 0.69314718055994530942;
+
+    constexpr double exp(double x) {
+        // x = n * ln(2) + r, with |r| <= ln(2) / 2, so the series converges quickly
+        int n = (int)(x / ln2 + (x >= 0 ? 0.5 : -0.5));
+        double r = x - n * ln2;
+
+        double term = 1.0;
+        double sum = 1.0;
+        for (int i = 1; i < 24; ++i) {
+            term *= r / i;
+            sum += term;
+        }
+
+        for (; n > 0; --n) {
+            sum *= 2.0;
+        }
+
+        for (; n < 0; ++n) {
+            sum /= 2.0;
+        }
+
+        return sum;
+    }
+
+    // Only defined for x > 0
+    constexpr double log(double x) {
+        // x = m * 2^e, with 0.75 <= m <= 1.5
+        int e = 0;
+        while (x > 1.5) {
+            x /= 2.0;
+            e++;
+        }
+
+        while (x < 0.75) {
+            x *= 2.0;
+            e--;
+        }
+
+        // ln(m) = 2 * atanh((m - 1) / (m + 1))
+        double y = (x - 1.0) / (x + 1.0);
+        double y2 = y * y;
+        double term = y;
+        double sum = 0.0;
+        for (int i = 1; i < 40; i += 2) {
+            sum += term / i;
+            term *= y2;
+        }
+
+        return 2.0 * sum + e * ln2;
+    }
+
+    // Only defined for base > 0
+    constexpr double pow(double base, double exponent) {
+        return exp(exponent * log(base));
+    }
+}
+
+#endif //SMART_LCC_CONSTEXPR_MATH_H